@@ -0,0 +1,71 @@
+// Launch-latency benchmark of installed yt-dlp builds: each one is run with
+// --version once with its files evicted from the page cache (cold) and then
+// repeatedly (warm), the way VRChat launches it for every video. One JSON line
+// per build, so onefile and onedir installs can be compared side by side.
+//
+//   yt_dlp_launch_bench [--runs 10] [<Tools directory or executable>...]
+//
+// Without paths the current user's VRChat Tools directory is measured.
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "asset_variant.h"
+#include "launch_latency.h"
+#include "platform.h"
+
+using json = nlohmann::json;
+namespace fs = std::filesystem;
+
+int main(int argc, char* argv[]) {
+    int runs = 10;
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--runs" && i + 1 < argc) {
+            runs = std::atoi(argv[++i]);
+        } else if (arg.compare(0, 2, "--") != 0) {
+            paths.push_back(arg);
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--runs 10] [<Tools directory or executable>...]" << std::endl;
+            return 1;
+        }
+    }
+    if (runs < 1) {
+        runs = 1;
+    }
+    if (paths.empty()) {
+        std::string toolsPath = GetVRChatToolsPath();
+        if (toolsPath.empty()) {
+            std::cerr << "Failed to get VRChat Tools directory path." << std::endl;
+            return 1;
+        }
+        paths.push_back(toolsPath);
+    }
+
+    bool ok = true;
+    for (const auto& path : paths) {
+        std::error_code ec;
+        std::string executablePath = fs::is_directory(path, ec) ? JoinPath(path, "yt-dlp.exe") : path;
+        bool oneDir = fs::is_directory(fs::path(executablePath).parent_path() / kOneDirLibraryName, ec);
+
+        LaunchLatency latency;
+        bool measured = MeasureLaunchLatency(executablePath, runs, latency);
+        ok = measured && ok;
+
+        json line = {
+            {"benchmark", "launch"},
+            {"executable", executablePath},
+            {"layout", oneDir ? "onedir" : "onefile"},
+            {"runs", runs},
+            {"ok", measured},
+            {"cold_ms", latency.coldMs},
+            {"warm_ms", latency.warmMedianMs},
+            {"warm_ms_min", latency.warmMinMs}
+        };
+        std::cout << line.dump() << std::endl;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,328 @@
+#include "mock_github.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <nlohmann/json.hpp>
+#include "mirror_server.h"
+#include "sha256.h"
+
+using json = nlohmann::json;
+namespace fs = std::filesystem;
+
+namespace {
+
+// Chunk size for throttled and truncated asset bodies
+const uint64_t kPacedChunk = 16 * 1024;
+
+std::string Lower(std::string value) {
+    std::transform(value.begin(), value.end(), value.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return value;
+}
+
+bool SendText(SocketHandle connection, const std::string& text) {
+    return SendAll(connection, text.data(), text.size());
+}
+
+// Function to parse the "first-" and "first-last" byte range forms curl sends
+// against a body of size bytes, last being clamped to the end. Returns false if
+// the range is malformed (including suffix and multiple ranges) or starts past
+// the end, which for an empty body is any range.
+bool ParseByteRange(const std::string& spec, uint64_t size, uint64_t& first, uint64_t& last) {
+    auto parseNumber = [](const char* text, const char*& end, uint64_t& value) {
+        if (!std::isdigit(static_cast<unsigned char>(*text))) {
+            return false;
+        }
+        char* parsed = nullptr;
+        errno = 0;
+        value = std::strtoull(text, &parsed, 10);
+        end = parsed;
+        return errno != ERANGE;
+    };
+
+    const char* end = nullptr;
+    if (!parseNumber(spec.c_str(), end, first) || *end != '-') {
+        return false;
+    }
+    if (end[1] == '\0') {
+        last = size > 0 ? size - 1 : 0;
+    } else if (!parseNumber(end + 1, end, last) || *end != '\0' || last < first) {
+        return false;
+    } else if (size > 0) {
+        last = std::min<uint64_t>(last, size - 1);
+    }
+    return first < size;
+}
+
+std::string Response(int status, const std::string& reason, const std::string& headers, const std::string& body) {
+    std::ostringstream out;
+    out << "HTTP/1.1 " << status << " " << reason << "\r\n" << headers
+        << "Content-Length: " << body.size() << "\r\n\r\n" << body;
+    return out.str();
+}
+
+} // namespace
+
+MockGitHubServer::MockGitHubServer(const MockGitHubOptions& options) : options_(options) {}
+
+MockGitHubServer::~MockGitHubServer() {
+    Stop();
+}
+
+bool MockGitHubServer::Start(int port) {
+    if (!StartSockets()) {
+        return false;
+    }
+    listener_ = ListenTcp("127.0.0.1", port);
+    if (listener_ == kInvalidSocket) {
+        return false;
+    }
+    port_ = LocalPort(listener_);
+    acceptThread_ = std::thread(&MockGitHubServer::AcceptLoop, this);
+    return true;
+}
+
+void MockGitHubServer::Stop() {
+    if (listener_ == kInvalidSocket) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        for (SocketHandle connection : active_) {
+            ShutdownSocket(connection);
+        }
+    }
+    ShutdownSocket(listener_);
+    acceptThread_.join();
+    for (auto& thread : connections_) {
+        thread.join();
+    }
+    connections_.clear();
+    CloseSocket(listener_);
+    listener_ = kInvalidSocket;
+}
+
+std::string MockGitHubServer::BaseUrl() const {
+    return "http://127.0.0.1:" + std::to_string(port_);
+}
+
+void MockGitHubServer::AcceptLoop() {
+    while (true) {
+        SocketHandle connection = AcceptConnection(listener_);
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_ || connection == kInvalidSocket) {
+            if (connection != kInvalidSocket) {
+                CloseSocket(connection);
+            }
+            return;
+        }
+        active_.insert(connection);
+        connections_.emplace_back([this, connection]() {
+            ServeConnection(connection);
+            std::lock_guard<std::mutex> lock(mutex_);
+            active_.erase(connection);
+            CloseSocket(connection);
+        });
+    }
+}
+
+void MockGitHubServer::ServeConnection(SocketHandle connection) {
+    std::string buffer;
+    char chunk[4096];
+    while (true) {
+        size_t headEnd;
+        while ((headEnd = buffer.find("\r\n\r\n")) == std::string::npos) {
+            long received = ReceiveSome(connection, chunk, sizeof(chunk));
+            if (received <= 0) {
+                return;
+            }
+            buffer.append(chunk, static_cast<size_t>(received));
+        }
+
+        std::istringstream head(buffer.substr(0, headEnd));
+        buffer.erase(0, headEnd + 4);
+        std::string method;
+        std::string path;
+        head >> method >> path;
+        std::map<std::string, std::string> headers;
+        std::string line;
+        std::getline(head, line);
+        while (std::getline(head, line)) {
+            size_t colon = line.find(':');
+            if (colon != std::string::npos) {
+                std::string value = line.substr(colon + 1);
+                value.erase(0, value.find_first_not_of(" \t"));
+                if (!value.empty() && value.back() == '\r') {
+                    value.pop_back();
+                }
+                headers[Lower(line.substr(0, colon))] = value;
+            }
+        }
+        ++requests_;
+
+        if (options_.latencyMs > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(options_.latencyMs));
+        }
+
+        bool headOnly = method == "HEAD";
+        bool keepOpen = true;
+        bool ok;
+        if (path == kLatestReleasePath) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                lastReleaseHeaders_ = headers;
+            }
+            std::string etag = "\"" + options_.tag + "-" + options_.sha256.substr(0, 16) + "\"";
+            std::string rateHeaders = "X-RateLimit-Limit: 60\r\nX-RateLimit-Remaining: 59\r\nX-RateLimit-Reset: " +
+                std::to_string(std::time(nullptr) + 3600) + "\r\nETag: " + etag + "\r\nLast-Modified: " +
+                options_.releaseLastModified + "\r\n";
+            if (headers["if-none-match"] == etag) {
+                ++notModified_;
+                ok = SendText(connection, Response(304, "Not Modified", rateHeaders, ""));
+            } else {
+                std::string base = BaseUrl() + "/releases/download/" + options_.tag + "/";
+                json release = {
+                    {"tag_name", options_.tag},
+                    {"assets", json::array({
+                        {{"name", options_.assetName}, {"browser_download_url", base + options_.assetName}},
+                        {{"name", "SHA2-256SUMS"}, {"browser_download_url", base + "SHA2-256SUMS"}}
+                    })}
+                };
+                std::string body = headOnly ? "" : release.dump();
+                ok = SendText(connection, Response(200, "OK", rateHeaders + "Content-Type: application/json\r\n", body));
+            }
+        } else if (path.compare(0, 19, "/releases/download/") == 0) {
+            std::string asset = path.substr(path.rfind('/') + 1);
+            ok = SendText(connection, Response(302, "Found", "Location: " + BaseUrl() + "/objects/" + asset + "\r\n", ""));
+        } else if (path == "/objects/SHA2-256SUMS") {
+            std::string body = options_.sha256 + "  " + options_.assetName + "\n";
+            ok = SendText(connection, Response(200, "OK", "", headOnly ? "" : body));
+        } else if (path == "/objects/" + options_.assetName) {
+            ok = SendAsset(connection, headOnly, headers["range"], keepOpen);
+        } else {
+            ok = SendText(connection, Response(404, "Not Found", "", ""));
+        }
+
+        if (!ok || !keepOpen) {
+            return;
+        }
+    }
+}
+
+std::string MockGitHubServer::LastReleaseHeader(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto header = lastReleaseHeaders_.find(name);
+    return header != lastReleaseHeaders_.end() ? header->second : "";
+}
+
+std::vector<std::string> MockGitHubServer::AssetRanges() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return assetRanges_;
+}
+
+bool MockGitHubServer::SendAsset(SocketHandle connection, bool head, const std::string& range, bool& keepOpen) {
+    std::error_code ec;
+    uint64_t size = fs::file_size(options_.payloadPath, ec);
+    if (ec) {
+        return SendText(connection, Response(500, "Internal Server Error", "", ""));
+    }
+
+    // Other units are ignored, as HTTP allows; a byte range that's malformed or
+    // past the end is refused
+    uint64_t first = 0;
+    uint64_t last = 0;
+    bool partial = !options_.ignoreRanges && range.compare(0, 6, "bytes=") == 0;
+    if (partial && !ParseByteRange(range.substr(6), size, first, last)) {
+        return SendText(connection, Response(416, "Range Not Satisfiable", "Content-Range: bytes */" + std::to_string(size) + "\r\n", ""));
+    }
+
+    uint64_t length = partial ? last - first + 1 : size;
+    std::ostringstream response;
+    response << "HTTP/1.1 " << (partial ? "206 Partial Content" : "200 OK") << "\r\n"
+             << "Accept-Ranges: bytes\r\n";
+    if (options_.assetLastModified.empty()) {
+        response << "ETag: \"" << options_.sha256 << "\"\r\n";
+    } else {
+        response << "Last-Modified: " << options_.assetLastModified << "\r\n";
+    }
+    response << "Content-Length: " << length << "\r\n";
+    if (partial) {
+        response << "Content-Range: bytes " << first << "-" << last << "/" << size << "\r\n";
+    }
+    response << "\r\n";
+    if (!SendText(connection, response.str())) {
+        return false;
+    }
+    if (head) {
+        return true;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        assetRanges_.push_back(range);
+    }
+
+    // Every Nth body is cut short and the connection dropped
+    uint64_t body = ++assetBodies_;
+    uint64_t toSend = length;
+    if ((options_.dropEvery > 0 && body % static_cast<uint64_t>(options_.dropEvery) == 0) ||
+        (!options_.dropRange.empty() && range == options_.dropRange)) {
+        toSend = std::min<uint64_t>(length, options_.dropAfter);
+        keepOpen = false;
+        ++dropped_;
+    }
+
+    if (options_.bytesPerSecond == 0 && keepOpen) {
+        return SendFileRange(connection, options_.payloadPath, first, toSend);
+    }
+
+    // Paced (or truncated) body: chunks on a schedule derived from the bandwidth
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t sent = 0; sent < toSend;) {
+        uint64_t chunk = std::min<uint64_t>(kPacedChunk, toSend - sent);
+        if (!SendFileRange(connection, options_.payloadPath, first + sent, chunk)) {
+            return false;
+        }
+        sent += chunk;
+        if (options_.bytesPerSecond > 0) {
+            std::this_thread::sleep_until(start + std::chrono::microseconds(sent * 1000000 / options_.bytesPerSecond));
+        }
+    }
+    return keepOpen;
+}
+
+bool WriteMockPayload(const std::string& path, uint64_t size) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    uint32_t state = 2463534242u;
+    std::string block(64 * 1024, '\0');
+    for (uint64_t written = 0; written < size && file;) {
+        for (auto& byte : block) {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            byte = static_cast<char>(state);
+        }
+        uint64_t length = std::min<uint64_t>(block.size(), size - written);
+        file.write(block.data(), static_cast<std::streamsize>(length));
+        written += length;
+    }
+    return static_cast<bool>(file);
+}
+
+bool HashMockPayload(const std::string& path, uint64_t& size, std::string& sha256) {
+    std::error_code ec;
+    size = fs::file_size(path, ec);
+    if (ec) {
+        return false;
+    }
+    DownloadHasher hasher(path);
+    return hasher.Finish(static_cast<curl_off_t>(size), sha256);
+}
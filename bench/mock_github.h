@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include "socket.h"
+
+// How the mock misbehaves
+struct MockGitHubOptions {
+    std::string payloadPath;            // file served as the release asset
+    std::string sha256;                 // its hash, for SHA2-256SUMS
+    std::string assetName = "yt-dlp.exe"; // e.g. yt-dlp.exe.zip to serve an archive
+    std::string tag = "2026.01.01";
+    std::string assetLastModified;      // asset validator sent instead of its ETag when set
+    std::string releaseLastModified = "Thu, 01 Jan 2026 00:00:00 GMT"; // Last-Modified of the release JSON
+    int latencyMs = 0;                  // delay before every response
+    uint64_t bytesPerSecond = 0;        // asset bandwidth per connection, 0 = unlimited
+    int dropEvery = 0;                  // cut every Nth asset body short, 0 = never
+    uint64_t dropAfter = 256 * 1024;    // bytes sent before a cut
+    std::string dropRange;              // also cut every body requested with exactly this Range header
+    bool ignoreRanges = false;          // answer Range requests with the whole asset while still advertising ranges
+};
+
+// Local stand-in for api.github.com and its asset CDN:
+//   /repos/yt-dlp/yt-dlp/releases/latest       release JSON, ETag, 304, rate limit headers
+//   /releases/download/<tag>/<asset>           302 to /objects/<asset>, like GitHub's asset links
+//   /objects/<asset>, /objects/SHA2-256SUMS    the bytes, with Range support
+// One thread per connection; good enough for benchmarks, not for production.
+class MockGitHubServer {
+public:
+    explicit MockGitHubServer(const MockGitHubOptions& options);
+    ~MockGitHubServer();
+
+    MockGitHubServer(const MockGitHubServer&) = delete;
+    MockGitHubServer& operator=(const MockGitHubServer&) = delete;
+
+    // Start on 127.0.0.1:port (0 picks a free port)
+    bool Start(int port = 0);
+    void Stop();
+
+    // Base URL to use as --mirror / API base, e.g. http://127.0.0.1:12345
+    std::string BaseUrl() const;
+
+    uint64_t Requests() const { return requests_; }
+    uint64_t DroppedResponses() const { return dropped_; }
+    uint64_t NotModifiedResponses() const { return notModified_; }
+
+    // Function to get a request header (lowercase name) of the latest release
+    // request, "" if it had none
+    std::string LastReleaseHeader(const std::string& name);
+
+    // Function to get the Range header of every asset body request so far, in
+    // order ("" for a request without one)
+    std::vector<std::string> AssetRanges();
+
+private:
+    void AcceptLoop();
+    void ServeConnection(SocketHandle connection);
+    bool SendAsset(SocketHandle connection, bool head, const std::string& range, bool& keepOpen);
+
+    MockGitHubOptions options_;
+    SocketHandle listener_ = kInvalidSocket;
+    int port_ = 0;
+    std::thread acceptThread_;
+
+    std::mutex mutex_;
+    std::vector<std::thread> connections_;
+    std::set<SocketHandle> active_;
+    bool stopping_ = false;
+
+    std::atomic<uint64_t> requests_{0};
+    std::atomic<uint64_t> assetBodies_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<uint64_t> notModified_{0};
+    std::map<std::string, std::string> lastReleaseHeaders_;  // guarded by mutex_
+    std::vector<std::string> assetRanges_;                   // guarded by mutex_
+};
+
+// Function to write size bytes of deterministic, incompressible data to use as a payload
+bool WriteMockPayload(const std::string& path, uint64_t size);
+
+// Function to get a payload's size and SHA-256 for MockGitHubOptions
+bool HashMockPayload(const std::string& path, uint64_t& size, std::string& sha256);
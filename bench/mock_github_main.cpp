@@ -0,0 +1,93 @@
+// Stand-alone mock GitHub server, for trying the updater against slow, throttled
+// or flaky links by hand:
+//   yt_dlp_mock_github --size 16 --latency 100 --throttle 512 --drop-every 3
+//   yt_dlp_updater --mirror http://127.0.0.1:<port> --target <dir> --non-interactive
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include "mock_github.h"
+#include "platform.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+void PrintMockUsage(const char* program) {
+    std::cout << "Usage: " << program << " [options]\n"
+              << "  --port <n>          port to listen on (default 8081, 0 = any)\n"
+              << "  --file <path>       serve this file as the asset\n"
+              << "  --asset <name>      asset name (default yt-dlp.exe, e.g. yt-dlp.exe.zip)\n"
+              << "  --size <MiB>        or generate a payload of this size (default 16)\n"
+              << "  --tag <tag>         release tag to report (default 2026.01.01)\n"
+              << "  --latency <ms>      delay before every response\n"
+              << "  --throttle <KiB/s>  asset bandwidth per connection\n"
+              << "  --drop-every <n>    cut every nth asset body short\n"
+              << "  --drop-after <KiB>  bytes sent before a cut (default 256)\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    MockGitHubOptions options;
+    int port = 8081;
+    uint64_t sizeMiB = 16;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            PrintMockUsage(argv[0]);
+            return 1;
+        }
+        std::string value = argv[++i];
+        if (arg == "--port") {
+            port = std::atoi(value.c_str());
+        } else if (arg == "--file") {
+            options.payloadPath = value;
+        } else if (arg == "--size") {
+            sizeMiB = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (arg == "--asset") {
+            options.assetName = value;
+        } else if (arg == "--tag") {
+            options.tag = value;
+        } else if (arg == "--latency") {
+            options.latencyMs = std::atoi(value.c_str());
+        } else if (arg == "--throttle") {
+            options.bytesPerSecond = std::strtoull(value.c_str(), nullptr, 10) * 1024;
+        } else if (arg == "--drop-every") {
+            options.dropEvery = std::atoi(value.c_str());
+        } else if (arg == "--drop-after") {
+            options.dropAfter = std::strtoull(value.c_str(), nullptr, 10) * 1024;
+        } else {
+            PrintMockUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (options.payloadPath.empty()) {
+        options.payloadPath = (fs::temp_directory_path() / "yt-dlp-mock-payload.exe").string();
+        if (!WriteMockPayload(options.payloadPath, sizeMiB * 1024 * 1024)) {
+            std::cerr << "Failed to write payload: " << options.payloadPath << std::endl;
+            return 1;
+        }
+    }
+    uint64_t size = 0;
+    if (!HashMockPayload(options.payloadPath, size, options.sha256)) {
+        std::cerr << "Failed to hash payload: " << options.payloadPath << std::endl;
+        return 1;
+    }
+
+    MockGitHubServer server(options);
+    if (!InstallShutdownHandler() || !server.Start(port)) {
+        std::cerr << "Failed to start mock server on port " << port << std::endl;
+        return 1;
+    }
+    std::cout << "Mock GitHub serving " << options.payloadPath << " (" << size << " bytes, " << options.tag
+              << ") at " << server.BaseUrl() << std::endl;
+
+    while (!WaitForShutdown(std::chrono::hours(1))) {
+    }
+    server.Stop();
+    std::cout << server.Requests() << " requests, " << server.DroppedResponses() << " dropped" << std::endl;
+    return 0;
+}
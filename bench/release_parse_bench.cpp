@@ -0,0 +1,138 @@
+// Micro-benchmark of the release JSON extraction: the streaming SAX extractor
+// against buffering the whole body and building a DOM, on a fixture shaped like
+// the GitHub releases/latest response. Results are printed as JSON lines.
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <new>
+#include <streambuf>
+#include <string>
+#include "release_parser.h"
+
+namespace {
+
+// Heap accounting for peak memory, fed by the replaced global operator new/delete
+size_t g_currentHeap = 0;
+size_t g_peakHeap = 0;
+
+// Size of the chunks curl typically hands to a write callback
+const size_t kChunkSize = 16 * 1024;
+
+// Streambuf that hands out an in-memory body in network-sized chunks, the way
+// CurlStreamBuf does, and counts how much of it was requested
+class ChunkedStreamBuf : public std::streambuf {
+public:
+    explicit ChunkedStreamBuf(const std::string& body) : body_(body) {}
+
+    size_t BytesDelivered() const { return offset_; }
+
+protected:
+    int_type underflow() override {
+        if (offset_ >= body_.size()) {
+            return traits_type::eof();
+        }
+        size_t length = std::min(kChunkSize, body_.size() - offset_);
+        chunk_.assign(body_.data() + offset_, length);
+        offset_ += length;
+        setg(&chunk_[0], &chunk_[0], &chunk_[0] + chunk_.size());
+        return traits_type::to_int_type(*gptr());
+    }
+
+private:
+    const std::string& body_;
+    std::string chunk_;
+    size_t offset_ = 0;
+};
+
+// The pre-streaming path: append every chunk to a string, then parse a DOM
+bool RunDom(const std::string& body, size_t& bytesRead) {
+    std::string response;
+    for (size_t offset = 0; offset < body.size(); offset += kChunkSize) {
+        response.append(body, offset, kChunkSize);
+    }
+    bytesRead = response.size();
+
+    ReleaseFields fields;
+    return ExtractReleaseInfoDom(response, {"yt-dlp.exe"}, fields);
+}
+
+bool RunSax(const std::string& body, size_t& bytesRead) {
+    ChunkedStreamBuf buffer(body);
+    std::istream stream(&buffer);
+
+    ReleaseFields fields;
+    bool ok = ExtractReleaseInfo(stream, {"yt-dlp.exe"}, fields);
+    bytesRead = buffer.BytesDelivered();
+    return ok;
+}
+
+void Report(const char* name, const std::string& body, int iterations, bool (*run)(const std::string&, size_t&)) {
+    size_t bytesRead = 0;
+
+    // Peak heap of a single run, measured separately from the timed loop
+    g_peakHeap = g_currentHeap;
+    size_t baseline = g_currentHeap;
+    if (!run(body, bytesRead)) {
+        std::cerr << name << ": extraction failed" << std::endl;
+        std::exit(1);
+    }
+    size_t peakHeap = g_peakHeap - baseline;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        run(body, bytesRead);
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    double nsPerOp = std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+
+    std::cout << "{\"benchmark\":\"" << name << "\",\"iterations\":" << iterations
+              << ",\"ns_per_op\":" << static_cast<long long>(nsPerOp)
+              << ",\"peak_heap_bytes\":" << peakHeap
+              << ",\"body_bytes\":" << body.size()
+              << ",\"bytes_read\":" << bytesRead << "}" << std::endl;
+}
+
+} // namespace
+
+void* operator new(size_t size) {
+    size_t* block = static_cast<size_t*>(std::malloc(size + sizeof(size_t)));
+    if (!block) {
+        throw std::bad_alloc();
+    }
+    *block = size;
+    g_currentHeap += size;
+    g_peakHeap = std::max(g_peakHeap, g_currentHeap);
+    return block + 1;
+}
+
+void operator delete(void* pointer) noexcept {
+    if (!pointer) {
+        return;
+    }
+    size_t* block = static_cast<size_t*>(pointer) - 1;
+    g_currentHeap -= *block;
+    std::free(block);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+    operator delete(pointer);
+}
+
+int main(int argc, char* argv[]) {
+    std::string fixturePath = argc > 1 ? argv[1] : YT_DLP_BENCH_FIXTURE_DIR "/release_latest.json";
+    int iterations = argc > 2 ? std::atoi(argv[2]) : 2000;
+
+    std::ifstream file(fixturePath, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open fixture: " << fixturePath << std::endl;
+        return 1;
+    }
+    std::string body((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    Report("release_parse_dom", body, iterations, RunDom);
+    Report("release_parse_sax", body, iterations, RunSax);
+    return 0;
+}
@@ -0,0 +1,434 @@
+// End-to-end benchmark of the check-and-update flow against the in-process mock
+// GitHub server: FetchLatestReleaseInfo (cold and 304), DownloadFile, the full
+// UpdateYtDlp install and a first run of CheckForUpdate with the yt-dlp.conf
+// prompt before it and alongside it, across payload sizes and simulated
+// latencies, plus a throttled and a flaky link. One JSON line per scenario with the median wall
+// time, throughput, peak RSS and syscall counts, so runs can be diffed between
+// commits.
+//
+//   yt_dlp_update_bench [--sizes 1,16] [--latencies 0,50] [--iterations 3]
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "asset_variant.h"
+#include "download.h"
+#include "mirror_server.h"
+#include "mock_github.h"
+#include "platform.h"
+#include "transfer_context.h"
+#include "updater.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// How long the simulated user takes to answer the browser prompt
+const std::chrono::milliseconds kPromptTime(500);
+
+// Resource usage of one timed call
+struct Usage {
+    long long peakRssKb = -1;
+    long long syscalls = -1;
+    long long contextSwitches = -1;
+};
+
+// Counts syscalls made by this thread and the threads it starts (curl's
+// resolver, task graph workers), using the raw_syscalls:sys_enter tracepoint
+// when perf allows it. Otherwise only read/write calls can be counted, from the
+// kernel's per-process counters, which take in every thread including the
+// in-process mock server; those are reported as read_write_syscalls so they
+// aren't compared with full syscall counts.
+class SyscallCounter {
+public:
+    SyscallCounter() {
+#ifdef __linux__
+        std::ifstream idFile("/sys/kernel/tracing/events/raw_syscalls/sys_enter/id");
+        if (!idFile.is_open()) {
+            idFile.open("/sys/kernel/debug/tracing/events/raw_syscalls/sys_enter/id");
+        }
+        long long id = -1;
+        if (idFile >> id) {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = PERF_TYPE_TRACEPOINT;
+            attr.config = static_cast<uint64_t>(id);
+            attr.disabled = 1;
+            attr.inherit = 1;
+            fd_ = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+        }
+        if (fd_ >= 0) {
+            source_ = "perf_tracepoint";
+        } else if (std::ifstream("/proc/self/io").is_open()) {
+            source_ = "proc_io_read_write";
+            field_ = "read_write_syscalls";
+        }
+#endif
+    }
+
+    ~SyscallCounter() {
+#ifdef __linux__
+        if (fd_ >= 0) {
+            close(fd_);
+        }
+#endif
+    }
+
+    const char* Source() const { return source_; }
+
+    // Name of the JSON field the count goes in
+    const char* Field() const { return field_; }
+
+    void Start() {
+#ifdef __linux__
+        if (fd_ >= 0) {
+            ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+        } else {
+            start_ = ReadProcIo();
+        }
+#endif
+    }
+
+    long long Stop() {
+#ifdef __linux__
+        if (fd_ >= 0) {
+            ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+            uint64_t count = 0;
+            if (read(fd_, &count, sizeof(count)) == static_cast<ssize_t>(sizeof(count))) {
+                return static_cast<long long>(count);
+            }
+            return -1;
+        }
+        long long now = ReadProcIo();
+        return now < 0 || start_ < 0 ? -1 : now - start_;
+#else
+        return -1;
+#endif
+    }
+
+private:
+    // syscr + syscw of the whole process, threads that have exited included
+    static long long ReadProcIo() {
+        std::ifstream io("/proc/self/io");
+        std::string key;
+        long long value = 0;
+        long long total = -1;
+        while (io >> key >> value) {
+            if (key == "syscr:" || key == "syscw:") {
+                total = (total < 0 ? 0 : total) + value;
+            }
+        }
+        return total;
+    }
+
+    int fd_ = -1;
+    long long start_ = -1;
+    const char* source_ = "none";
+    const char* field_ = "syscalls";
+};
+
+// Function to reset the peak RSS high-water mark where the OS allows it
+void ResetPeakRss() {
+#ifdef __linux__
+    std::ofstream("/proc/self/clear_refs") << "5";
+#endif
+}
+
+long long PeakRssKb() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return static_cast<long long>(counters.PeakWorkingSetSize / 1024);
+    }
+    return -1;
+#else
+#ifdef __linux__
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, 6, "VmHWM:") == 0) {
+            return std::atoll(line.c_str() + 6);
+        }
+    }
+#endif
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+#endif
+}
+
+long long ContextSwitches() {
+#if defined(__linux__)
+    rusage usage;
+    getrusage(RUSAGE_THREAD, &usage);
+    return usage.ru_nvcsw + usage.ru_nivcsw;
+#elif !defined(_WIN32)
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_nvcsw + usage.ru_nivcsw;
+#else
+    return -1;
+#endif
+}
+
+// Silences the updater's progress and error output while a scenario runs
+class MuteOutput {
+public:
+    MuteOutput() : out_(std::cout.rdbuf(sink_.rdbuf())), err_(std::cerr.rdbuf(sink_.rdbuf())) {}
+    ~MuteOutput() {
+        std::cout.rdbuf(out_);
+        std::cerr.rdbuf(err_);
+    }
+
+private:
+    std::ostringstream sink_;
+    std::streambuf* out_;
+    std::streambuf* err_;
+};
+
+SyscallCounter* g_syscalls = nullptr;
+
+// Function to run a scenario iterations times (setup untimed before each run)
+// and print its JSON line
+void RunScenario(const std::string& name, uint64_t sizeBytes, const MockGitHubOptions& mock, int iterations,
+                 const std::function<void()>& setup, const std::function<bool()>& run) {
+    std::vector<double> wallMs;
+    Usage worst;
+    bool ok = true;
+    for (int i = 0; i < iterations; ++i) {
+        setup();
+        ResetPeakRss();
+        long long switchesBefore = ContextSwitches();
+        g_syscalls->Start();
+        auto start = std::chrono::steady_clock::now();
+        bool succeeded;
+        {
+            MuteOutput mute;
+            succeeded = run();
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        long long syscalls = g_syscalls->Stop();
+        long long switches = ContextSwitches();
+        ok = ok && succeeded;
+        wallMs.push_back(std::chrono::duration<double, std::milli>(elapsed).count());
+        worst.peakRssKb = std::max(worst.peakRssKb, PeakRssKb());
+        worst.syscalls = std::max(worst.syscalls, syscalls);
+        if (switchesBefore >= 0 && switches >= 0) {
+            worst.contextSwitches = std::max(worst.contextSwitches, switches - switchesBefore);
+        }
+    }
+
+    std::sort(wallMs.begin(), wallMs.end());
+    double median = wallMs[wallMs.size() / 2];
+    double throughput = median > 0 ? (sizeBytes / (1024.0 * 1024.0)) / (median / 1000.0) : 0;
+
+    std::ostringstream line;
+    line.setf(std::ios::fixed);
+    line.precision(3);
+    line << "{\"benchmark\":\"" << name << "\",\"size_bytes\":" << sizeBytes
+         << ",\"latency_ms\":" << mock.latencyMs << ",\"throttle_bytes_per_s\":" << mock.bytesPerSecond
+         << ",\"drop_every\":" << mock.dropEvery << ",\"iterations\":" << iterations
+         << ",\"ok\":" << (ok ? "true" : "false") << ",\"wall_ms\":" << median
+         << ",\"wall_ms_min\":" << wallMs.front() << ",\"wall_ms_max\":" << wallMs.back()
+         << ",\"throughput_mib_s\":" << throughput << ",\"peak_rss_kb\":" << worst.peakRssKb
+         << ",\"" << g_syscalls->Field() << "\":" << worst.syscalls << ",\"syscalls_source\":\"" << g_syscalls->Source()
+         << "\",\"context_switches\":" << worst.contextSwitches << "}";
+    std::cout << line.str() << std::endl;
+}
+
+std::vector<uint64_t> ParseList(const std::string& value) {
+    std::vector<uint64_t> values;
+    std::stringstream stream(value);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        values.push_back(std::strtoull(item.c_str(), nullptr, 10));
+    }
+    return values;
+}
+
+void RemoveTree(const std::string& path) {
+    std::error_code ec;
+    if (!fs::exists(path, ec)) {
+        return;
+    }
+    MuteOutput mute;
+    for (const auto& entry : fs::recursive_directory_iterator(path, ec)) {
+        if (entry.is_regular_file(ec)) {
+            RemoveReadOnlyAttribute(entry.path().string());
+        }
+    }
+    fs::remove_all(path, ec);
+}
+
+// Function to benchmark every scenario of one mock configuration
+bool RunSuite(const MockGitHubOptions& mock, uint64_t sizeBytes, int iterations, bool downloadOnly, const std::string& label,
+              const std::string& workDir) {
+    MockGitHubServer server(mock);
+    if (!server.Start()) {
+        std::cerr << "Failed to start the mock server" << std::endl;
+        return false;
+    }
+
+    std::string apiUrl = server.BaseUrl() + kLatestReleasePath;
+    std::string cachePath = JoinPath(workDir, "release.json");
+    std::string downloadUrl;
+    std::string tag;
+    std::string checksumsUrl;
+    RateLimit rateLimit;
+    auto fetch = [&]() { return FetchLatestReleaseInfo(apiUrl, cachePath, AssetVariants().front().assetNames, downloadUrl, tag, checksumsUrl, rateLimit); };
+    auto noSetup = []() {};
+
+    // Each suite's server has its own port, so start without the previous suite's cached URLs
+    {
+        MuteOutput mute;
+        fs::remove(cachePath);
+        if (!fetch()) {
+            std::cerr << "The mock server did not answer the release request" << std::endl;
+            return false;
+        }
+    }
+
+    if (!downloadOnly) {
+        RunScenario("fetch_release_cold", 0, mock, iterations, [&]() { fs::remove(cachePath); }, fetch);
+        RunScenario("fetch_release_304", 0, mock, iterations, noSetup, fetch);
+    }
+
+    std::string outputPath = JoinPath(workDir, "yt-dlp.exe");
+    auto clearOutput = [&]() {
+        std::error_code ec;
+        fs::remove(outputPath, ec);
+        fs::remove(outputPath + ".tmp", ec);
+        fs::remove(outputPath + ".tmp.resume", ec);
+    };
+    RunScenario("download_file" + label, sizeBytes, mock, iterations, clearOutput,
+                [&]() { return DownloadFile(downloadUrl, outputPath, mock.sha256); });
+    clearOutput();
+
+    if (!downloadOnly) {
+        std::string toolsPath = JoinPath(workDir, "Tools");
+        RunScenario("update_full", sizeBytes, mock, iterations,
+                    [&]() {
+                        RemoveTree(toolsPath);
+                        fs::create_directories(toolsPath);
+                    },
+                    [&]() { return UpdateYtDlp(toolsPath, downloadUrl, tag, mock.sha256, ""); });
+        
+        // A first run: yt-dlp.conf is created after a prompt, then the release
+        // is installed, once in that order and once with the two overlapped
+        UpdaterOptions options;
+        options.apiBaseUrl = server.BaseUrl();
+        options.nonInteractive = true;
+        std::vector<std::string> targets = {toolsPath};
+        auto freshTools = [&]() {
+            RemoveTree(toolsPath);
+            fs::create_directories(toolsPath);
+        };
+        auto prompt = [&]() {
+            std::this_thread::sleep_for(kPromptTime);
+            std::string browser = "firefox";
+            return ConfigureYtDlp(toolsPath, browser, false);
+        };
+        RunScenario("first_run_sequential", sizeBytes, mock, iterations, freshTools, [&]() {
+            bool updated = false;
+            RateLimit checkRateLimit;
+            return prompt() && CheckForUpdate(options, targets, updated, checkRateLimit) && updated;
+        });
+        RunScenario("first_run_overlapped", sizeBytes, mock, iterations, freshTools, [&]() {
+            bool updated = false;
+            RateLimit checkRateLimit;
+            return CheckForUpdate(options, targets, updated, checkRateLimit, prompt) && updated;
+        });
+        RemoveTree(toolsPath);
+    }
+
+    server.Stop();
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::vector<uint64_t> sizesMiB = {1, 16};
+    std::vector<uint64_t> latencies = {0, 50};
+    int iterations = 3;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        if (arg == "--sizes") {
+            sizesMiB = ParseList(argv[i + 1]);
+        } else if (arg == "--latencies") {
+            latencies = ParseList(argv[i + 1]);
+        } else if (arg == "--iterations") {
+            iterations = std::max(1, std::atoi(argv[i + 1]));
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--sizes 1,16] [--latencies 0,50] [--iterations 3]" << std::endl;
+            return 1;
+        }
+    }
+
+    std::string workDir = (fs::temp_directory_path() / "yt-dlp-update-bench").string();
+    RemoveTree(workDir);
+    fs::create_directories(workDir);
+
+    if (!InitTransfers(TransferOptions())) {
+        return 1;
+    }
+    SyscallCounter syscalls;
+    g_syscalls = &syscalls;
+
+    bool ok = true;
+    for (uint64_t sizeMiB : sizesMiB) {
+        MockGitHubOptions mock;
+        mock.payloadPath = JoinPath(workDir, "payload-" + std::to_string(sizeMiB) + ".exe");
+        uint64_t sizeBytes = 0;
+        if (!WriteMockPayload(mock.payloadPath, sizeMiB * 1024 * 1024) ||
+            !HashMockPayload(mock.payloadPath, sizeBytes, mock.sha256)) {
+            std::cerr << "Failed to create payload: " << mock.payloadPath << std::endl;
+            ok = false;
+            break;
+        }
+
+        for (uint64_t latency : latencies) {
+            mock.latencyMs = static_cast<int>(latency);
+            ok = RunSuite(mock, sizeBytes, iterations, false, "", workDir) && ok;
+        }
+
+        // Degraded links, at the smallest latency
+        MockGitHubOptions throttled = mock;
+        throttled.latencyMs = static_cast<int>(latencies.front());
+        throttled.bytesPerSecond = 8 * 1024 * 1024;
+        ok = RunSuite(throttled, sizeBytes, iterations, true, "_throttled", workDir) && ok;
+
+        MockGitHubOptions flaky = throttled;
+        flaky.bytesPerSecond = 0;
+        flaky.dropEvery = 3;
+        ok = RunSuite(flaky, sizeBytes, iterations, true, "_flaky", workDir) && ok;
+    }
+
+    CleanupTransfers();
+    RemoveTree(workDir);
+    return ok ? 0 : 1;
+}
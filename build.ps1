@@ -76,7 +76,7 @@ if ($null -eq $vcpkgPath) {
 }
 
 # Install required packages via vcpkg if not already installed
-$packages = @("curl:x64-windows-static", "openssl:x64-windows-static", "zlib:x64-windows-static", "nlohmann-json:x64-windows-static")
+$packages = @("curl:x64-windows-static", "openssl:x64-windows-static", "zlib:x64-windows-static", "nlohmann-json:x64-windows-static", "sqlite3:x64-windows-static")
 
 foreach ($package in $packages) {
     if (-not (Test-VcpkgPackageInstalled $package)) {
@@ -0,0 +1,424 @@
+#include "archive_stream.h"
+
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <sstream>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const uint32_t kLocalHeaderSignature = 0x04034b50;
+const uint32_t kDescriptorSignature = 0x08074b50;
+const uint32_t kCentralHeaderSignature = 0x02014b50;
+const uint32_t kEndOfCentralSignature = 0x06054b50;
+const uint32_t kZip64EndOfCentralSignature = 0x06064b50;
+const size_t kLocalHeaderSize = 30;
+const uint16_t kZip64ExtraId = 0x0001;
+
+// General purpose flag bits
+const uint16_t kFlagEncrypted = 0x0001;
+const uint16_t kFlagDescriptor = 0x0008;
+
+// Compression methods
+const uint16_t kMethodStored = 0;
+const uint16_t kMethodDeflated = 8;
+
+// Inflate output buffer
+const size_t kInflateChunk = 64 * 1024;
+
+uint16_t Read16(const std::string& bytes, size_t offset) {
+    return static_cast<uint16_t>(static_cast<unsigned char>(bytes[offset]) |
+                                 static_cast<unsigned char>(bytes[offset + 1]) << 8);
+}
+
+uint32_t Read32(const std::string& bytes, size_t offset) {
+    return static_cast<uint32_t>(Read16(bytes, offset)) | static_cast<uint32_t>(Read16(bytes, offset + 2)) << 16;
+}
+
+uint64_t Read64(const std::string& bytes, size_t offset) {
+    return static_cast<uint64_t>(Read32(bytes, offset)) | static_cast<uint64_t>(Read32(bytes, offset + 4)) << 32;
+}
+
+// Function to move bytes from data into pending until it holds wanted bytes,
+// returns true once it does
+bool Collect(std::string& pending, size_t wanted, const char*& data, size_t& length) {
+    size_t take = std::min(length, wanted - std::min(wanted, pending.size()));
+    pending.append(data, take);
+    data += take;
+    length -= take;
+    return pending.size() >= wanted;
+}
+
+bool EndsWith(const std::string& value, const std::string& suffix) {
+    return value.size() >= suffix.size() && value.compare(value.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+} // namespace
+
+ArchiveFormat ArchiveFormatFor(const std::string& assetName) {
+    std::string lower = assetName;
+    std::transform(lower.begin(), lower.end(), lower.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    if (EndsWith(lower, ".zip")) {
+        return ArchiveFormat::Zip;
+    }
+    if (EndsWith(lower, ".gz")) {
+        return ArchiveFormat::Gzip;
+    }
+    return ArchiveFormat::None;
+}
+
+bool SafeArchivePath(const std::string& entryName, std::string& relativePath) {
+    // Zip names use "/", but some Windows tools write "\"
+    std::string name = entryName;
+    std::replace(name.begin(), name.end(), '\\', '/');
+    if (name.empty() || name[0] == '/' || name.find(':') != std::string::npos ||
+        name.find('\0') != std::string::npos) {
+        return false;
+    }
+
+    std::vector<std::string> parts;
+    std::stringstream stream(name);
+    std::string part;
+    while (std::getline(stream, part, '/')) {
+        if (part == "..") {
+            return false;
+        }
+        if (!part.empty() && part != ".") {
+            parts.push_back(part);
+        }
+    }
+    if (parts.empty()) {
+        return false;
+    }
+
+    relativePath.clear();
+    for (const auto& component : parts) {
+        relativePath += (relativePath.empty() ? "" : "/") + component;
+    }
+    return true;
+}
+
+ArchiveStream::ArchiveStream(ArchiveFormat format, std::function<std::string(const std::string&)> destinationFor)
+    : format_(format), destinationFor_(std::move(destinationFor)) {
+    zstream_ = z_stream();
+}
+
+ArchiveStream::~ArchiveStream() {
+    if (inflating_) {
+        inflateEnd(&zstream_);
+    }
+    CloseOutput(false);
+}
+
+bool ArchiveStream::Fail(const std::string& message) {
+    if (error_.empty()) {
+        error_ = message;
+    }
+    CloseOutput(false);
+    return false;
+}
+
+bool ArchiveStream::Write(const char* data, size_t length) {
+    if (!error_.empty()) {
+        return false;
+    }
+
+    while (length > 0) {
+        switch (state_) {
+        case State::LocalHeader:
+            if (format_ == ArchiveFormat::Gzip) {
+                // A gzip member: zlib parses the header and checks the trailer itself
+                if (!sawEntry_) {
+                    entryName_ = "gzip member";
+                    outputPath_ = destinationFor_("");
+                    if (!outputPath_.empty() && !(output_ = fopen((outputPath_ + ".tmp").c_str(), "wb"))) {
+                        return Fail("Failed to create " + outputPath_ + ".tmp");
+                    }
+                }
+                if (inflating_) {
+                    inflateReset(&zstream_);
+                } else if (inflateInit2(&zstream_, 16 + MAX_WBITS) != Z_OK) {
+                    return Fail("Failed to initialize zlib");
+                }
+                inflating_ = true;
+                deflated_ = true;
+                sawEntry_ = true;
+                state_ = State::EntryData;
+                break;
+            }
+            if (format_ != ArchiveFormat::Zip) {
+                return Fail("Not an archive");
+            }
+            if (!Collect(pending_, 4, data, length)) {
+                return true;
+            }
+            if (Read32(pending_, 0) != kLocalHeaderSignature) {
+                uint32_t signature = Read32(pending_, 0);
+                if (sawEntry_ && (signature == kCentralHeaderSignature || signature == kEndOfCentralSignature ||
+                                  signature == kZip64EndOfCentralSignature)) {
+                    // Everything after the last entry describes what was already read
+                    pending_.clear();
+                    state_ = State::Trailer;
+                    break;
+                }
+                return Fail("Not a zip archive or corrupt local header");
+            }
+            if (!Collect(pending_, kLocalHeaderSize, data, length)) {
+                return true;
+            }
+            nameLength_ = Read16(pending_, 26);
+            extraLength_ = Read16(pending_, 28);
+            state_ = State::EntryName;
+            break;
+
+        case State::EntryName:
+            if (!Collect(pending_, kLocalHeaderSize + nameLength_ + extraLength_, data, length)) {
+                return true;
+            }
+            if (!BeginEntry()) {
+                return false;
+            }
+            break;
+
+        case State::EntryData:
+            if (!ConsumeData(data, length)) {
+                return false;
+            }
+            break;
+
+        case State::Descriptor: {
+            if (!Collect(pending_, 4, data, length)) {
+                return true;
+            }
+            size_t offset = Read32(pending_, 0) == kDescriptorSignature ? 4 : 0;
+            size_t wanted = offset + 4 + (zip64_ ? 16 : 8);
+            if (!Collect(pending_, wanted, data, length)) {
+                return true;
+            }
+            uint32_t crc = Read32(pending_, offset);
+            uint64_t compressedSize = zip64_ ? Read64(pending_, offset + 4) : Read32(pending_, offset + 4);
+            uint64_t size = zip64_ ? Read64(pending_, offset + 12) : Read32(pending_, offset + 8);
+            pending_.clear();
+            if (!FinishEntry(crc, compressedSize, size)) {
+                return false;
+            }
+            state_ = State::LocalHeader;
+            break;
+        }
+
+        case State::Trailer:
+            if (format_ == ArchiveFormat::Gzip) {
+                // Concatenated gzip members continue the same file
+                state_ = State::LocalHeader;
+                break;
+            }
+            length = 0;
+            break;
+        }
+    }
+    return true;
+}
+
+bool ArchiveStream::BeginEntry() {
+    uint16_t flags = Read16(pending_, 6);
+    uint16_t method = Read16(pending_, 8);
+    expectedCrc_ = Read32(pending_, 14);
+    compressedSize_ = Read32(pending_, 18);
+    size_ = Read32(pending_, 22);
+    std::string name = pending_.substr(kLocalHeaderSize, nameLength_);
+
+    // Zip64 sizes live in an extra field
+    zip64_ = false;
+    std::string extra = pending_.substr(kLocalHeaderSize + nameLength_, extraLength_);
+    for (size_t offset = 0; offset + 4 <= extra.size();) {
+        uint16_t id = Read16(extra, offset);
+        uint16_t fieldLength = Read16(extra, offset + 2);
+        if (id == kZip64ExtraId) {
+            zip64_ = true;
+            size_t field = offset + 4;
+            if (size_ == 0xFFFFFFFF && field + 8 <= extra.size()) {
+                size_ = Read64(extra, field);
+                field += 8;
+            }
+            if (compressedSize_ == 0xFFFFFFFF && field + 8 <= extra.size()) {
+                compressedSize_ = Read64(extra, field);
+            }
+        }
+        offset += 4 + fieldLength;
+    }
+    pending_.clear();
+
+    if (flags & kFlagEncrypted) {
+        return Fail("Encrypted zip entries are not supported: " + name);
+    }
+    if (method != kMethodStored && method != kMethodDeflated) {
+        return Fail("Unsupported compression method " + std::to_string(method) + " for " + name);
+    }
+    hasDescriptor_ = (flags & kFlagDescriptor) != 0;
+    deflated_ = method == kMethodDeflated;
+    if (!deflated_ && hasDescriptor_ && compressedSize_ == 0) {
+        return Fail("Stored entry without sizes can't be streamed: " + name);
+    }
+
+    std::string relativePath;
+    if (!SafeArchivePath(name, relativePath)) {
+        return Fail("Unsafe path in archive: " + name);
+    }
+
+    sawEntry_ = true;
+    entryName_ = relativePath;
+    compressedRead_ = 0;
+    written_ = 0;
+    crc_ = crc32(0L, Z_NULL, 0);
+
+    // Directories have no data of their own
+    bool directory = name.back() == '/' || name.back() == '\\';
+    outputPath_ = directory ? "" : destinationFor_(relativePath);
+    if (!outputPath_.empty()) {
+        output_ = fopen((outputPath_ + ".tmp").c_str(), "wb");
+        if (!output_) {
+            return Fail("Failed to create " + outputPath_ + ".tmp");
+        }
+    }
+
+    if (deflated_) {
+        if (inflating_) {
+            inflateReset(&zstream_);
+        } else if (inflateInit2(&zstream_, -MAX_WBITS) != Z_OK) {
+            return Fail("Failed to initialize zlib");
+        }
+        inflating_ = true;
+    }
+    state_ = State::EntryData;
+
+    // Empty stored entries end right here
+    if (!deflated_ && compressedSize_ == 0) {
+        if (!FinishEntry(expectedCrc_, 0, size_)) {
+            return false;
+        }
+        state_ = State::LocalHeader;
+    }
+    return true;
+}
+
+bool ArchiveStream::ConsumeData(const char*& data, size_t& length) {
+    if (!deflated_) {
+        size_t take = static_cast<size_t>(std::min<uint64_t>(length, compressedSize_ - compressedRead_));
+        if (!WriteOutput(reinterpret_cast<const unsigned char*>(data), take)) {
+            return false;
+        }
+        data += take;
+        length -= take;
+        compressedRead_ += take;
+        if (compressedRead_ == compressedSize_) {
+            if (hasDescriptor_) {
+                state_ = State::Descriptor;
+            } else {
+                if (!FinishEntry(expectedCrc_, compressedSize_, size_)) {
+                    return false;
+                }
+                state_ = State::LocalHeader;
+            }
+        }
+        return true;
+    }
+
+    unsigned char buffer[kInflateChunk];
+    zstream_.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+    zstream_.avail_in = static_cast<uInt>(std::min<size_t>(length, 0x7FFFFFFF));
+    int result = Z_OK;
+    while (zstream_.avail_in > 0 && result != Z_STREAM_END) {
+        zstream_.next_out = buffer;
+        zstream_.avail_out = sizeof(buffer);
+        result = inflate(&zstream_, Z_NO_FLUSH);
+        if (result != Z_OK && result != Z_STREAM_END && result != Z_BUF_ERROR) {
+            return Fail(std::string("Corrupt compressed data: ") + (zstream_.msg ? zstream_.msg : "inflate failed"));
+        }
+        if (!WriteOutput(buffer, sizeof(buffer) - zstream_.avail_out)) {
+            return false;
+        }
+        if (result == Z_BUF_ERROR && zstream_.avail_out != 0) {
+            break;
+        }
+    }
+
+    size_t consumed = static_cast<size_t>(zstream_.next_in - reinterpret_cast<const Bytef*>(data));
+    data += consumed;
+    length -= consumed;
+    compressedRead_ += consumed;
+
+    if (result == Z_STREAM_END) {
+        if (format_ == ArchiveFormat::Gzip) {
+            // zlib has verified the member's CRC-32 and length; Finish keeps the file
+            state_ = State::Trailer;
+        } else if (hasDescriptor_) {
+            state_ = State::Descriptor;
+        } else {
+            if (!FinishEntry(expectedCrc_, compressedSize_, size_)) {
+                return false;
+            }
+            state_ = State::LocalHeader;
+        }
+    }
+    return true;
+}
+
+bool ArchiveStream::FinishEntry(uint32_t crc, uint64_t compressedSize, uint64_t size) {
+    if (crc_ != crc) {
+        return Fail("CRC-32 mismatch in archive entry " + entryName_);
+    }
+    if (written_ != size || compressedRead_ != compressedSize) {
+        return Fail("Size mismatch in archive entry " + entryName_);
+    }
+    CloseOutput(true);
+    return error_.empty();
+}
+
+bool ArchiveStream::WriteOutput(const unsigned char* data, size_t length) {
+    if (length == 0) {
+        return true;
+    }
+    crc_ = crc32(crc_, data, static_cast<uInt>(length));
+    written_ += length;
+    if (output_ && fwrite(data, 1, length, output_) != length) {
+        return Fail("Failed to write " + outputPath_ + ".tmp");
+    }
+    return true;
+}
+
+void ArchiveStream::CloseOutput(bool keep) {
+    if (!output_) {
+        return;
+    }
+    bool closed = fclose(output_) == 0;
+    output_ = nullptr;
+
+    std::string tempPath = outputPath_ + ".tmp";
+    std::error_code ec;
+    if (keep && closed) {
+        fs::rename(tempPath, outputPath_, ec);
+        if (!ec) {
+            ++extracted_;
+            return;
+        }
+        error_ = "Failed to move " + tempPath + " into place: " + ec.message();
+    } else if (keep) {
+        error_ = "Failed to write " + tempPath;
+    }
+    fs::remove(tempPath, ec);
+}
+
+bool ArchiveStream::Finish() {
+    if (!error_.empty()) {
+        return false;
+    }
+    if (state_ != State::Trailer) {
+        return Fail("Archive is truncated");
+    }
+    CloseOutput(true);
+    return error_.empty();
+}
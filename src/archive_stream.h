@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <zlib.h>
+
+// Archive formats a release asset can come in
+enum class ArchiveFormat {
+    None,   // the asset is the file itself
+    Zip,
+    Gzip
+};
+
+// Function to tell the archive format from an asset's file name (".zip", ".gz")
+ArchiveFormat ArchiveFormatFor(const std::string& assetName);
+
+// Function to turn an archive entry name into a safe relative path ("/"
+// separated). Absolute paths, drive letters, ".." components and empty names
+// are rejected, so no entry can be written outside the extraction directory.
+bool SafeArchivePath(const std::string& entryName, std::string& relativePath);
+
+// Streaming decoder for zip and gzip archives, fed from a download's write path.
+// Each entry is inflated straight into its destination file as the bytes
+// arrive (via "<destination>.tmp", renamed once its CRC-32 and size check out),
+// so the archive itself is never stored or held in memory whole.
+//
+// destinationFor is asked once per file entry with its safe relative path (""
+// for gzip, which has one unnamed entry) and returns where to write it, or ""
+// to skip the entry; skipped entries are still inflated and CRC-checked. An
+// unsafe entry name fails the whole archive. Zip entries must be stored or
+// deflated and unencrypted; the central directory at the end is not needed.
+class ArchiveStream {
+public:
+    ArchiveStream(ArchiveFormat format, std::function<std::string(const std::string&)> destinationFor);
+    ~ArchiveStream();
+
+    ArchiveStream(const ArchiveStream&) = delete;
+    ArchiveStream& operator=(const ArchiveStream&) = delete;
+
+    // Function to decode the next chunk of the archive, false once it's invalid
+    bool Write(const char* data, size_t length);
+
+    // Function to check that the archive ended after complete entries
+    bool Finish();
+
+    const std::string& Error() const { return error_; }
+    int EntriesExtracted() const { return extracted_; }
+
+private:
+    enum class State { LocalHeader, EntryName, EntryData, Descriptor, Trailer };
+
+    bool Fail(const std::string& message);
+    bool BeginEntry();
+    bool ConsumeData(const char*& data, size_t& length);
+    bool FinishEntry(uint32_t crc, uint64_t compressedSize, uint64_t size);
+    bool WriteOutput(const unsigned char* data, size_t length);
+    void CloseOutput(bool keep);
+
+    ArchiveFormat format_;
+    std::function<std::string(const std::string&)> destinationFor_;
+    State state_ = State::LocalHeader;
+    std::string pending_;           // header bytes collected across chunks
+    std::string error_;
+
+    // Current entry
+    z_stream zstream_;
+    bool inflating_ = false;
+    bool deflated_ = false;
+    bool hasDescriptor_ = false;
+    bool zip64_ = false;
+    uint32_t expectedCrc_ = 0;
+    uint64_t compressedSize_ = 0;
+    uint64_t size_ = 0;
+    uint64_t compressedRead_ = 0;
+    uint64_t written_ = 0;
+    uint32_t crc_ = 0;
+    std::string entryName_;
+    size_t nameLength_ = 0;
+    size_t extraLength_ = 0;
+    FILE* output_ = nullptr;
+    std::string outputPath_;
+
+    int extracted_ = 0;
+    bool sawEntry_ = false;
+};
@@ -0,0 +1,204 @@
+#include "artifact_store.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <nlohmann/json.hpp>
+#include "fan_out.h"
+#include "logger.h"
+#include "platform.h"
+#include "sha256.h"
+
+using json = nlohmann::json;
+namespace fs = std::filesystem;
+
+namespace {
+
+std::string StoreRoot(const std::string& vrchatToolsPath) {
+    return JoinPath(vrchatToolsPath, "yt-dlp-store");
+}
+
+std::string IndexPath(const ArtifactStore& store) {
+    return JoinPath(store.root, "index.json");
+}
+
+// Function to delete an object file; it may carry the read-only attribute of the binary it was linked from
+void RemoveObject(const std::string& objectPath) {
+    std::error_code ec;
+    if (!fs::exists(objectPath, ec)) {
+        return;
+    }
+    RemoveReadOnlyAttribute(objectPath);
+    if (!fs::remove(objectPath, ec)) {
+        LogError() << "Failed to remove stored object " << objectPath << ": " << ec.message();
+    }
+}
+
+} // namespace
+
+bool OpenArtifactStore(const std::string& vrchatToolsPath, ArtifactStore& store) {
+    store.root = StoreRoot(vrchatToolsPath);
+    store.entries.clear();
+    store.heldBackTag.clear();
+
+    std::string indexPath = IndexPath(store);
+    if (!fs::exists(indexPath)) {
+        return true;
+    }
+
+    std::ifstream file(indexPath);
+    if (!file.is_open()) {
+        LogError() << "Failed to open store index: " << indexPath;
+        return false;
+    }
+
+    try {
+        json data = json::parse(file);
+        store.heldBackTag = data.value("held_back", "");
+        for (const auto& item : data.at("entries")) {
+            StoreEntry entry;
+            entry.tag = item.at("tag").get<std::string>();
+            entry.sha256 = item.at("sha256").get<std::string>();
+            entry.size = item.at("size").get<uint64_t>();
+            entry.installedAt = item.value("installed_at", static_cast<std::time_t>(0));
+            entry.lastUsed = item.value("last_used", entry.installedAt);
+
+            // Objects removed behind the store's back are forgotten
+            std::error_code ec;
+            if (fs::file_size(StoreObjectPath(store, entry.sha256), ec) == entry.size && !ec) {
+                store.entries.push_back(entry);
+            }
+        }
+    } catch (const json::exception& e) {
+        LogWarning() << "Ignoring invalid store index: " << e.what();
+        store.entries.clear();
+    }
+
+    return true;
+}
+
+std::string StoreIndexPath(const std::string& vrchatToolsPath) {
+    return JoinPath(StoreRoot(vrchatToolsPath), "index.json");
+}
+
+bool SaveArtifactStore(const ArtifactStore& store) {
+    json entries = json::array();
+    for (const auto& entry : store.entries) {
+        entries.push_back({
+            {"tag", entry.tag},
+            {"sha256", entry.sha256},
+            {"size", entry.size},
+            {"installed_at", entry.installedAt},
+            {"last_used", entry.lastUsed}
+        });
+    }
+    json data = {{"held_back", store.heldBackTag}, {"entries", entries}};
+
+    std::string indexPath = IndexPath(store);
+    std::string tempPath = indexPath + ".tmp";
+    std::ofstream file(tempPath, std::ios::trunc);
+    if (!file.is_open()) {
+        LogError() << "Failed to write store index: " << tempPath;
+        return false;
+    }
+    file << data.dump(2);
+    file.close();
+
+    std::error_code ec;
+    fs::rename(tempPath, indexPath, ec);
+    if (ec) {
+        LogError() << "Failed to replace store index " << indexPath << ": " << ec.message();
+        return false;
+    }
+    return true;
+}
+
+std::string StoreObjectPath(const ArtifactStore& store, const std::string& sha256) {
+    return JoinPath(JoinPath(store.root, "objects"), sha256);
+}
+
+StoreEntry* FindStoreEntry(ArtifactStore& store, const std::string& tag) {
+    for (auto& entry : store.entries) {
+        if (entry.tag == tag) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+bool AddToStore(ArtifactStore& store, const std::string& filePath, const std::string& tag, const std::string& sha256) {
+    std::error_code ec;
+    uint64_t size = fs::file_size(filePath, ec);
+    if (ec) {
+        LogError() << "Failed to add " << filePath << " to the store: " << ec.message();
+        return false;
+    }
+
+    std::string digest = sha256;
+    if (digest.empty()) {
+        DownloadHasher hasher(filePath);
+        if (!hasher.Finish(static_cast<curl_off_t>(size), digest)) {
+            return false;
+        }
+    }
+
+    // Same content under a new object name is never needed; only link what's missing
+    std::string objectPath = StoreObjectPath(store, digest);
+    if (fs::file_size(objectPath, ec) != size || ec) {
+        RemoveObject(objectPath);
+        fs::create_directories(fs::path(objectPath).parent_path(), ec);
+        PlacementMethod method;
+        if (!PlaceFile(filePath, objectPath, true, method)) {
+            return false;
+        }
+    }
+
+    std::time_t now = std::time(nullptr);
+    StoreEntry* entry = FindStoreEntry(store, tag);
+    if (!entry) {
+        store.entries.emplace_back();
+        entry = &store.entries.back();
+        entry->tag = tag;
+        entry->installedAt = now;
+    }
+    entry->sha256 = digest;
+    entry->size = size;
+    entry->lastUsed = now;
+    return true;
+}
+
+void CollectGarbage(ArtifactStore& store, uint64_t maxBytes, const std::string& keepSha256) {
+    // Least recently used first
+    std::sort(store.entries.begin(), store.entries.end(),
+              [](const StoreEntry& a, const StoreEntry& b) { return a.lastUsed < b.lastUsed; });
+
+    auto storedBytes = [&store]() {
+        uint64_t total = 0;
+        std::vector<std::string> counted;
+        for (const auto& entry : store.entries) {
+            if (std::find(counted.begin(), counted.end(), entry.sha256) == counted.end()) {
+                counted.push_back(entry.sha256);
+                total += entry.size;
+            }
+        }
+        return total;
+    };
+
+    for (size_t i = 0; i < store.entries.size() && storedBytes() > maxBytes;) {
+        if (store.entries[i].sha256 == keepSha256) {
+            ++i;
+            continue;
+        }
+
+        std::string sha256 = store.entries[i].sha256;
+        LogInfo() << "Removing " << store.entries[i].tag << " from the store";
+        store.entries.erase(store.entries.begin() + i);
+
+        // The object goes once no other tag refers to it
+        bool referenced = std::any_of(store.entries.begin(), store.entries.end(),
+                                      [&sha256](const StoreEntry& entry) { return entry.sha256 == sha256; });
+        if (!referenced) {
+            RemoveObject(StoreObjectPath(store, sha256));
+        }
+    }
+}
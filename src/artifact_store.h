@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <vector>
+
+// One installed release kept in the store
+struct StoreEntry {
+    std::string tag;            // release tag, e.g. "2026.01.01"
+    std::string sha256;         // object name in the store
+    uint64_t size = 0;
+    std::time_t installedAt = 0;
+    std::time_t lastUsed = 0;   // last time this release was made the installed one
+};
+
+// Content-addressed store of yt-dlp.exe builds in a Tools directory
+// (yt-dlp-store/objects/<sha256>) with an index of tag -> hash, size and use
+// times. Switching to a stored release is a local link or copy, no download.
+struct ArtifactStore {
+    std::string root;
+    std::vector<StoreEntry> entries;
+    std::string heldBackTag;    // release rolled back from; not reinstalled until a newer one appears
+};
+
+// Default cap on the total size of stored objects
+const uint64_t kDefaultStoreMaxBytes = 256ull * 1024 * 1024;
+
+// Function to open the store of a Tools directory (an empty store if there is none yet)
+bool OpenArtifactStore(const std::string& vrchatToolsPath, ArtifactStore& store);
+
+// Function to get the path of the store index of a Tools directory
+std::string StoreIndexPath(const std::string& vrchatToolsPath);
+
+// Function to write the store's index
+bool SaveArtifactStore(const ArtifactStore& store);
+
+// Function to get the path of the object with the given hash
+std::string StoreObjectPath(const ArtifactStore& store, const std::string& sha256);
+
+// Function to find the entry of a release tag, nullptr if it isn't stored
+StoreEntry* FindStoreEntry(ArtifactStore& store, const std::string& tag);
+
+// Function to add an installed file to the store under tag (hard linked when
+// possible) and mark it as used now. sha256 may be "" to hash the file here.
+bool AddToStore(ArtifactStore& store, const std::string& filePath, const std::string& tag, const std::string& sha256);
+
+// Function to drop the least recently used releases until the objects fit in
+// maxBytes; the release with hash keepSha256 is never dropped
+void CollectGarbage(ArtifactStore& store, uint64_t maxBytes, const std::string& keepSha256);
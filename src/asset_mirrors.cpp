@@ -0,0 +1,338 @@
+#include "asset_mirrors.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <tuple>
+#include <curl/curl.h>
+#include <nlohmann/json.hpp>
+#include "logger.h"
+#include "metrics.h"
+#include "platform.h"
+#include "transfer_context.h"
+
+using json = nlohmann::json;
+namespace fs = std::filesystem;
+
+namespace {
+
+// Size of the ranged probe; enough to see a source's throughput, not just its latency
+const curl_off_t kProbeBytes = 64 * 1024;
+
+// Head start of each source over the next one in the race
+const std::chrono::milliseconds kRaceStagger(250);
+
+// A probe that hasn't finished by then counts as failed
+const long kProbeTimeoutMs = 10000;
+
+// Longest wait for socket activity. curl_multi_poll doesn't reliably wake up
+// for connections from the shared pool, so the race polls in short slices to
+// time the probes to within this.
+const int kPollSliceMs = 10;
+
+// Weight of the newest probe in a source's latency average
+const double kLatencyWeight = 0.3;
+
+std::vector<std::string> g_mirrors;
+
+// One source in the race
+struct Source {
+    std::string key;                // the mirror as configured, or the origin of the release URL
+    std::string url;                // the asset on it (a path for a local directory)
+    bool origin = false;            // the release's own URL
+
+    // From earlier runs
+    double latencyMs = -1;          // average probe time, -1 if never probed successfully
+    int failures = 0;               // failed probes in a row
+
+    // This race
+    CURL* curl = nullptr;
+    struct curl_slist* headers = nullptr;
+    curl_off_t received = 0;
+    bool started = false;
+    bool finished = false;
+    bool healthy = false;
+    bool failed = false;            // answered, but not with the probe range
+    double probeMs = 0;
+    std::chrono::steady_clock::time_point startedAt;
+};
+
+// Write callback of a probe: counts the bytes and stops once the probe range
+// is in, in case the server ignored the range and sends the whole file
+size_t ProbeWriteCallback(void*, size_t size, size_t nmemb, Source* source) {
+    source->received += static_cast<curl_off_t>(size * nmemb);
+    return source->received > kProbeBytes ? 0 : size * nmemb;
+}
+
+// Function to get "scheme://host[:port]" of a URL, which the release's own
+// source is remembered by (its path changes with every release)
+std::string OriginOf(const std::string& url) {
+    size_t scheme = url.find("://");
+    size_t pathStart = scheme == std::string::npos ? std::string::npos : url.find('/', scheme + 3);
+    return url.substr(0, pathStart);
+}
+
+void ReadHistory(const std::string& historyPath, std::vector<Source>& sources) {
+    std::ifstream file(historyPath);
+    if (!file.is_open()) {
+        return;
+    }
+    try {
+        json history = json::parse(file);
+        for (auto& source : sources) {
+            if (history.contains(source.key)) {
+                const json& entry = history[source.key];
+                source.latencyMs = entry.value("latency_ms", -1.0);
+                source.failures = entry.value("failures", 0);
+            }
+        }
+    } catch (const json::exception& e) {
+        LogWarning() << "Ignoring invalid mirror history: " << e.what();
+    }
+}
+
+// Function to merge this race's sources into the history, keeping entries of
+// mirrors that weren't configured this time
+void WriteHistory(const std::string& historyPath, const std::vector<Source>& sources) {
+    json history = json::object();
+    {
+        std::ifstream file(historyPath);
+        if (file.is_open()) {
+            try {
+                history = json::parse(file);
+            } catch (const json::exception&) {
+                history = json::object();
+            }
+        }
+    }
+    for (const auto& source : sources) {
+        history[source.key] = {{"latency_ms", source.latencyMs}, {"failures", source.failures}};
+    }
+
+    std::string tempPath = historyPath + ".tmp";
+    std::ofstream file(tempPath, std::ios::trunc);
+    file << history.dump(2);
+    file.close();
+    std::error_code ec;
+    if (!file) {
+        fs::remove(tempPath, ec);
+        return;
+    }
+    fs::rename(tempPath, historyPath, ec);
+    if (ec) {
+        LogError() << "Failed to update mirror history " << historyPath << ": " << ec.message();
+        fs::remove(tempPath, ec);
+    }
+}
+
+// Function to order sources for the race: untried ones first, so a new mirror
+// gets measured once instead of always losing to the head start of known ones,
+// then those that answered before by their average time, then those that
+// failed last time (fewest failures first). The release's own URL wins ties.
+void SortByHistory(std::vector<Source>& sources) {
+    auto rank = [](const Source& source) {
+        int group = source.failures > 0 ? 2 : source.latencyMs < 0 ? 0 : 1;
+        return std::make_tuple(group, source.failures, group == 1 ? source.latencyMs : 0.0, !source.origin);
+    };
+    std::stable_sort(sources.begin(), sources.end(), [&](const Source& a, const Source& b) { return rank(a) < rank(b); });
+}
+
+void StartProbe(CURLM* multi, Source& source) {
+    source.started = true;
+    source.startedAt = std::chrono::steady_clock::now();
+    source.curl = AcquireEasyHandle();
+    if (!source.curl) {
+        source.finished = true;
+        source.failed = true;
+        return;
+    }
+
+    std::string range = "0-" + std::to_string(kProbeBytes - 1);
+    curl_easy_setopt(source.curl, CURLOPT_URL, source.url.c_str());
+    curl_easy_setopt(source.curl, CURLOPT_RANGE, range.c_str());
+    curl_easy_setopt(source.curl, CURLOPT_WRITEFUNCTION, ProbeWriteCallback);
+    curl_easy_setopt(source.curl, CURLOPT_WRITEDATA, &source);
+    curl_easy_setopt(source.curl, CURLOPT_FOLLOWLOCATION, 1L); // Follow redirects
+    curl_easy_setopt(source.curl, CURLOPT_SSL_VERIFYPEER, 1L); // Verify SSL certificate
+    curl_easy_setopt(source.curl, CURLOPT_TIMEOUT_MS, kProbeTimeoutMs);
+    curl_easy_setopt(source.curl, CURLOPT_PRIVATE, &source);
+    source.headers = curl_slist_append(nullptr, "User-Agent: yt-dlp-updater");
+    curl_easy_setopt(source.curl, CURLOPT_HTTPHEADER, source.headers);
+    curl_multi_add_handle(multi, source.curl);
+}
+
+void FinishProbe(CURLM* multi, Source& source) {
+    if (source.curl) {
+        curl_multi_remove_handle(multi, source.curl);
+        RecordRequestMetrics(source.curl, "mirror_probe");
+        ReleaseEasyHandle(source.curl);
+        source.curl = nullptr;
+    }
+    curl_slist_free_all(source.headers);
+    source.headers = nullptr;
+    source.finished = true;
+}
+
+// Function to judge a finished probe: the range (or, from a server without
+// ranges, the start of the file) must have arrived
+bool ProbeSucceeded(CURL* curl, CURLcode result, const Source& source) {
+    long responseCode = 0;
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &responseCode);
+    if (responseCode == 206) {
+        return result == CURLE_OK && source.received > 0;
+    }
+    // Cut short by the write callback, or a file smaller than the probe
+    return responseCode == 200 && (result == CURLE_OK || (result == CURLE_WRITE_ERROR && source.received > kProbeBytes));
+}
+
+// Function to race the probes of the remote sources, started in their current
+// order. Returns the index of the winner, or -1 if none answered.
+int RaceProbes(std::vector<Source>& sources) {
+    CURLM* multi = curl_multi_init();
+    if (!multi) {
+        LogError() << "Failed to initialize CURL multi handle";
+        return -1;
+    }
+    ConfigureMultiHandle(multi);
+
+    int winner = -1;
+    size_t next = 0;
+    auto nextStart = std::chrono::steady_clock::now();
+    int running = 0;
+    while (winner < 0) {
+        // Start the next source on schedule, or right away when nothing is in flight
+        auto now = std::chrono::steady_clock::now();
+        if (next < sources.size() && (now >= nextStart || running == 0)) {
+            StartProbe(multi, sources[next++]);
+            nextStart = now + kRaceStagger;
+        }
+
+        CURLMcode mc = curl_multi_perform(multi, &running);
+        if (mc == CURLM_OK) {
+            mc = curl_multi_poll(multi, NULL, 0, kPollSliceMs, NULL);
+        }
+        if (mc != CURLM_OK) {
+            LogError() << "curl_multi failed: " << curl_multi_strerror(mc);
+            break;
+        }
+
+        CURLMsg* msg;
+        int queued;
+        while ((msg = curl_multi_info_read(multi, &queued))) {
+            if (msg->msg != CURLMSG_DONE) {
+                continue;
+            }
+            Source* source = nullptr;
+            curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, &source);
+            source->healthy = ProbeSucceeded(msg->easy_handle, msg->data.result, *source);
+            source->failed = !source->healthy;
+            source->probeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - source->startedAt).count();
+            if (source->healthy) {
+                source->latencyMs = source->latencyMs < 0 ? source->probeMs : source->latencyMs + kLatencyWeight * (source->probeMs - source->latencyMs);
+                source->failures = 0;
+                if (winner < 0) {
+                    winner = static_cast<int>(source - sources.data());
+                }
+            } else {
+                ++source->failures;
+                LogDebug() << "Mirror probe failed: " << source->url;
+            }
+            FinishProbe(multi, *source);
+            // Someone failed: the next source doesn't have to wait its turn
+            nextStart = std::chrono::steady_clock::now();
+        }
+
+        bool pending = next < sources.size() || std::any_of(sources.begin(), sources.end(), [](const Source& source) {
+            return source.started && !source.finished;
+        });
+        if (!pending) {
+            break;
+        }
+    }
+
+    // The race is decided; the others are dropped without a verdict
+    for (auto& source : sources) {
+        if (source.started && !source.finished) {
+            FinishProbe(multi, source);
+        }
+    }
+    curl_multi_cleanup(multi);
+    return winner;
+}
+
+} // namespace
+
+void SetAssetMirrors(const std::vector<std::string>& mirrors) {
+    g_mirrors = mirrors;
+}
+
+bool IsLocalSource(const std::string& source) {
+    return source.find("://") == std::string::npos;
+}
+
+std::vector<std::string> RankAssetSources(const std::string& downloadUrl, const std::string& tag, const std::string& expectedSha256, const std::string& historyPath) {
+    if (g_mirrors.empty()) {
+        return {downloadUrl};
+    }
+    if (expectedSha256.empty()) {
+        LogWarning() << "The release has no checksum to verify a mirror's file with; downloading from " << downloadUrl;
+        return {downloadUrl};
+    }
+
+    std::string assetName = downloadUrl.substr(downloadUrl.find_last_of('/') + 1);
+    std::vector<Source> sources;
+    Source origin;
+    origin.key = OriginOf(downloadUrl);
+    origin.url = downloadUrl;
+    origin.origin = true;
+    sources.push_back(origin);
+
+    // A local directory that has the file beats any network source
+    for (const auto& mirror : g_mirrors) {
+        std::string base = mirror;
+        while (base.size() > 1 && (base.back() == '/' || base.back() == '\\')) {
+            base.pop_back();
+        }
+        if (IsLocalSource(base)) {
+            std::string path = JoinPath(JoinPath(base, tag), assetName);
+            std::error_code ec;
+            if (fs::is_regular_file(path, ec)) {
+                LogInfo() << "Copying " << assetName << " from " << base;
+                return {path, downloadUrl};
+            }
+            LogDebug() << "Local mirror has no " << path;
+            continue;
+        }
+        Source source;
+        source.key = mirror;
+        source.url = base + "/" + tag + "/" + assetName;
+        sources.push_back(source);
+    }
+    if (sources.size() == 1) {
+        return {downloadUrl};
+    }
+
+    ReadHistory(historyPath, sources);
+    SortByHistory(sources);
+    int winner = TimePhase("mirror_race", downloadUrl, [&]() { return RaceProbes(sources); });
+    WriteHistory(historyPath, sources);
+
+    // The winner first, then the others as ranked, minus those that just failed
+    std::vector<std::string> ranked;
+    if (winner >= 0) {
+        const Source& best = sources[static_cast<size_t>(winner)];
+        ranked.push_back(best.url);
+        LogInfo() << "Downloading from " << (best.origin ? best.key : best.key + " (mirror)") << ", which answered in "
+                  << static_cast<long long>(best.probeMs) << " ms";
+    } else {
+        LogWarning() << "No download source answered the probe; trying them in order.";
+    }
+    for (size_t i = 0; i < sources.size(); ++i) {
+        if (static_cast<int>(i) != winner && (!sources[i].failed || sources[i].origin)) {
+            ranked.push_back(sources[i].url);
+        }
+    }
+    return ranked;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Other places to download the release asset from when GitHub's CDN is slow or
+// unreachable: HTTP mirrors, a LAN cache (such as another updater's serve) or
+// a local directory. Each has the asset at "<mirror>/<tag>/<asset name>", so
+// for serve that is "http://<host>:8080/download". Before a download every
+// source gets a small ranged probe, raced happy-eyeballs style: the source
+// ranked best by earlier runs starts first and the others follow at short
+// intervals (or right away when one fails). The first healthy answer wins;
+// the rest stay behind it for failover. The outcome is kept per Tools
+// directory to rank the sources on later runs.
+//
+// Whatever source a file comes from, it is verified against the checksum from
+// the release itself, so mirrors are only used when that checksum is known.
+
+// Name of the per-Tools-directory ranking history
+const char* const kMirrorHistoryName = "yt-dlp-mirrors.json";
+
+// Function to set the mirrors used for every download from here on
+void SetAssetMirrors(const std::vector<std::string>& mirrors);
+
+// Function to check whether a source is a local file rather than a URL
+bool IsLocalSource(const std::string& source);
+
+// Function to order the sources of a release asset, best first: downloadUrl
+// (the release's own URL) and the asset on every configured mirror. Sources
+// whose probe failed are left out, except downloadUrl, which is always kept as
+// the last resort. Without mirrors, or without expectedSha256 to verify a
+// mirror's file, this is just downloadUrl and nothing is probed.
+std::vector<std::string> RankAssetSources(const std::string& downloadUrl, const std::string& tag, const std::string& expectedSha256, const std::string& historyPath);
@@ -0,0 +1,86 @@
+#include "asset_variant.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include "platform.h"
+
+namespace fs = std::filesystem;
+
+const char* const kOneDirLibraryName = "_internal";
+
+namespace {
+
+// First bytes of a Linux (ELF) executable; Windows executables start with "MZ"
+const char kElfMagic[] = {0x7f, 'E', 'L', 'F'};
+
+} // namespace
+
+const std::vector<AssetVariant>& AssetVariants() {
+    static const std::vector<AssetVariant> variants = {
+        {"onefile", {"yt-dlp.exe", "yt-dlp.exe.zip", "yt-dlp.exe.gz"}, AssetLayout::OneFile, "yt-dlp.exe", false},
+        {"onedir", {"yt-dlp_win.zip"}, AssetLayout::OneDir, "yt-dlp.exe", false},
+        {"linux", {"yt-dlp_linux"}, AssetLayout::OneFile, "yt-dlp_linux", true},
+        {"linux-onedir", {"yt-dlp_linux.zip"}, AssetLayout::OneDir, "yt-dlp_linux", true}
+    };
+    return variants;
+}
+
+const std::vector<std::string>& AllAssetNames() {
+    static const std::vector<std::string> names = []() {
+        std::vector<std::string> all;
+        for (const auto& variant : AssetVariants()) {
+            all.insert(all.end(), variant.assetNames.begin(), variant.assetNames.end());
+        }
+        return all;
+    }();
+    return names;
+}
+
+const AssetVariant* FindAssetVariant(const std::string& name) {
+    for (const auto& variant : AssetVariants()) {
+        if (variant.name == name) {
+            return &variant;
+        }
+    }
+    return nullptr;
+}
+
+const AssetVariant* VariantForAsset(const std::string& assetName) {
+    for (const auto& variant : AssetVariants()) {
+        for (const auto& name : variant.assetNames) {
+            if (name == assetName) {
+                return &variant;
+            }
+        }
+    }
+    return nullptr;
+}
+
+bool VariantRunsHere(const AssetVariant& variant) {
+#ifdef _WIN32
+    return !variant.native;
+#else
+    (void)variant;
+    return true;
+#endif
+}
+
+bool ExecutableMatchesVariant(const std::string& filePath, const AssetVariant& variant) {
+    std::ifstream file(filePath, std::ios::binary);
+    char magic[sizeof(kElfMagic)] = {};
+    file.read(magic, sizeof(magic));
+    bool native = file.gcount() == sizeof(magic) && std::equal(magic, magic + sizeof(magic), kElfMagic);
+    return native == variant.native;
+}
+
+bool InstalledVariantMatches(const std::string& vrchatToolsPath, const AssetVariant& variant) {
+    std::string ytDlpPath = JoinPath(vrchatToolsPath, "yt-dlp.exe");
+    std::error_code ec;
+    if (!fs::exists(ytDlpPath, ec)) {
+        return true;
+    }
+
+    bool oneDir = fs::is_directory(JoinPath(vrchatToolsPath, kOneDirLibraryName), ec);
+    return ExecutableMatchesVariant(ytDlpPath, variant) && oneDir == (variant.layout == AssetLayout::OneDir);
+}
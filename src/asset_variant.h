@@ -0,0 +1,51 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// The builds of yt-dlp a release publishes and which of them to install. Every
+// variant is installed as yt-dlp.exe, the name VRChat launches; onedir builds
+// also get their _internal directory next to it.
+
+// How a build is packaged
+enum class AssetLayout {
+    OneFile,    // a single executable that unpacks itself to a temp directory on every launch
+    OneDir      // a zip with the executable and an _internal directory it loads from in place
+};
+
+struct AssetVariant {
+    std::string name;                       // as given to --variant
+    std::vector<std::string> assetNames;    // release assets that provide it, most preferred first
+    AssetLayout layout;
+    std::string executable;                 // the executable's name in the asset or archive
+    bool native;                            // a Linux executable; Wine (Proton) starts those directly
+};
+
+// Name of the directory onedir builds load their libraries from
+extern const char* const kOneDirLibraryName;
+
+// Function to list every known variant, the default ("onefile") first
+const std::vector<AssetVariant>& AssetVariants();
+
+// Function to list the release assets of every variant, so one release request
+// can serve whichever variant is picked
+const std::vector<std::string>& AllAssetNames();
+
+// Function to look up a variant by name, nullptr if there is none
+const AssetVariant* FindAssetVariant(const std::string& name);
+
+// Function to find the variant a release asset belongs to, nullptr if none
+const AssetVariant* VariantForAsset(const std::string& assetName);
+
+// Function to check whether a variant's executable can run on this machine
+// (Linux builds only where the updater itself runs on Linux, i.e. under Proton)
+bool VariantRunsHere(const AssetVariant& variant);
+
+// Function to check whether an executable file is a build of the variant's
+// platform (Linux or Windows, told apart by its first bytes)
+bool ExecutableMatchesVariant(const std::string& filePath, const AssetVariant& variant);
+
+// Function to check whether the yt-dlp.exe in a Tools directory is the given
+// variant (by its executable format and whether _internal is next to it). A
+// directory without yt-dlp.exe matches any variant.
+bool InstalledVariantMatches(const std::string& vrchatToolsPath, const AssetVariant& variant);
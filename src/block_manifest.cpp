@@ -0,0 +1,134 @@
+#include "block_manifest.h"
+
+#include <cstdio>
+#include <nlohmann/json.hpp>
+#include <openssl/evp.h>
+#include "logger.h"
+
+using json = nlohmann::json;
+
+namespace {
+
+std::string ToHex(const unsigned char* data, size_t length) {
+    static const char* hexChars = "0123456789abcdef";
+    std::string hex;
+    hex.reserve(length * 2);
+    for (size_t i = 0; i < length; ++i) {
+        hex += hexChars[data[i] >> 4];
+        hex += hexChars[data[i] & 0x0f];
+    }
+    return hex;
+}
+
+} // namespace
+
+uint32_t WeakChecksum(const unsigned char* data, size_t length) {
+    uint32_t a = 0;
+    uint32_t b = 0;
+    for (size_t i = 0; i < length; ++i) {
+        a += data[i];
+        b += static_cast<uint32_t>(length - i) * data[i];
+    }
+    return (a & 0xffff) | ((b & 0xffff) << 16);
+}
+
+uint32_t RollWeakChecksum(uint32_t checksum, unsigned char out, unsigned char in, size_t blockSize) {
+    uint32_t a = checksum & 0xffff;
+    uint32_t b = checksum >> 16;
+    a = (a - out + in) & 0xffff;
+    b = (b - static_cast<uint32_t>(blockSize) * out + a) & 0xffff;
+    return a | (b << 16);
+}
+
+std::string StrongChecksum(const unsigned char* data, size_t length) {
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int digestLength = 0;
+    EVP_Digest(data, length, digest, &digestLength, EVP_sha256(), nullptr);
+    return ToHex(digest, 16);
+}
+
+bool BuildBlockManifest(const std::string& filePath, size_t blockSize, BlockManifest& manifest) {
+    if (blockSize == 0) {
+        LogError() << "Block size must be greater than zero";
+        return false;
+    }
+
+    FILE* fp = fopen(filePath.c_str(), "rb");
+    if (!fp) {
+        LogError() << "Failed to open file: " << filePath;
+        return false;
+    }
+
+    manifest = BlockManifest();
+    manifest.blockSize = blockSize;
+
+    EVP_MD_CTX* ctx = EVP_MD_CTX_new();
+    EVP_DigestInit_ex(ctx, EVP_sha256(), nullptr);
+
+    std::vector<unsigned char> block(blockSize);
+    size_t read = 0;
+    while ((read = fread(block.data(), 1, blockSize, fp)) > 0) {
+        BlockChecksum checksum;
+        checksum.weak = WeakChecksum(block.data(), read);
+        checksum.strong = StrongChecksum(block.data(), read);
+        manifest.blocks.push_back(checksum);
+        manifest.fileSize += read;
+        EVP_DigestUpdate(ctx, block.data(), read);
+    }
+    bool readError = ferror(fp) != 0;
+    fclose(fp);
+
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int digestLength = 0;
+    EVP_DigestFinal_ex(ctx, digest, &digestLength);
+    EVP_MD_CTX_free(ctx);
+    manifest.sha256 = ToHex(digest, digestLength);
+
+    if (readError) {
+        LogError() << "Failed to read file: " << filePath;
+        return false;
+    }
+    return true;
+}
+
+std::string SerializeBlockManifest(const BlockManifest& manifest) {
+    json blocks = json::array();
+    for (const auto& block : manifest.blocks) {
+        blocks.push_back({block.weak, block.strong});
+    }
+
+    json data = {
+        {"file_size", manifest.fileSize},
+        {"block_size", manifest.blockSize},
+        {"sha256", manifest.sha256},
+        {"blocks", blocks}
+    };
+    return data.dump();
+}
+
+bool ParseBlockManifest(const std::string& text, BlockManifest& manifest) {
+    try {
+        json data = json::parse(text);
+        manifest = BlockManifest();
+        manifest.fileSize = data.at("file_size").get<uint64_t>();
+        manifest.blockSize = data.at("block_size").get<size_t>();
+        manifest.sha256 = data.at("sha256").get<std::string>();
+        for (const auto& item : data.at("blocks")) {
+            BlockChecksum block;
+            block.weak = item.at(0).get<uint32_t>();
+            block.strong = item.at(1).get<std::string>();
+            manifest.blocks.push_back(block);
+        }
+    } catch (const json::exception& e) {
+        LogError() << "Invalid block manifest: " << e.what();
+        return false;
+    }
+
+    // The blocks have to cover the file exactly
+    if (manifest.blockSize == 0 || manifest.sha256.size() != 64 ||
+        manifest.blocks.size() != (manifest.fileSize + manifest.blockSize - 1) / manifest.blockSize) {
+        LogError() << "Invalid block manifest: block list does not match the file size";
+        return false;
+    }
+    return true;
+}
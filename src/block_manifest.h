@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Checksums of one fixed-size block of a file: a cheap rolling checksum used to
+// find candidate matches at any byte offset, and a strong checksum to confirm them
+struct BlockChecksum {
+    uint32_t weak = 0;
+    std::string strong;     // first 16 bytes of the block's SHA-256, hex encoded
+};
+
+// zsync-style description of a file: whole-file hash plus per-block checksums.
+// The last block may be shorter than blockSize.
+struct BlockManifest {
+    uint64_t fileSize = 0;
+    size_t blockSize = 0;
+    std::string sha256;
+    std::vector<BlockChecksum> blocks;
+};
+
+// Default block size for generated manifests
+const size_t kDefaultManifestBlockSize = 8192;
+
+// Function to compute the rsync-style rolling checksum of a block
+uint32_t WeakChecksum(const unsigned char* data, size_t length);
+
+// Function to roll a weak checksum of a blockSize window forward by one byte
+uint32_t RollWeakChecksum(uint32_t checksum, unsigned char out, unsigned char in, size_t blockSize);
+
+// Function to compute the strong checksum of a block
+std::string StrongChecksum(const unsigned char* data, size_t length);
+
+// Function to build the block manifest of a file
+bool BuildBlockManifest(const std::string& filePath, size_t blockSize, BlockManifest& manifest);
+
+// Function to serialize a block manifest to JSON
+std::string SerializeBlockManifest(const BlockManifest& manifest);
+
+// Function to parse a block manifest from JSON, returns false if it is malformed
+bool ParseBlockManifest(const std::string& text, BlockManifest& manifest);
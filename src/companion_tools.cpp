@@ -0,0 +1,619 @@
+#include "companion_tools.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <list>
+#include <memory>
+#include <set>
+#include <curl/curl.h>
+#include <nlohmann/json.hpp>
+#include "archive_stream.h"
+#include "fan_out.h"
+#include "logger.h"
+#include "metrics.h"
+#include "platform.h"
+#include "release_cache.h"
+#include "sha256.h"
+#include "transfer_context.h"
+#include "updater.h"
+
+using json = nlohmann::json;
+namespace fs = std::filesystem;
+
+namespace {
+
+// Downloads are staged next to the file they replace under this suffix
+const char* const kStagedSuffix = ".new";
+
+// Names the yt-dlp install itself uses, which no tool may take over
+const char* const kReservedNames[] = {"yt-dlp", "yt-dlp.exe", "yt-dlp.conf", "yt-dlp-version.txt"};
+
+// What a request on the loop fetches for its tool
+enum class RequestKind {
+    Release,
+    Checksums,
+    Download
+};
+
+// A tool on its way through the loop: the release check first, then the
+// download and the checksum listing side by side
+struct ToolJob {
+    const CompanionTool* tool = nullptr;
+    CompanionResult* result = nullptr;
+    std::string cachePath;
+    ReleaseCache cache;
+    bool haveCache = false;
+    std::string assetName;
+    std::string downloadUrl;
+    std::string checksumsUrl;
+    std::vector<size_t> outdated;       // targets without the release; the first gets the download
+    std::string stagingPath;            // that target
+
+    // The download, written to "<file>.new" (through the decoder for archives)
+    ArchiveFormat format = ArchiveFormat::None;
+    std::unique_ptr<ArchiveStream> archive;
+    std::set<std::string> extracted;
+    FILE* fp = nullptr;
+    DownloadHasher hasher{""};          // the asset arrives in order, nothing is read back
+    curl_off_t received = 0;
+    std::string expectedSha256;
+    bool downloaded = false;
+    bool failed = false;
+};
+
+// One transfer on the loop
+struct Request {
+    ToolJob* job = nullptr;
+    RequestKind kind = RequestKind::Release;
+    CURL* curl = nullptr;
+    struct curl_slist* headers = nullptr;
+    std::string body;                   // release JSON or checksum listing
+    HttpHeaders responseHeaders;
+};
+
+// Function to match a file name against a pattern with * and ? wildcards
+bool MatchesPattern(const std::string& name, const std::string& pattern) {
+    size_t n = 0;
+    size_t p = 0;
+    size_t starPattern = std::string::npos;
+    size_t starName = 0;
+    while (n < name.size()) {
+        if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == name[n])) {
+            ++n;
+            ++p;
+        } else if (p < pattern.size() && pattern[p] == '*') {
+            starPattern = p++;
+            starName = n;
+        } else if (starPattern != std::string::npos) {
+            p = starPattern + 1;
+            n = ++starName;
+        } else {
+            return false;
+        }
+    }
+    while (p < pattern.size() && pattern[p] == '*') {
+        ++p;
+    }
+    return p == pattern.size();
+}
+
+// Function to check that a name from the manifest stays inside the Tools directory
+bool IsPlainFileName(const std::string& name) {
+    return !name.empty() && name != "." && name != ".." && name.find_first_of("/\\:") == std::string::npos;
+}
+
+bool IsReservedName(const std::string& name) {
+    return std::find(std::begin(kReservedNames), std::end(kReservedNames), name) != std::end(kReservedNames);
+}
+
+// Function to mark a tool as failed; the first reason is the one reported
+void Fail(ToolJob& job, const std::string& reason) {
+    if (!job.failed) {
+        job.failed = true;
+        job.result->ok = false;
+        job.result->status = "failed: " + reason;
+    }
+}
+
+// Write callback for every request on the loop. Release JSON and checksum
+// listings are collected in memory; a download goes straight to its staged file
+// or archive decoder and is cut off once its tool has failed otherwise.
+size_t CompanionWriteCallback(void* contents, size_t size, size_t nmemb, Request* request) {
+    size_t length = size * nmemb;
+    if (request->kind != RequestKind::Download) {
+        request->body.append(static_cast<const char*>(contents), length);
+        return length;
+    }
+
+    ToolJob* job = request->job;
+    if (job->failed) {
+        return 0;
+    }
+
+    // Error pages are neither the asset nor an archive
+    if (job->received == 0) {
+        long responseCode = 0;
+        curl_easy_getinfo(request->curl, CURLINFO_RESPONSE_CODE, &responseCode);
+        if (responseCode != 200) {
+            return 0;
+        }
+    }
+    job->hasher.Write(job->received, contents, length);
+    job->received += static_cast<curl_off_t>(length);
+    if (job->archive) {
+        return job->archive->Write(static_cast<const char*>(contents), length) ? length : 0;
+    }
+    return fwrite(contents, 1, length, job->fp);
+}
+
+// Function to put a request for url on the loop
+bool AddRequest(CURLM* multi, std::list<Request>& requests, ToolJob& job, RequestKind kind, const std::string& url) {
+    CURL* curl = AcquireEasyHandle();
+    if (!curl) {
+        Fail(job, "failed to initialize CURL");
+        return false;
+    }
+
+    requests.emplace_back();
+    Request& request = requests.back();
+    request.job = &job;
+    request.kind = kind;
+    request.curl = curl;
+
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, CompanionWriteCallback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &request);
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, HeaderCallback);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, &request.responseHeaders);
+    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L); // Follow redirects
+    curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 1L); // Verify SSL certificate
+    curl_easy_setopt(curl, CURLOPT_PRIVATE, &request);
+
+    // Add User-Agent header (required by GitHub API); the release check is
+    // conditional on the cached release, like yt-dlp's own
+    request.headers = curl_slist_append(request.headers, "User-Agent: yt-dlp-updater");
+    if (kind == RequestKind::Release && job.haveCache) {
+        if (!job.cache.etag.empty()) {
+            request.headers = curl_slist_append(request.headers, ("If-None-Match: " + job.cache.etag).c_str());
+        }
+        if (!job.cache.lastModified.empty()) {
+            request.headers = curl_slist_append(request.headers, ("If-Modified-Since: " + job.cache.lastModified).c_str());
+        }
+    }
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, request.headers);
+
+    curl_multi_add_handle(multi, curl);
+    return true;
+}
+
+// Function to take a request off the loop and give its handle back
+void RemoveRequest(CURLM* multi, std::list<Request>& requests, Request* request) {
+    curl_multi_remove_handle(multi, request->curl);
+    ReleaseEasyHandle(request->curl);
+    curl_slist_free_all(request->headers);
+    requests.remove_if([request](const Request& other) { return &other == request; });
+}
+
+// Function to read the tag, asset and checksum listing out of a release, false
+// if the document is invalid or no asset matches
+bool ParseRelease(const std::string& body, ToolJob& job, std::string& version) {
+    try {
+        json data = json::parse(body);
+        std::string tag = data.value("tag_name", "");
+        for (const auto& asset : data.value("assets", json::array())) {
+            std::string name = asset.value("name", "");
+            if (job.downloadUrl.empty() && MatchesPattern(name, job.tool->assetPattern)) {
+                // Rolling tags such as "latest" keep their name, so the upload time tells builds apart
+                job.downloadUrl = asset.value("browser_download_url", "");
+                std::string uploaded = asset.value("updated_at", "");
+                version = uploaded.empty() ? tag : tag + " " + uploaded;
+            }
+            if (!job.tool->checksumsAsset.empty() && name == job.tool->checksumsAsset) {
+                job.checksumsUrl = asset.value("browser_download_url", "");
+            }
+        }
+        if (tag.empty()) {
+            Fail(job, "the release has no tag");
+            return false;
+        }
+    } catch (const json::exception& e) {
+        Fail(job, std::string("invalid release JSON: ") + e.what());
+        return false;
+    }
+
+    if (job.downloadUrl.empty()) {
+        Fail(job, "no release asset matches " + job.tool->assetPattern);
+        return false;
+    }
+    return true;
+}
+
+// Function to start downloading the asset into the first outdated target,
+// together with its checksum listing
+void StartDownload(CURLM* multi, std::list<Request>& requests, ToolJob& job, const std::vector<std::string>& targets) {
+    const CompanionTool& tool = *job.tool;
+    job.stagingPath = targets[job.outdated.front()];
+    job.format = ArchiveFormatFor(job.assetName);
+
+    std::error_code ec;
+    fs::create_directories(job.stagingPath, ec);
+    if (ec) {
+        Fail(job, "can't create " + job.stagingPath + ": " + ec.message());
+        return;
+    }
+
+    if (job.format == ArchiveFormat::Zip) {
+        // The first entry with each wanted name, at any depth
+        job.archive = std::make_unique<ArchiveStream>(job.format, [&job](const std::string& relativePath) -> std::string {
+            std::string baseName = relativePath.substr(relativePath.find_last_of('/') + 1);
+            const auto& files = job.tool->files;
+            if (std::find(files.begin(), files.end(), baseName) == files.end() || !job.extracted.insert(baseName).second) {
+                return "";
+            }
+            return JoinPath(job.stagingPath, baseName) + kStagedSuffix;
+        });
+    } else if (tool.files.size() != 1) {
+        Fail(job, job.assetName + " is a single file but " + std::to_string(tool.files.size()) + " files are wanted");
+        return;
+    } else if (job.format == ArchiveFormat::Gzip) {
+        std::string stagedPath = JoinPath(job.stagingPath, tool.files.front()) + kStagedSuffix;
+        job.extracted.insert(tool.files.front());
+        job.archive = std::make_unique<ArchiveStream>(job.format, [stagedPath](const std::string&) { return stagedPath; });
+    } else {
+        std::string stagedPath = JoinPath(job.stagingPath, tool.files.front()) + kStagedSuffix;
+        job.fp = fopen(stagedPath.c_str(), "wb");
+        if (!job.fp) {
+            Fail(job, "can't open " + stagedPath + " for writing");
+            return;
+        }
+        job.extracted.insert(tool.files.front());
+    }
+
+    if (!AddRequest(multi, requests, job, RequestKind::Download, job.downloadUrl)) {
+        return;
+    }
+    if (!tool.checksumsAsset.empty() && !job.checksumsUrl.empty()) {
+        AddRequest(multi, requests, job, RequestKind::Checksums, job.checksumsUrl);
+    }
+}
+
+// Function to handle a finished release check: find out which targets need
+// the release and start its download
+void OnRelease(CURLM* multi, std::list<Request>& requests, Request& request, CURLcode res, long responseCode, const std::vector<std::string>& targets, RateLimit& rateLimit) {
+    ToolJob& job = *request.job;
+
+    RateLimit responseLimit = GetRateLimit(request.responseHeaders);
+    if (responseLimit.remaining >= 0 && (rateLimit.remaining < 0 || responseLimit.remaining < rateLimit.remaining)) {
+        rateLimit.remaining = responseLimit.remaining;
+        rateLimit.reset = responseLimit.reset;
+    }
+    rateLimit.retryAfter = std::max(rateLimit.retryAfter, responseLimit.retryAfter);
+
+    std::string version;
+    if (res != CURLE_OK) {
+        Fail(job, curl_easy_strerror(res));
+        return;
+    } else if (responseCode == 304 && job.haveCache) {
+        // Not modified: the cached release is still the latest one
+        version = job.cache.tagName;
+        job.downloadUrl = job.cache.downloadUrl;
+        job.checksumsUrl = job.cache.checksumsUrl;
+    } else if (responseCode != 200) {
+        Fail(job, "HTTP request failed with response code " + std::to_string(responseCode));
+        return;
+    } else if (!ParseRelease(request.body, job, version)) {
+        return;
+    } else {
+        // Remember the validators for the next check; the version goes where
+        // yt-dlp's cache keeps its tag (not fatal if this fails)
+        ReleaseCache updatedCache;
+        updatedCache.etag = GetHeader(request.responseHeaders, "ETag");
+        updatedCache.lastModified = GetHeader(request.responseHeaders, "Last-Modified");
+        updatedCache.tagName = version;
+        updatedCache.downloadUrl = job.downloadUrl;
+        updatedCache.checksumsUrl = job.checksumsUrl;
+        WriteReleaseCache(job.cachePath, updatedCache);
+    }
+    job.result->version = version;
+    job.assetName = job.downloadUrl.substr(job.downloadUrl.find_last_of('/') + 1);
+
+    // A target needs the release unless it has recorded it and has every file
+    for (size_t i = 0; i < targets.size(); ++i) {
+        bool current = ReadVersionFile(JoinPath(targets[i], job.tool->versionFile)) == version;
+        for (const auto& file : job.tool->files) {
+            std::error_code ec;
+            current = current && fs::exists(JoinPath(targets[i], file), ec);
+        }
+        if (!current) {
+            job.outdated.push_back(i);
+        }
+    }
+
+    if (job.outdated.empty()) {
+        job.result->ok = true;
+        job.result->status = "up to date";
+        return;
+    }
+    StartDownload(multi, requests, job, targets);
+}
+
+// Function to handle a finished checksum listing
+void OnChecksums(Request& request, CURLcode res, long responseCode) {
+    ToolJob& job = *request.job;
+    if (res != CURLE_OK) {
+        Fail(job, std::string("checksums: ") + curl_easy_strerror(res));
+        return;
+    }
+    if (responseCode != 200) {
+        Fail(job, "checksums: HTTP request failed with response code " + std::to_string(responseCode));
+        return;
+    }
+
+    job.expectedSha256 = FindChecksum(request.body, job.assetName);
+    if (job.expectedSha256.empty()) {
+        Fail(job, job.assetName + " is not listed in " + job.tool->checksumsAsset);
+    }
+}
+
+// Function to handle a finished download
+void OnDownload(Request& request, CURLcode res, long responseCode) {
+    ToolJob& job = *request.job;
+    if (job.fp) {
+        if (fclose(job.fp) != 0 && res == CURLE_OK) {
+            Fail(job, "failed to write " + job.tool->files.front());
+        }
+        job.fp = nullptr;
+    }
+
+    if (responseCode != 200) {
+        Fail(job, "download failed with response code " + std::to_string(responseCode));
+    } else if (job.archive && !job.archive->Error().empty()) {
+        Fail(job, "failed to extract " + job.assetName + ": " + job.archive->Error());
+    } else if (res != CURLE_OK) {
+        Fail(job, curl_easy_strerror(res));
+    } else if (job.archive && !job.archive->Finish()) {
+        Fail(job, "failed to extract " + job.assetName + ": " + job.archive->Error());
+    } else {
+        job.downloaded = true;
+    }
+}
+
+// Function to swap staged files in for the installed ones and record the version
+bool SwapInFiles(ToolJob& job, const std::string& vrchatToolsPath) {
+    for (const auto& file : job.tool->files) {
+        std::string stagedPath = JoinPath(vrchatToolsPath, file) + kStagedSuffix;
+        std::string filePath = JoinPath(vrchatToolsPath, file);
+
+        // VRChat's lower integrity level has to be allowed to run what yt-dlp starts
+        std::error_code ec;
+        SetMediumIntegrityLevel(stagedPath);
+        fs::permissions(stagedPath, fs::perms::owner_exec | fs::perms::group_exec | fs::perms::others_exec, fs::perm_options::add, ec);
+        if (!FlushFileToDisk(stagedPath) ||
+            !TimePhase("swap", filePath, [&]() { return ReplaceFileAtomically(stagedPath, filePath); })) {
+            Fail(job, "failed to replace " + filePath);
+            return false;
+        }
+    }
+
+    if (!WriteVersionFile(JoinPath(vrchatToolsPath, job.tool->versionFile), job.result->version)) {
+        Fail(job, "failed to write " + job.tool->versionFile);
+        return false;
+    }
+    return true;
+}
+
+// Function to verify a finished download and install it into every outdated target
+void InstallTool(ToolJob& job, const std::vector<std::string>& targets) {
+    const CompanionTool& tool = *job.tool;
+    if (!tool.checksumsAsset.empty() && !job.expectedSha256.empty()) {
+        std::string actualSha256;
+        if (!job.hasher.Finish(job.received, actualSha256) || actualSha256 != job.expectedSha256) {
+            Fail(job, "SHA-256 mismatch: expected " + job.expectedSha256 + ", got " + actualSha256);
+            return;
+        }
+    }
+    for (const auto& file : tool.files) {
+        std::error_code ec;
+        if (!job.extracted.count(file) || !fs::exists(JoinPath(job.stagingPath, file) + kStagedSuffix, ec)) {
+            Fail(job, file + " is not in " + job.assetName);
+            return;
+        }
+    }
+
+    if (!SwapInFiles(job, job.stagingPath)) {
+        return;
+    }
+
+    // The other targets get the installed files placed as cheaply as their filesystem allows
+    PlacementMethod method = PlacementMethod::Copy;
+    for (size_t index = 1; index < job.outdated.size(); ++index) {
+        const std::string& target = targets[job.outdated[index]];
+        std::error_code ec;
+        fs::create_directories(target, ec);
+        bool allowHardLink = SameOwner(job.stagingPath, target);
+        for (const auto& file : tool.files) {
+            std::string stagedPath = JoinPath(target, file) + kStagedSuffix;
+            fs::remove(stagedPath, ec);
+            if (!TimePhase("place_file", stagedPath, [&]() { return PlaceFile(JoinPath(job.stagingPath, file), stagedPath, allowHardLink, method); })) {
+                Fail(job, "failed to place " + file + " in " + target);
+                return;
+            }
+        }
+        if (!SwapInFiles(job, target)) {
+            return;
+        }
+    }
+
+    job.result->ok = true;
+    job.result->updated = true;
+    job.result->status = "updated (downloaded";
+    if (job.outdated.size() > 1) {
+        job.result->status += std::string(", ") + PlacementMethodName(method) + " into " + std::to_string(job.outdated.size() - 1) + " more";
+    }
+    if (job.expectedSha256.empty()) {
+        job.result->status += ", unverified";
+    }
+    job.result->status += ")";
+}
+
+} // namespace
+
+bool ReadCompanionManifest(const std::string& manifestPath, std::vector<CompanionTool>& tools) {
+    std::ifstream file(manifestPath);
+    if (!file.is_open()) {
+        LogError() << "Failed to open companion manifest: " << manifestPath;
+        return false;
+    }
+
+    tools.clear();
+    std::set<std::string> names;
+    try {
+        json data = json::parse(file);
+        for (const auto& entry : data.at("tools")) {
+            CompanionTool tool;
+            tool.name = entry.at("name").get<std::string>();
+            tool.repo = entry.at("repo").get<std::string>();
+            tool.assetPattern = entry.at("asset").get<std::string>();
+            tool.files = entry.at("files").get<std::vector<std::string>>();
+            tool.versionFile = entry.value("versionFile", tool.name + "-version.txt");
+            tool.checksumsAsset = entry.value("checksums", "");
+
+            // Every name ends up as a file in the Tools directory, next to yt-dlp's own
+            std::string problem;
+            if (!IsPlainFileName(tool.name) || IsReservedName(tool.name) || !names.insert("tool " + tool.name).second) {
+                problem = "the name must be a unique file name other than yt-dlp's";
+            } else if (tool.repo.find('/') == std::string::npos || tool.repo.find_first_of(" ?#") != std::string::npos) {
+                problem = "repo must be \"owner/name\"";
+            } else if (tool.assetPattern.empty() || tool.files.empty()) {
+                problem = "asset and files must not be empty";
+            } else if (!IsPlainFileName(tool.versionFile) || IsReservedName(tool.versionFile) || !names.insert(tool.versionFile).second) {
+                problem = "versionFile must be a unique file name";
+            }
+            for (const auto& name : tool.files) {
+                if (problem.empty() && (!IsPlainFileName(name) || IsReservedName(name) || !names.insert(name).second)) {
+                    problem = "\"" + name + "\" can't be installed (not a plain file name, yt-dlp's, or listed twice)";
+                }
+            }
+            if (!problem.empty()) {
+                LogError() << "Invalid companion tool \"" << tool.name << "\" in " << manifestPath << ": " << problem;
+                return false;
+            }
+            tools.push_back(tool);
+        }
+    } catch (const json::exception& e) {
+        LogError() << "Invalid companion manifest " << manifestPath << ": " << e.what();
+        return false;
+    }
+    return true;
+}
+
+bool UpdateCompanionTools(const std::string& apiBaseUrl, const std::vector<CompanionTool>& tools, const std::vector<std::string>& targets, std::vector<CompanionResult>& results, RateLimit& rateLimit) {
+    results.assign(tools.size(), CompanionResult());
+    std::list<ToolJob> jobs;
+    for (size_t i = 0; i < tools.size(); ++i) {
+        results[i].name = tools[i].name;
+        jobs.emplace_back();
+        ToolJob& job = jobs.back();
+        job.tool = &tools[i];
+        job.result = &results[i];
+        job.cachePath = JoinPath(targets.front(), tools[i].name + "-release.json");
+        job.haveCache = ReadReleaseCache(job.cachePath, job.cache);
+
+        // Files staged by an interrupted run
+        for (const auto& target : targets) {
+            for (const auto& file : tools[i].files) {
+                std::error_code ec;
+                fs::remove(JoinPath(target, file) + kStagedSuffix, ec);
+            }
+        }
+    }
+
+    CURLM* multi = curl_multi_init();
+    if (!multi) {
+        for (auto& job : jobs) {
+            Fail(job, "failed to initialize CURL multi handle");
+        }
+        return false;
+    }
+    ConfigureMultiHandle(multi);
+
+    // Every release check goes out at once; each tool's download joins the loop
+    // as soon as its own check is answered
+    std::list<Request> requests;
+    for (auto& job : jobs) {
+        AddRequest(multi, requests, job, RequestKind::Release, apiBaseUrl + "/repos/" + job.tool->repo + "/releases/latest");
+    }
+
+    while (!requests.empty()) {
+        int running = 0;
+        CURLMcode mc = curl_multi_perform(multi, &running);
+        if (mc == CURLM_OK && running) {
+            mc = curl_multi_poll(multi, NULL, 0, TransferPollTimeoutMs(1000), NULL);
+        }
+        if (mc != CURLM_OK) {
+            for (auto& request : requests) {
+                Fail(*request.job, std::string("curl_multi failed: ") + curl_multi_strerror(mc));
+            }
+            break;
+        }
+
+        CURLMsg* msg = nullptr;
+        int queued = 0;
+        while ((msg = curl_multi_info_read(multi, &queued))) {
+            if (msg->msg != CURLMSG_DONE) {
+                continue;
+            }
+
+            Request* request = nullptr;
+            long responseCode = 0;
+            CURLcode res = msg->data.result;
+            curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, &request);
+            curl_easy_getinfo(msg->easy_handle, CURLINFO_RESPONSE_CODE, &responseCode);
+
+            if (request->kind == RequestKind::Release) {
+                RecordRequestMetrics(msg->easy_handle, "release");
+                if (!request->job->failed) {
+                    OnRelease(multi, requests, *request, res, responseCode, targets, rateLimit);
+                }
+            } else if (request->kind == RequestKind::Checksums) {
+                RecordRequestMetrics(msg->easy_handle, "checksums");
+                if (!request->job->failed) {
+                    OnChecksums(*request, res, responseCode);
+                }
+            } else {
+                RecordRequestMetrics(msg->easy_handle, "download");
+                OnDownload(*request, res, responseCode);
+            }
+            RemoveRequest(multi, requests, request);
+        }
+    }
+
+    // A loop that broke off leaves requests behind
+    while (!requests.empty()) {
+        RemoveRequest(multi, requests, &requests.front());
+    }
+    curl_multi_cleanup(multi);
+
+    // Install what arrived, away from the loop so a slow copy holds up no transfer
+    bool ok = true;
+    for (auto& job : jobs) {
+        if (job.fp) {
+            fclose(job.fp);
+            job.fp = nullptr;
+        }
+        job.archive.reset();
+        if (!job.failed && job.downloaded) {
+            InstallTool(job, targets);
+        }
+        if (job.failed && !job.stagingPath.empty()) {
+            for (const auto& file : job.tool->files) {
+                std::error_code ec;
+                fs::remove(JoinPath(job.stagingPath, file) + kStagedSuffix, ec);
+            }
+        }
+        ok = ok && job.result->ok;
+    }
+    return ok;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "http_headers.h"
+
+// Companion binaries kept up to date next to yt-dlp.exe (ffmpeg for merging
+// formats, a JavaScript runtime for YouTube's challenges, ...), described by a
+// manifest instead of being hard-wired. Every tool's release check, checksum
+// listing and download runs concurrently on a single curl_multi loop, so
+// checking several tools costs about one round trip.
+//
+// The manifest is a JSON file:
+//
+//   {"tools": [{"name": "ffmpeg", "repo": "BtbN/FFmpeg-Builds",
+//               "asset": "ffmpeg-master-latest-win64-gpl.zip",
+//               "files": ["ffmpeg.exe", "ffprobe.exe"],
+//               "versionFile": "ffmpeg-version.txt", "checksums": "checksums.sha256"}]}
+
+// One entry of the manifest
+struct CompanionTool {
+    std::string name;
+    std::string repo;               // GitHub "owner/name" whose latest release is installed
+    std::string assetPattern;       // release asset to download; * and ? match any characters
+    std::vector<std::string> files; // file names installed into the Tools directory; for a zip
+                                    // or gzip asset, the archive entries with these names
+    std::string versionFile;        // where the installed release is recorded (default "<name>-version.txt")
+    std::string checksumsAsset;     // "<hex digest>  <file name>" listing in the release, "" to skip verification
+};
+
+// How one tool's check went
+struct CompanionResult {
+    std::string name;
+    std::string version;            // release tag and asset upload time, "" if the check failed
+    std::string status;             // "up to date", "updated (downloaded)", "failed: ...", ...
+    bool ok = false;
+    bool updated = false;
+};
+
+// Function to read a companion manifest, false if it is missing or invalid
+bool ReadCompanionManifest(const std::string& manifestPath, std::vector<CompanionTool>& tools);
+
+// Function to check every tool's latest release (from apiBaseUrl + "/repos/<repo>/releases/latest")
+// and install it into every target that doesn't have it yet. The first outdated
+// target gets the download; the others get the same files placed from it.
+// Nothing is printed, so this can run alongside the yt-dlp update; results has
+// one entry per tool and rateLimit the lowest API allowance seen. Returns false
+// if any tool failed.
+bool UpdateCompanionTools(const std::string& apiBaseUrl, const std::vector<CompanionTool>& tools, const std::vector<std::string>& targets, std::vector<CompanionResult>& results, RateLimit& rateLimit);
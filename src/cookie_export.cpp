@@ -0,0 +1,494 @@
+#include "cookie_export.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <tuple>
+#include <nlohmann/json.hpp>
+#include <openssl/evp.h>
+#include <sqlite3.h>
+#include "logger.h"
+#include "platform.h"
+
+using json = nlohmann::json;
+namespace fs = std::filesystem;
+
+namespace {
+
+// Seconds from Chromium's epoch (1601-01-01) to the Unix epoch
+const int64_t kChromiumEpochOffset = 11644473600LL;
+
+// From this database version on, Chromium puts the SHA-256 of the host in front
+// of every value before encrypting it
+const int kChromiumHostDigestVersion = 24;
+
+// Firefox has started storing expiry in milliseconds; seconds never get this large
+const int64_t kMillisecondExpiry = 100000000000LL;
+
+const char* const kChromiumBrowsers[] = {"brave", "chrome", "chromium", "edge", "opera", "vivaldi", "whale"};
+
+// Keys for Chromium's cookie values: Windows encrypts with AES-256-GCM under a
+// DPAPI-protected key from "Local State"; Linux uses AES-128-CBC under a key
+// derived from "peanuts" (v10) or from the keyring's password (v11)
+struct ChromiumKeys {
+    std::string gcmKey;
+    std::string v10Key;
+    std::string emptyPasswordKey;
+};
+
+// The database copied to a temporary directory, removed again on destruction
+struct DatabaseCopy {
+    std::string directory;
+    std::string path;
+
+    ~DatabaseCopy() {
+        if (!directory.empty()) {
+            std::error_code ec;
+            fs::remove_all(directory, ec);
+        }
+    }
+};
+
+// Function to split a --cookies-from-browser value into the browser and the
+// profile ("browser[+keyring][:profile][::container]")
+void SplitBrowserSpec(const std::string& spec, std::string& browser, std::string& profile) {
+    size_t browserEnd = spec.find_first_of("+:");
+    browser = spec.substr(0, browserEnd);
+    std::transform(browser.begin(), browser.end(), browser.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+    profile.clear();
+    size_t colon = spec.find(':', browserEnd == std::string::npos ? spec.size() : browserEnd);
+    if (colon != std::string::npos) {
+        size_t containerStart = spec.find("::", colon + 1);
+        profile = spec.substr(colon + 1, containerStart == std::string::npos ? std::string::npos : containerStart - colon - 1);
+    }
+}
+
+bool IsChromiumBrowser(const std::string& browser) {
+    return std::find(std::begin(kChromiumBrowsers), std::end(kChromiumBrowsers), browser) != std::end(kChromiumBrowsers);
+}
+
+// Function to check whether a cookie's host is one of the domains or below one
+bool MatchesDomain(const std::string& host, const std::vector<std::string>& domains) {
+    std::string name = host.empty() || host[0] != '.' ? host : host.substr(1);
+    std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    for (const auto& domain : domains) {
+        if (name == domain || (name.size() > domain.size() && name.compare(name.size() - domain.size(), domain.size(), domain) == 0 &&
+                               name[name.size() - domain.size() - 1] == '.')) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Function to copy the database and its write-ahead log, so it can be read
+// while the browser has it open and without disturbing it
+bool CopyDatabase(const std::string& databasePath, DatabaseCopy& copy) {
+    std::error_code ec;
+    fs::path directory = fs::temp_directory_path(ec) / ("yt-dlp-updater-cookies-" +
+        std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()));
+    if (ec || !fs::create_directories(directory, ec)) {
+        LogError() << "Failed to create a temporary directory for the cookie database: " << ec.message();
+        return false;
+    }
+    copy.directory = directory.string();
+    copy.path = (directory / "cookies.db").string();
+
+    fs::copy_file(databasePath, copy.path, ec);
+    if (!ec && fs::exists(databasePath + "-wal")) {
+        fs::copy_file(databasePath + "-wal", copy.path + "-wal", ec);
+    }
+    if (ec) {
+        LogError() << "Failed to copy " << databasePath << " (is the browser holding it locked?): " << ec.message();
+        return false;
+    }
+    return true;
+}
+
+std::string ColumnText(sqlite3_stmt* statement, int column) {
+    const void* data = sqlite3_column_blob(statement, column);
+    int length = sqlite3_column_bytes(statement, column);
+    return data ? std::string(static_cast<const char*>(data), static_cast<size_t>(length)) : std::string();
+}
+
+// Function to run a query over the copied database, calling row for every result row
+template <typename Row>
+bool QueryDatabase(const std::string& databasePath, const std::string& sql, Row row) {
+    sqlite3* db = nullptr;
+    if (sqlite3_open_v2(databasePath.c_str(), &db, SQLITE_OPEN_READWRITE, nullptr) != SQLITE_OK) {
+        LogError() << "Failed to open the cookie database: " << sqlite3_errmsg(db);
+        sqlite3_close(db);
+        return false;
+    }
+
+    sqlite3_stmt* statement = nullptr;
+    int rc = sqlite3_prepare_v2(db, sql.c_str(), -1, &statement, nullptr);
+    while (rc == SQLITE_OK && (rc = sqlite3_step(statement)) == SQLITE_ROW) {
+        row(statement);
+        rc = SQLITE_OK;
+    }
+    bool ok = rc == SQLITE_DONE;
+    if (!ok) {
+        LogError() << "Failed to read the cookie database: " << sqlite3_errmsg(db);
+    }
+    sqlite3_finalize(statement);
+    sqlite3_close(db);
+    return ok;
+}
+
+bool DecodeBase64(const std::string& encoded, std::string& decoded) {
+    if (encoded.empty() || encoded.size() % 4 != 0) {
+        return false;
+    }
+    decoded.resize(encoded.size() / 4 * 3);
+    int length = EVP_DecodeBlock(reinterpret_cast<unsigned char*>(&decoded[0]), reinterpret_cast<const unsigned char*>(encoded.data()),
+                                 static_cast<int>(encoded.size()));
+    if (length < 0) {
+        return false;
+    }
+    size_t padding = encoded.size() - encoded.find_last_not_of('=') - 1;
+    decoded.resize(static_cast<size_t>(length) - padding);
+    return true;
+}
+
+std::string DeriveLinuxKey(const std::string& password) {
+    unsigned char key[16];
+    const char salt[] = "saltysalt";
+    PKCS5_PBKDF2_HMAC_SHA1(password.data(), static_cast<int>(password.size()), reinterpret_cast<const unsigned char*>(salt),
+                           sizeof(salt) - 1, 1, sizeof(key), key);
+    return std::string(reinterpret_cast<char*>(key), sizeof(key));
+}
+
+// Function to get the AES key from "Local State" (os_crypt.encrypted_key, a
+// DPAPI blob behind a "DPAPI" prefix), "" if there is none or it can't be unprotected
+std::string ReadLocalStateKey(const std::string& localStatePath) {
+    std::ifstream file(localStatePath);
+    if (!file.is_open()) {
+        return "";
+    }
+
+    std::string encrypted;
+    try {
+        json data = json::parse(file);
+        std::string encoded = data.value("os_crypt", json::object()).value("encrypted_key", "");
+        if (!DecodeBase64(encoded, encrypted) || encrypted.compare(0, 5, "DPAPI") != 0) {
+            return "";
+        }
+    } catch (const json::exception&) {
+        return "";
+    }
+
+    std::string key;
+    return UnprotectUserData(encrypted.substr(5), key) ? key : "";
+}
+
+bool DecryptAesCbc(const std::string& key, const std::string& ciphertext, std::string& plain) {
+    const unsigned char iv[16] = {' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' '};
+    EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
+    plain.resize(ciphertext.size() + 16);
+    int length = 0;
+    int finalLength = 0;
+    bool ok = ctx && EVP_DecryptInit_ex(ctx, EVP_aes_128_cbc(), nullptr, reinterpret_cast<const unsigned char*>(key.data()), iv) == 1 &&
+              EVP_DecryptUpdate(ctx, reinterpret_cast<unsigned char*>(&plain[0]), &length,
+                                reinterpret_cast<const unsigned char*>(ciphertext.data()), static_cast<int>(ciphertext.size())) == 1 &&
+              EVP_DecryptFinal_ex(ctx, reinterpret_cast<unsigned char*>(&plain[0]) + length, &finalLength) == 1;
+    EVP_CIPHER_CTX_free(ctx);
+    plain.resize(ok ? static_cast<size_t>(length + finalLength) : 0);
+    return ok;
+}
+
+// Function to decrypt "<12 byte nonce><ciphertext><16 byte tag>"
+bool DecryptAesGcm(const std::string& key, const std::string& sealed, std::string& plain) {
+    if (sealed.size() < 12 + 16) {
+        return false;
+    }
+    std::string nonce = sealed.substr(0, 12);
+    std::string ciphertext = sealed.substr(12, sealed.size() - 12 - 16);
+    std::string tag = sealed.substr(sealed.size() - 16);
+
+    EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
+    plain.resize(ciphertext.size() + 16);
+    int length = 0;
+    int finalLength = 0;
+    bool ok = ctx && EVP_DecryptInit_ex(ctx, EVP_aes_256_gcm(), nullptr, nullptr, nullptr) == 1 &&
+              EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_IVLEN, static_cast<int>(nonce.size()), nullptr) == 1 &&
+              EVP_DecryptInit_ex(ctx, nullptr, nullptr, reinterpret_cast<const unsigned char*>(key.data()),
+                                 reinterpret_cast<const unsigned char*>(nonce.data())) == 1 &&
+              EVP_DecryptUpdate(ctx, reinterpret_cast<unsigned char*>(&plain[0]), &length,
+                                reinterpret_cast<const unsigned char*>(ciphertext.data()), static_cast<int>(ciphertext.size())) == 1 &&
+              EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_TAG, static_cast<int>(tag.size()), &tag[0]) == 1 &&
+              EVP_DecryptFinal_ex(ctx, reinterpret_cast<unsigned char*>(&plain[0]) + length, &finalLength) == 1;
+    EVP_CIPHER_CTX_free(ctx);
+    plain.resize(ok ? static_cast<size_t>(length + finalLength) : 0);
+    return ok;
+}
+
+// Function to decrypt one encrypted_value by its version prefix
+bool DecryptChromiumValue(const std::string& encrypted, const ChromiumKeys& keys, std::string& value) {
+    std::string prefix = encrypted.substr(0, 3);
+    if ((prefix == "v10" || prefix == "v11") && !keys.gcmKey.empty()) {
+        return DecryptAesGcm(keys.gcmKey, encrypted.substr(3), value);
+    }
+    if (prefix == "v10") {
+        return DecryptAesCbc(keys.v10Key, encrypted.substr(3), value);
+    }
+    if (prefix == "v11") {
+        // The keyring's password isn't available to us; a keyring without one still works
+        return DecryptAesCbc(keys.emptyPasswordKey, encrypted.substr(3), value);
+    }
+    if (prefix == "v20") {
+        // App-bound encryption: only the browser's elevated service can decrypt these
+        return false;
+    }
+    // Values from before the versioned formats are DPAPI blobs themselves
+    return UnprotectUserData(encrypted, value);
+}
+
+bool ReadFirefoxCookies(const std::string& databasePath, const std::vector<std::string>& domains, std::vector<ExportedCookie>& cookies) {
+    // Cookies of container tabs are kept apart, as yt-dlp does without a container
+    const char* sql = "SELECT host, path, isSecure, expiry, name, value, isHttpOnly FROM moz_cookies "
+                      "WHERE NOT INSTR(originAttributes, 'userContextId=')";
+    return QueryDatabase(databasePath, sql, [&](sqlite3_stmt* statement) {
+        ExportedCookie cookie;
+        cookie.host = ColumnText(statement, 0);
+        if (!MatchesDomain(cookie.host, domains)) {
+            return;
+        }
+        cookie.path = ColumnText(statement, 1);
+        cookie.secure = sqlite3_column_int(statement, 2) != 0;
+        cookie.expires = sqlite3_column_int64(statement, 3);
+        if (cookie.expires > kMillisecondExpiry) {
+            cookie.expires /= 1000;
+        }
+        cookie.name = ColumnText(statement, 4);
+        cookie.value = ColumnText(statement, 5);
+        cookie.httpOnly = sqlite3_column_int(statement, 6) != 0;
+        cookies.push_back(cookie);
+    });
+}
+
+bool ReadChromiumCookies(const std::string& databasePath, const ChromiumKeys& keys, const std::vector<std::string>& domains, std::vector<ExportedCookie>& cookies, int& undecryptable) {
+    int version = 0;
+    if (!QueryDatabase(databasePath, "SELECT value FROM meta WHERE key = 'version'", [&](sqlite3_stmt* statement) {
+            version = std::atoi(ColumnText(statement, 0).c_str());
+        })) {
+        return false;
+    }
+
+    const char* sql = "SELECT host_key, path, is_secure, expires_utc, name, value, encrypted_value, is_httponly FROM cookies";
+    return QueryDatabase(databasePath, sql, [&](sqlite3_stmt* statement) {
+        ExportedCookie cookie;
+        cookie.host = ColumnText(statement, 0);
+        if (!MatchesDomain(cookie.host, domains)) {
+            return;
+        }
+        cookie.path = ColumnText(statement, 1);
+        cookie.secure = sqlite3_column_int(statement, 2) != 0;
+        int64_t expiresUtc = sqlite3_column_int64(statement, 3);
+        cookie.expires = expiresUtc == 0 ? 0 : expiresUtc / 1000000 - kChromiumEpochOffset;
+        cookie.name = ColumnText(statement, 4);
+        cookie.value = ColumnText(statement, 5);
+        cookie.httpOnly = sqlite3_column_int(statement, 7) != 0;
+
+        std::string encrypted = ColumnText(statement, 6);
+        if (cookie.value.empty() && !encrypted.empty()) {
+            if (!DecryptChromiumValue(encrypted, keys, cookie.value)) {
+                ++undecryptable;
+                return;
+            }
+            if (version >= kChromiumHostDigestVersion && cookie.value.size() >= 32) {
+                cookie.value.erase(0, 32);
+            }
+        }
+        cookies.push_back(cookie);
+    });
+}
+
+} // namespace
+
+const std::vector<std::string>& DefaultCookieDomains() {
+    static const std::vector<std::string> domains = {"youtube.com", "twitch.tv"};
+    return domains;
+}
+
+bool FindCookieSource(const std::string& browserSpec, CookieSource& source) {
+    std::string browser;
+    std::string profile;
+    SplitBrowserSpec(browserSpec, browser, profile);
+    source.browser = browserSpec;
+    source.chromium = IsChromiumBrowser(browser);
+
+    std::string dataPath = GetBrowserDataPath(browser);
+    if (dataPath.empty() && (profile.empty() || profile.find_first_of("/\\") == std::string::npos)) {
+        LogError() << "Exporting cookies from " << browser << " isn't supported here.";
+        return false;
+    }
+
+    std::error_code ec;
+    if (!source.chromium) {
+        // A profile is a directory, its name, or the part of it after the random prefix
+        // ("xxxxxxxx.default-release"); without one the most recently used profile wins
+        fs::path profilePath;
+        if (profile.find_first_of("/\\") != std::string::npos) {
+            profilePath = profile;
+        } else {
+            fs::file_time_type newest;
+            for (fs::directory_iterator it(dataPath, ec), end; !ec && it != end; it.increment(ec)) {
+                std::string name = it->path().filename().string();
+                bool named = name == profile || (name.size() > profile.size() && name.compare(name.size() - profile.size() - 1, std::string::npos, "." + profile) == 0);
+                fs::path cookiesPath = it->path() / "cookies.sqlite";
+                if (!fs::exists(cookiesPath, ec) || (!profile.empty() && !named)) {
+                    continue;
+                }
+                fs::file_time_type modified = fs::last_write_time(cookiesPath, ec);
+                if (profilePath.empty() || modified > newest) {
+                    profilePath = it->path();
+                    newest = modified;
+                }
+            }
+        }
+        if (!profilePath.empty()) {
+            source.databasePath = (profilePath / "cookies.sqlite").string();
+        }
+    } else {
+        // Newer versions keep cookies under Network; Opera has no profile directory
+        fs::path userData = dataPath;
+        fs::path profilePath = userData / (profile.empty() ? "Default" : profile);
+        if (profile.find_first_of("/\\") != std::string::npos) {
+            profilePath = profile;
+            userData = profilePath.parent_path();
+        }
+        std::vector<fs::path> candidates = {profilePath / "Network" / "Cookies", profilePath / "Cookies"};
+        if (profile.empty()) {
+            candidates.push_back(userData / "Network" / "Cookies");
+            candidates.push_back(userData / "Cookies");
+        }
+        for (const auto& candidate : candidates) {
+            if (fs::exists(candidate, ec)) {
+                source.databasePath = candidate.string();
+                break;
+            }
+        }
+        source.localStatePath = (userData / "Local State").string();
+    }
+
+    if (source.databasePath.empty() || !fs::exists(source.databasePath, ec)) {
+        LogError() << "No cookie database found for " << browserSpec << (dataPath.empty() ? "" : " in " + dataPath);
+        return false;
+    }
+    return true;
+}
+
+std::string CookieSourceFingerprint(const CookieSource& source) {
+    std::ostringstream fingerprint;
+    fingerprint << source.databasePath;
+    for (const auto& path : {source.databasePath, source.databasePath + "-wal"}) {
+        std::error_code ec;
+        if (!fs::exists(path, ec)) {
+            continue;
+        }
+        uintmax_t size = fs::file_size(path, ec);
+        auto modified = fs::last_write_time(path, ec).time_since_epoch().count();
+        if (ec) {
+            return "";
+        }
+        fingerprint << "|" << size << "@" << modified;
+    }
+    return fingerprint.str();
+}
+
+bool ReadCookies(const CookieSource& source, const std::vector<std::string>& domains, std::vector<ExportedCookie>& cookies, int& undecryptable) {
+    cookies.clear();
+    undecryptable = 0;
+
+    DatabaseCopy copy;
+    if (!CopyDatabase(source.databasePath, copy)) {
+        return false;
+    }
+
+    bool ok = false;
+    if (source.chromium) {
+        ChromiumKeys keys;
+        keys.gcmKey = ReadLocalStateKey(source.localStatePath);
+        keys.v10Key = DeriveLinuxKey("peanuts");
+        keys.emptyPasswordKey = DeriveLinuxKey("");
+        ok = ReadChromiumCookies(copy.path, keys, domains, cookies, undecryptable);
+    } else {
+        ok = ReadFirefoxCookies(copy.path, domains, cookies);
+    }
+    if (!ok) {
+        return false;
+    }
+
+    // Expired cookies are useless, and a field with a tab or line break would break the format
+    std::time_t now = std::time(nullptr);
+    cookies.erase(std::remove_if(cookies.begin(), cookies.end(), [now](const ExportedCookie& cookie) {
+        std::string fields = cookie.host + cookie.path + cookie.name + cookie.value;
+        return (cookie.expires != 0 && cookie.expires < now) || fields.find_first_of("\t\r\n") != std::string::npos;
+    }), cookies.end());
+
+    // A stable order, so an unchanged set of cookies formats to the same file
+    std::sort(cookies.begin(), cookies.end(), [](const ExportedCookie& a, const ExportedCookie& b) {
+        return std::tie(a.host, a.path, a.name) < std::tie(b.host, b.path, b.name);
+    });
+    return true;
+}
+
+std::string FormatCookieJar(const std::vector<ExportedCookie>& cookies, const std::string& browser) {
+    std::ostringstream jar;
+    jar << "# Netscape HTTP Cookie File\n";
+    jar << "# Exported from " << browser << " by the VRChat yt-dlp updater, which replaces this file when the browser's cookies change.\n\n";
+    for (const auto& cookie : cookies) {
+        jar << (cookie.httpOnly ? "#HttpOnly_" : "") << cookie.host << '\t'
+            << (!cookie.host.empty() && cookie.host[0] == '.' ? "TRUE" : "FALSE") << '\t'
+            << cookie.path << '\t'
+            << (cookie.secure ? "TRUE" : "FALSE") << '\t'
+            << cookie.expires << '\t'
+            << cookie.name << '\t'
+            << cookie.value << '\n';
+    }
+    return jar.str();
+}
+
+bool WriteCookieJar(const std::string& path, const std::string& contents, bool& changed) {
+    changed = false;
+    {
+        std::ifstream existing(path, std::ios::binary);
+        std::ostringstream current;
+        current << existing.rdbuf();
+        if (existing.is_open() && current.str() == contents) {
+            return true;
+        }
+    }
+
+    // Session cookies are as good as a password; nobody else gets to read them
+    std::string tempPath = path + ".tmp";
+    std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        LogError() << "Failed to create " << tempPath;
+        return false;
+    }
+    std::error_code ec;
+    fs::permissions(tempPath, fs::perms::owner_read | fs::perms::owner_write, fs::perm_options::replace, ec);
+
+    file << contents;
+    file.close();
+    if (!file) {
+        LogError() << "Failed to write " << tempPath;
+        fs::remove(tempPath, ec);
+        return false;
+    }
+
+    fs::rename(tempPath, path, ec);
+    if (ec) {
+        LogError() << "Failed to replace " << path << ": " << ec.message();
+        fs::remove(tempPath, ec);
+        return false;
+    }
+    changed = true;
+    return true;
+}
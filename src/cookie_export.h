@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Browser cookies exported for yt-dlp. With --cookies-from-browser yt-dlp copies
+// and decrypts the browser's whole cookie database for every video VRChat
+// loads (and can't while a Chromium browser is running); instead the updater
+// exports the cookies of the few sites that need them into a Netscape
+// cookies.txt next to yt-dlp.exe.
+
+// One cookie, as written to cookies.txt
+struct ExportedCookie {
+    std::string host;           // a leading dot (".youtube.com") also covers subdomains
+    std::string path;
+    std::string name;
+    std::string value;
+    int64_t expires = 0;        // Unix time, 0 for a session cookie
+    bool secure = false;
+    bool httpOnly = false;
+};
+
+// A browser's cookie database and what is needed to read it
+struct CookieSource {
+    std::string browser;        // as given to --cookies-from-browser, e.g. "chrome:Profile 1"
+    bool chromium = false;      // Chromium's schema and encryption, otherwise Firefox's
+    std::string databasePath;
+    std::string localStatePath; // Chromium's "Local State", which holds the key on Windows
+};
+
+// Sites whose cookies are exported unless --cookie-domain says otherwise
+const std::vector<std::string>& DefaultCookieDomains();
+
+// Function to find the cookie database for a --cookies-from-browser value
+// ("firefox", "chrome:Profile 1", "firefox:/path/to/profile"). Without a profile
+// Chromium browsers use "Default" and Firefox the profile used most recently.
+bool FindCookieSource(const std::string& browserSpec, CookieSource& source);
+
+// Function to fingerprint a source's database (size and modification time of it
+// and its write-ahead log), "" if it can't be read. The fingerprint changes
+// whenever the browser writes cookies.
+std::string CookieSourceFingerprint(const CookieSource& source);
+
+// Function to read the unexpired cookies of domains and their subdomains from a
+// copy of the source's database, decrypting Chromium's values. Values that can't
+// be decrypted (e.g. Chrome's app-bound "v20" ones) are left out and counted in
+// undecryptable.
+bool ReadCookies(const CookieSource& source, const std::vector<std::string>& domains, std::vector<ExportedCookie>& cookies, int& undecryptable);
+
+// Function to format cookies as a Netscape cookies.txt, the format of yt-dlp's --cookies
+std::string FormatCookieJar(const std::vector<ExportedCookie>& cookies, const std::string& browser);
+
+// Function to write a cookies.txt readable only by its owner, via a temporary
+// file renamed into place. A file that already has these contents is left
+// alone; changed tells whether it was rewritten.
+bool WriteCookieJar(const std::string& path, const std::string& contents, bool& changed);
@@ -0,0 +1,79 @@
+#include "curl_stream.h"
+
+#include "transfer_context.h"
+
+CurlStreamBuf::CurlStreamBuf(CURL* curl)
+    : curl_(curl), multi_(curl_multi_init()) {
+    curl_easy_setopt(curl_, CURLOPT_WRITEFUNCTION, &CurlStreamBuf::WriteCallback);
+    curl_easy_setopt(curl_, CURLOPT_WRITEDATA, this);
+
+    if (!multi_ || curl_multi_add_handle(multi_, curl_) != CURLM_OK) {
+        done_ = true;
+        result_ = CURLE_FAILED_INIT;
+    }
+}
+
+CurlStreamBuf::~CurlStreamBuf() {
+    if (multi_) {
+        curl_multi_remove_handle(multi_, curl_);
+        curl_multi_cleanup(multi_);
+    }
+}
+
+bool CurlStreamBuf::WaitForBody() {
+    while (pending_.empty() && !done_) {
+        Pump();
+    }
+    return result_ == CURLE_OK;
+}
+
+CurlStreamBuf::int_type CurlStreamBuf::underflow() {
+    if (gptr() < egptr()) {
+        return traits_type::to_int_type(*gptr());
+    }
+
+    while (pending_.empty() && !done_) {
+        Pump();
+    }
+    if (pending_.empty()) {
+        return traits_type::eof();
+    }
+
+    // Hand the received chunk to the reader; the old one's storage is reused
+    current_.swap(pending_);
+    pending_.clear();
+    setg(current_.data(), current_.data(), current_.data() + current_.size());
+    return traits_type::to_int_type(*gptr());
+}
+
+size_t CurlStreamBuf::WriteCallback(char* contents, size_t size, size_t nmemb, void* userp) {
+    CurlStreamBuf* self = static_cast<CurlStreamBuf*>(userp);
+    self->pending_.insert(self->pending_.end(), contents, contents + size * nmemb);
+    return size * nmemb;
+}
+
+void CurlStreamBuf::Pump() {
+    int running = 0;
+    CURLMcode mc = curl_multi_perform(multi_, &running);
+    if (mc != CURLM_OK) {
+        done_ = true;
+        result_ = CURLE_FAILED_INIT;
+        return;
+    }
+
+    if (!running) {
+        done_ = true;
+        CURLMsg* msg = nullptr;
+        int queued = 0;
+        while ((msg = curl_multi_info_read(multi_, &queued))) {
+            if (msg->msg == CURLMSG_DONE) {
+                result_ = msg->data.result;
+            }
+        }
+        return;
+    }
+
+    if (pending_.empty()) {
+        curl_multi_poll(multi_, NULL, 0, TransferPollTimeoutMs(1000), NULL);
+    }
+}
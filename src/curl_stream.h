@@ -0,0 +1,43 @@
+#pragma once
+
+#include <curl/curl.h>
+#include <streambuf>
+#include <vector>
+
+// std::streambuf that reads a response body straight off a curl transfer. The
+// transfer is driven from underflow(), so bytes are pulled only as fast as the
+// reader consumes them and only the most recently received chunk is buffered.
+// Destroying the buffer before the body has been read aborts the transfer.
+class CurlStreamBuf : public std::streambuf {
+public:
+    // The easy handle must be fully configured except for the write callback; it
+    // stays owned by the caller and must outlive this object
+    explicit CurlStreamBuf(CURL* curl);
+    ~CurlStreamBuf() override;
+
+    CurlStreamBuf(const CurlStreamBuf&) = delete;
+    CurlStreamBuf& operator=(const CurlStreamBuf&) = delete;
+
+    // Function to run the transfer until body bytes arrive or it ends, so the
+    // response code can be checked before reading. Returns false on transfer errors.
+    bool WaitForBody();
+
+    // Result of the transfer once it has finished (CURLE_OK while still running)
+    CURLcode Result() const { return result_; }
+
+protected:
+    int_type underflow() override;
+
+private:
+    static size_t WriteCallback(char* contents, size_t size, size_t nmemb, void* userp);
+
+    // Function to drive the transfer until more data is pending or it is done
+    void Pump();
+
+    CURL* curl_;
+    CURLM* multi_;
+    std::vector<char> current_;
+    std::vector<char> pending_;
+    bool done_ = false;
+    CURLcode result_ = CURLE_OK;
+};
@@ -0,0 +1,270 @@
+#include "delta_update.h"
+#include "block_manifest.h"
+#include "logger.h"
+#include "metrics.h"
+#include "segmented_download.h"
+#include "sha256.h"
+#include "transfer_context.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <curl/curl.h>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <unordered_map>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Missing blocks separated by at most this many reusable blocks are fetched in
+// one request; re-downloading a few known blocks is cheaper than another request
+const size_t kMaxMergedGapBlocks = 4;
+
+size_t StringWriteCallback(void* contents, size_t size, size_t nmemb, std::string* userp) {
+    userp->append(static_cast<char*>(contents), size * nmemb);
+    return size * nmemb;
+}
+
+bool FetchBlockManifest(const std::string& manifestUrl, BlockManifest& manifest) {
+    CURL* curl = AcquireEasyHandle();
+    if (!curl) {
+        LogError() << "Failed to initialize CURL";
+        return false;
+    }
+
+    std::string response;
+    curl_easy_setopt(curl, CURLOPT_URL, manifestUrl.c_str());
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, StringWriteCallback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
+    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L); // Follow redirects
+    curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 1L); // Verify SSL certificate
+
+    struct curl_slist* headers = NULL;
+    headers = curl_slist_append(headers, "User-Agent: yt-dlp-updater");
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+
+    CURLcode res = curl_easy_perform(curl);
+
+    long responseCode = 0;
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &responseCode);
+
+    RecordRequestMetrics(curl, "manifest");
+    curl_slist_free_all(headers);
+    ReleaseEasyHandle(curl);
+
+    if (res != CURLE_OK) {
+        LogError() << "Failed to fetch block manifest: " << curl_easy_strerror(res);
+        return false;
+    }
+
+    if (responseCode != 200) {
+        LogError() << "Failed to fetch block manifest, response code: " << responseCode;
+        return false;
+    }
+
+    return ParseBlockManifest(response, manifest);
+}
+
+bool SeekTo(FILE* fp, uint64_t offset) {
+#ifdef _WIN32
+    return _fseeki64(fp, static_cast<long long>(offset), SEEK_SET) == 0;
+#else
+    return fseeko(fp, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+}
+
+// Function to copy every block of the new file that can be found in the seed into
+// the output file. Returns which blocks are present.
+bool CopyMatchingBlocks(const std::vector<unsigned char>& seed, const BlockManifest& manifest, FILE* output, std::vector<bool>& present) {
+    const size_t blockSize = manifest.blockSize;
+    present.assign(manifest.blocks.size(), false);
+    if (seed.size() < blockSize) {
+        return true;
+    }
+
+    // Only full-size blocks can match a full-size window of the seed
+    std::unordered_multimap<uint32_t, size_t> index;
+    size_t fullBlocks = static_cast<size_t>(manifest.fileSize / blockSize);
+    for (size_t i = 0; i < fullBlocks; ++i) {
+        index.emplace(manifest.blocks[i].weak, i);
+    }
+
+    size_t pos = 0;
+    uint32_t weak = WeakChecksum(seed.data(), blockSize);
+    while (true) {
+        bool matched = false;
+        auto candidates = index.equal_range(weak);
+        if (candidates.first != candidates.second) {
+            std::string strong = StrongChecksum(seed.data() + pos, blockSize);
+            for (auto it = candidates.first; it != candidates.second; ++it) {
+                size_t block = it->second;
+                if (manifest.blocks[block].strong != strong) {
+                    continue;
+                }
+                matched = true;
+                if (present[block]) {
+                    continue;
+                }
+                if (!SeekTo(output, static_cast<uint64_t>(block) * blockSize) ||
+                    fwrite(seed.data() + pos, 1, blockSize, output) != blockSize) {
+                    LogError() << "Failed to write reused block " << block;
+                    return false;
+                }
+                present[block] = true;
+            }
+        }
+
+        if (matched) {
+            // Continue with the window right after the matched block
+            pos += blockSize;
+            if (pos + blockSize > seed.size()) {
+                break;
+            }
+            weak = WeakChecksum(seed.data() + pos, blockSize);
+            continue;
+        }
+
+        if (pos + blockSize >= seed.size()) {
+            break;
+        }
+        weak = RollWeakChecksum(weak, seed[pos], seed[pos + blockSize], blockSize);
+        ++pos;
+    }
+    return true;
+}
+
+// Function to turn the missing blocks into as few byte ranges as is reasonable
+std::vector<SegmentProgress> MissingRanges(const BlockManifest& manifest, const std::vector<bool>& present) {
+    std::vector<SegmentProgress> ranges;
+    const uint64_t blockSize = manifest.blockSize;
+
+    for (size_t block = 0; block < present.size(); ++block) {
+        if (present[block]) {
+            continue;
+        }
+
+        curl_off_t start = static_cast<curl_off_t>(block * blockSize);
+        curl_off_t end = static_cast<curl_off_t>(std::min<uint64_t>((block + 1) * blockSize, manifest.fileSize)) - 1;
+
+        if (!ranges.empty()) {
+            uint64_t gapBlocks = (static_cast<uint64_t>(start) - static_cast<uint64_t>(ranges.back().end) - 1) / blockSize;
+            if (gapBlocks <= kMaxMergedGapBlocks) {
+                ranges.back().end = end;
+                continue;
+            }
+        }
+
+        SegmentProgress range;
+        range.start = start;
+        range.end = end;
+        ranges.push_back(range);
+    }
+    return ranges;
+}
+
+} // namespace
+
+bool DeltaDownloadFile(const std::string& url, const std::string& manifestUrl, const std::string& seedPath,
+                       const std::string& outputPath, const std::string& expectedSha256) {
+    BlockManifest manifest;
+    if (!FetchBlockManifest(manifestUrl, manifest)) {
+        return false;
+    }
+
+    if (!expectedSha256.empty() && manifest.sha256 != expectedSha256) {
+        LogError() << "Block manifest describes a different file than the release checksum";
+        return false;
+    }
+
+    // Ranged requests go straight to the resolved URL
+    DownloadProbe probe;
+    if (!ProbeDownload(url, probe)) {
+        return false;
+    }
+    if (!probe.acceptRanges || probe.contentLength != static_cast<curl_off_t>(manifest.fileSize)) {
+        LogError() << "Server does not offer byte ranges of the file described by the manifest";
+        return false;
+    }
+
+    std::vector<unsigned char> seed;
+    {
+        std::ifstream file(seedPath, std::ios::binary);
+        if (!file.is_open()) {
+            LogError() << "Failed to open delta seed: " << seedPath;
+            return false;
+        }
+        seed.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    std::string tempPath = outputPath + ".delta.tmp";
+    FILE* output = fopen(tempPath.c_str(), "wb");
+    if (!output) {
+        LogError() << "Failed to open file for writing: " << tempPath;
+        return false;
+    }
+
+    std::vector<bool> present;
+    bool copied = CopyMatchingBlocks(seed, manifest, output, present);
+    fclose(output);
+    seed.clear();
+    seed.shrink_to_fit();
+
+    std::error_code ec;
+    if (copied) {
+        fs::resize_file(tempPath, manifest.fileSize, ec);
+    }
+    if (!copied || ec) {
+        fs::remove(tempPath, ec);
+        return false;
+    }
+
+    std::vector<SegmentProgress> ranges = MissingRanges(manifest, present);
+    curl_off_t missingBytes = 0;
+    for (const auto& range : ranges) {
+        missingBytes += range.end - range.start + 1;
+    }
+
+    size_t reused = 0;
+    for (bool block : present) {
+        reused += block ? 1 : 0;
+    }
+    LogInfo() << "Delta update: reusing " << reused << " of " << manifest.blocks.size() << " blocks, fetching "
+              << missingBytes << " of " << manifest.fileSize << " bytes in " << ranges.size() << " ranges";
+
+    if (!ranges.empty() && !DownloadSegmented(probe.effectiveUrl, tempPath, static_cast<curl_off_t>(manifest.fileSize), ranges, nullptr)) {
+        fs::remove(tempPath, ec);
+        return false;
+    }
+
+    // Verify the assembled file as a whole
+    DownloadHasher hasher(tempPath);
+    std::string actualSha256;
+    bool hashed = TimePhase("verify_sha256", tempPath, [&]() {
+        return hasher.Finish(static_cast<curl_off_t>(manifest.fileSize), actualSha256);
+    });
+    if (!hashed || actualSha256 != manifest.sha256) {
+        LogError() << "Delta update produced a file with the wrong SHA-256";
+        fs::remove(tempPath, ec);
+        return false;
+    }
+
+    LogInfo() << "Verified SHA-256: " << actualSha256;
+
+    // Replace the output (which may be the seed itself)
+    try {
+        return TimePhase("rename", outputPath, [&]() {
+            if (fs::exists(outputPath)) {
+                fs::remove(outputPath);
+            }
+            fs::rename(tempPath, outputPath);
+            return true;
+        });
+    } catch (const std::exception& e) {
+        LogError() << "Failed to rename temporary file: " << e.what();
+        fs::remove(tempPath, ec);
+        return false;
+    }
+}
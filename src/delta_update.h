@@ -0,0 +1,13 @@
+#pragma once
+
+#include <string>
+
+// Function to update outputPath to the file at url by reusing the blocks it shares
+// with seedPath (usually the currently installed version of the same file). The
+// block manifest at manifestUrl describes the new file; blocks found anywhere in
+// the seed are copied locally and only the rest is fetched with HTTP Range
+// requests. The assembled file must match the manifest's SHA-256 and, if given,
+// expectedSha256 before it replaces outputPath. seedPath and outputPath may be
+// the same file.
+bool DeltaDownloadFile(const std::string& url, const std::string& manifestUrl, const std::string& seedPath,
+                       const std::string& outputPath, const std::string& expectedSha256);
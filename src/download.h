@@ -0,0 +1,39 @@
+#pragma once
+
+#include "sha256.h"
+
+#include <curl/curl.h>
+#include <string>
+#include <vector>
+
+// Function to download a file over a single connection into tempPath, continuing
+// from resumeFrom bytes when it is non-zero. bytesOnDisk receives how much of the
+// file is present afterwards (also on failure) and contentLength the expected
+// total size, if the server reported one. Written bytes are also fed to hasher,
+// if given.
+bool DownloadSingleStream(const std::string& url, const std::string& tempPath, curl_off_t resumeFrom, curl_off_t& bytesOnDisk, curl_off_t& contentLength, DownloadHasher* hasher);
+
+// Function to download a file to outputPath via outputPath + ".tmp". Transient
+// failures are retried with exponential backoff; when the server supports byte
+// ranges the partial file and a ".tmp.resume" sidecar are kept so retries (and
+// later runs) continue where the transfer stopped. If expectedSha256 is not
+// empty the file is hashed while it is written and rejected on a mismatch.
+bool DownloadFile(const std::string& url, const std::string& outputPath, const std::string& expectedSha256);
+
+// Function to download a file like above from the first of sources that works
+// (see RankAssetSources). A failed attempt moves on to the next source instead
+// of waiting to retry the same one, and a partial file is continued from any
+// source that has a file of the same size, the checksum being the judge.
+bool DownloadFile(const std::vector<std::string>& sources, const std::string& outputPath, const std::string& expectedSha256);
+
+// Function to download a zip or gzip archive (told apart by the URL's file
+// name) and extract the entry called entryName to outputPath while the archive
+// streams in; the archive itself is never written to disk. Other entries are
+// only checked. For gzip the single member is the entry. expectedSha256, if not
+// empty, is the archive's checksum. Retries start over, there is no resume.
+bool DownloadAndExtract(const std::string& url, const std::string& entryName, const std::string& outputPath, const std::string& expectedSha256);
+
+// Function to download a zip archive and extract all of it under outputDirectory
+// (replacing whatever was there) while it streams in. The directory is removed
+// again if the archive is broken or doesn't match expectedSha256.
+bool DownloadAndExtractTree(const std::string& url, const std::string& outputDirectory, const std::string& expectedSha256);
@@ -0,0 +1,70 @@
+#include "fan_out.h"
+
+#include <atomic>
+#include <filesystem>
+#include <thread>
+#include <vector>
+#include "logger.h"
+#include "platform.h"
+
+namespace fs = std::filesystem;
+
+const char* PlacementMethodName(PlacementMethod method) {
+    switch (method) {
+    case PlacementMethod::HardLink:
+        return "hard link";
+    case PlacementMethod::Reflink:
+        return "reflink";
+    default:
+        return "copy";
+    }
+}
+
+bool PlaceFile(const std::string& source, const std::string& target, bool allowHardLink, PlacementMethod& method) {
+    std::error_code ec;
+
+    // Fails across volumes and on filesystems without links; fall through then
+    if (allowHardLink) {
+        fs::create_hard_link(source, target, ec);
+        if (!ec) {
+            method = PlacementMethod::HardLink;
+            return true;
+        }
+    }
+
+    if (CloneFile(source, target)) {
+        method = PlacementMethod::Reflink;
+        return true;
+    }
+
+    fs::copy_file(source, target, ec);
+    if (ec) {
+        LogError() << "Failed to copy " << source << " to " << target << ": " << ec.message();
+        return false;
+    }
+    method = PlacementMethod::Copy;
+    return true;
+}
+
+void RunParallel(size_t count, size_t workers, const std::function<void(size_t)>& task) {
+    if (workers > count) {
+        workers = count;
+    }
+
+    // Each worker keeps taking the next unclaimed index until none are left
+    std::atomic<size_t> next(0);
+    auto worker = [&]() {
+        for (size_t index = next++; index < count; index = next++) {
+            task(index);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < workers; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
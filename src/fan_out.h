@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+
+// How a file was put in place by PlaceFile
+enum class PlacementMethod {
+    HardLink,   // same file, no extra space
+    Reflink,    // copy-on-write clone sharing the source's extents
+    Copy        // independent copy
+};
+
+// Function to get a short name for a placement method, for summaries
+const char* PlacementMethodName(PlacementMethod method);
+
+// Function to put the contents of source at target (which must not exist yet),
+// as cheaply as the filesystem allows: a hard link when allowHardLink is set,
+// otherwise or failing that a reflink, and a plain copy as the last resort
+bool PlaceFile(const std::string& source, const std::string& target, bool allowHardLink, PlacementMethod& method);
+
+// Function to run task(0) .. task(count - 1) on at most workers threads and wait for all of them
+void RunParallel(size_t count, size_t workers, const std::function<void(size_t)>& task);
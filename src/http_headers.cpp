@@ -0,0 +1,64 @@
+#include "http_headers.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+
+namespace {
+
+std::string ToLower(std::string value) {
+    std::transform(value.begin(), value.end(), value.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return value;
+}
+
+std::string Trim(const std::string& value) {
+    size_t begin = value.find_first_not_of(" \t\r\n");
+    if (begin == std::string::npos) {
+        return "";
+    }
+    size_t end = value.find_last_not_of(" \t\r\n");
+    return value.substr(begin, end - begin + 1);
+}
+
+// Function to parse a non-negative integer header value, -1 if absent or malformed
+long long ParseCount(const std::string& value) {
+    if (value.empty() || value.find_first_not_of("0123456789") != std::string::npos) {
+        return -1;
+    }
+    return std::strtoll(value.c_str(), nullptr, 10);
+}
+
+} // namespace
+
+size_t HeaderCallback(char* buffer, size_t size, size_t nitems, HttpHeaders* headers) {
+    size_t length = size * nitems;
+    std::string line(buffer, length);
+
+    // A status line starts a new response (e.g. after following a redirect)
+    if (line.compare(0, 5, "HTTP/") == 0) {
+        headers->clear();
+        return length;
+    }
+
+    size_t colon = line.find(':');
+    if (colon != std::string::npos) {
+        (*headers)[ToLower(Trim(line.substr(0, colon)))] = Trim(line.substr(colon + 1));
+    }
+
+    return length;
+}
+
+std::string GetHeader(const HttpHeaders& headers, const std::string& name) {
+    auto it = headers.find(ToLower(name));
+    return it != headers.end() ? it->second : "";
+}
+
+RateLimit GetRateLimit(const HttpHeaders& headers) {
+    RateLimit rateLimit;
+    rateLimit.remaining = static_cast<long>(ParseCount(GetHeader(headers, "X-RateLimit-Remaining")));
+    long long reset = ParseCount(GetHeader(headers, "X-RateLimit-Reset"));
+    rateLimit.reset = reset > 0 ? static_cast<std::time_t>(reset) : 0;
+    rateLimit.retryAfter = static_cast<long>(ParseCount(GetHeader(headers, "Retry-After")));
+    return rateLimit;
+}
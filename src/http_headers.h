@@ -0,0 +1,26 @@
+#pragma once
+
+#include <ctime>
+#include <map>
+#include <string>
+
+// Response headers captured from a transfer, keyed by lower-cased field name
+using HttpHeaders = std::map<std::string, std::string>;
+
+// CURLOPT_HEADERFUNCTION callback that collects response headers into an HttpHeaders map.
+// The map is cleared whenever a new status line arrives, so after redirects it only
+// holds the headers of the final response.
+size_t HeaderCallback(char* buffer, size_t size, size_t nitems, HttpHeaders* headers);
+
+// Function to look up a header by (case-insensitive) name, returns "" if not present
+std::string GetHeader(const HttpHeaders& headers, const std::string& name);
+
+// Rate limit state announced by the server; -1 / 0 where a header was absent
+struct RateLimit {
+    long remaining = -1;        // X-RateLimit-Remaining: requests left in the window
+    std::time_t reset = 0;      // X-RateLimit-Reset: when the window refills (Unix time)
+    long retryAfter = -1;       // Retry-After: seconds to wait before the next request
+};
+
+// Function to read GitHub's X-RateLimit-* and Retry-After headers
+RateLimit GetRateLimit(const HttpHeaders& headers);
@@ -0,0 +1,142 @@
+#include "launch_latency.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <nlohmann/json.hpp>
+#include "asset_variant.h"
+#include "logger.h"
+#include "platform.h"
+
+using json = nlohmann::json;
+namespace fs = std::filesystem;
+
+namespace {
+
+// Function to run the executable once with --version, ms receives the wall time
+bool TimeLaunch(const std::string& executablePath, double& ms) {
+    auto start = std::chrono::steady_clock::now();
+    int exitCode = 0;
+    if (!RunProcess(executablePath, {"--version"}, exitCode)) {
+        return false;
+    }
+    ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    if (exitCode != 0) {
+        LogError() << executablePath << " --version exited with code " << exitCode;
+        return false;
+    }
+    return true;
+}
+
+// Function to evict the executable and an onedir build's libraries from the page cache
+void DropInstallFromCache(const std::string& executablePath) {
+    DropFromFileCache(executablePath);
+
+    std::error_code ec;
+    fs::path libraries = fs::path(executablePath).parent_path() / kOneDirLibraryName;
+    for (fs::recursive_directory_iterator it(libraries, ec), end; !ec && it != end; it.increment(ec)) {
+        if (it->is_regular_file(ec)) {
+            DropFromFileCache(it->path().string());
+        }
+    }
+}
+
+} // namespace
+
+bool MeasureLaunchLatency(const std::string& executablePath, int warmRuns, LaunchLatency& latency) {
+    DropInstallFromCache(executablePath);
+    if (!TimeLaunch(executablePath, latency.coldMs)) {
+        return false;
+    }
+
+    std::vector<double> warm;
+    for (int run = 0; run < warmRuns; ++run) {
+        double ms = 0;
+        if (!TimeLaunch(executablePath, ms)) {
+            return false;
+        }
+        warm.push_back(ms);
+    }
+
+    std::sort(warm.begin(), warm.end());
+    latency.warmRuns = warmRuns;
+    latency.warmMedianMs = warm.empty() ? latency.coldMs : warm[warm.size() / 2];
+    latency.warmMinMs = warm.empty() ? latency.coldMs : warm.front();
+    return true;
+}
+
+bool ReadLaunchChoice(const std::string& path, LaunchChoice& choice) {
+    if (!fs::exists(path)) {
+        return false;
+    }
+
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        LogError() << "Failed to open " << path;
+        return false;
+    }
+
+    try {
+        json data = json::parse(file);
+        choice.variant = data.value("variant", "");
+        choice.tag = data.value("tag", "");
+        choice.measurements.clear();
+        for (const auto& entry : data.value("measurements", json::array())) {
+            LaunchLatency latency;
+            latency.variant = entry.value("variant", "");
+            latency.coldMs = entry.value("cold_ms", 0.0);
+            latency.warmMedianMs = entry.value("warm_ms", 0.0);
+            latency.warmMinMs = entry.value("warm_ms_min", 0.0);
+            latency.warmRuns = entry.value("warm_runs", 0);
+            choice.measurements.push_back(latency);
+        }
+    } catch (const json::exception& e) {
+        LogWarning() << "Ignoring invalid launch measurements: " << e.what();
+        return false;
+    }
+
+    return FindAssetVariant(choice.variant) != nullptr;
+}
+
+bool WriteLaunchChoice(const std::string& path, const LaunchChoice& choice) {
+    json measurements = json::array();
+    for (const auto& latency : choice.measurements) {
+        measurements.push_back({
+            {"variant", latency.variant},
+            {"cold_ms", latency.coldMs},
+            {"warm_ms", latency.warmMedianMs},
+            {"warm_ms_min", latency.warmMinMs},
+            {"warm_runs", latency.warmRuns}
+        });
+    }
+    json data = {
+        {"variant", choice.variant},
+        {"tag", choice.tag},
+        {"measurements", measurements}
+    };
+
+    std::string tempPath = path + ".tmp";
+    std::ofstream file(tempPath, std::ios::trunc);
+    if (!file.is_open()) {
+        LogError() << "Failed to create " << tempPath;
+        return false;
+    }
+
+    file << data.dump(2);
+    file.close();
+    if (!file) {
+        LogError() << "Failed to write " << tempPath;
+        fs::remove(tempPath);
+        return false;
+    }
+
+    std::error_code ec;
+    fs::rename(tempPath, path, ec);
+    if (ec) {
+        LogError() << "Failed to replace " << path << ": " << ec.message();
+        fs::remove(tempPath);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Start-up time of a yt-dlp build. VRChat launches yt-dlp.exe for every video
+// it loads, so how fast a build gets going matters more than its download size.
+
+// Launch times of one installed build, in milliseconds
+struct LaunchLatency {
+    std::string variant;
+    double coldMs = 0;          // first launch, with the install evicted from the page cache
+    double warmMedianMs = 0;    // median of the launches after it
+    double warmMinMs = 0;
+    int warmRuns = 0;
+};
+
+// Function to launch an installed yt-dlp with --version, once cold and then
+// warmRuns times warm, and time each run until it exits. Fails if it can't be
+// started or exits with an error.
+bool MeasureLaunchLatency(const std::string& executablePath, int warmRuns, LaunchLatency& latency);
+
+// The variant picked by measuring, remembered in the Tools directory so the
+// measurement runs only once
+struct LaunchChoice {
+    std::string variant;
+    std::string tag;                            // release the measurement was made with
+    std::vector<LaunchLatency> measurements;
+};
+
+// Function to read the remembered choice, false if there is none
+bool ReadLaunchChoice(const std::string& path, LaunchChoice& choice);
+
+// Function to write the choice (written to a temporary file and renamed into place)
+bool WriteLaunchChoice(const std::string& path, const LaunchChoice& choice);
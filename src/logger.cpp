@@ -0,0 +1,308 @@
+#include "logger.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+namespace fs = std::filesystem;
+
+namespace {
+
+// Messages the ring holds; a logger that falls this far behind makes callers wait
+const size_t kRingSize = 1024;
+
+// How long the writer sleeps before looking for messages a wake-up missed
+const std::chrono::milliseconds kWriterIdleWait(50);
+
+struct LogRecord {
+    LogLevel level = LogLevel::Info;
+    std::chrono::system_clock::time_point time;
+    std::string message;
+};
+
+// A slot of the ring. Its sequence says whose turn it is: position p may be
+// written when it equals p and read when it equals p + 1 (bounded MPMC queue
+// after Dmitry Vyukov, with the writer thread as the only consumer).
+struct Slot {
+    std::atomic<size_t> sequence{0};
+    LogRecord record;
+};
+
+Slot g_ring[kRingSize];
+alignas(64) std::atomic<size_t> g_enqueuePosition{0};
+alignas(64) size_t g_dequeuePosition = 0;  // only touched by the writer
+
+std::atomic<bool> g_running{false};
+std::atomic<int> g_level{static_cast<int>(LogLevel::Info)};
+LogOptions g_options;
+std::thread g_writer;
+std::atomic<bool> g_stopping{false};
+
+// Wake-ups for the writer; callers only notify, they never take the mutex
+std::mutex g_wakeMutex;
+std::condition_variable g_wake;
+std::atomic<bool> g_writerSleeping{false};
+
+// Progress of the writer, for FlushLog
+std::mutex g_flushMutex;
+std::condition_variable g_flushed;
+size_t g_written = 0;
+
+std::ofstream g_file;
+uintmax_t g_fileBytes = 0;
+
+// Serializes direct writes while the logger isn't running
+std::mutex g_directMutex;
+
+// Console output held back while a prompt is shown (see HoldConsoleLog); only
+// touched by the writer
+std::atomic<bool> g_consoleHeld{false};
+std::vector<LogRecord> g_heldRecords;
+
+const char* LevelName(LogLevel level) {
+    switch (level) {
+    case LogLevel::Debug: return "debug";
+    case LogLevel::Info: return "info";
+    case LogLevel::Warning: return "warning";
+    case LogLevel::Error: return "error";
+    }
+    return "info";
+}
+
+std::ostream& ConsoleStream(LogLevel level) {
+    return level >= LogLevel::Warning ? std::cerr : std::cout;
+}
+
+// Function to claim the next slot and publish record in it; waits for the
+// writer only if the ring is full
+void Enqueue(LogRecord&& record) {
+    size_t position = g_enqueuePosition.load(std::memory_order_relaxed);
+    Slot* slot = nullptr;
+    for (;;) {
+        slot = &g_ring[position % kRingSize];
+        size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        if (sequence == position) {
+            if (g_enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (sequence < position) {
+            // Full: let the writer catch up
+            g_wake.notify_one();
+            std::this_thread::yield();
+            position = g_enqueuePosition.load(std::memory_order_relaxed);
+        } else {
+            position = g_enqueuePosition.load(std::memory_order_relaxed);
+        }
+    }
+    slot->record = std::move(record);
+    slot->sequence.store(position + 1, std::memory_order_release);
+
+    if (g_writerSleeping.exchange(false)) {
+        g_wake.notify_one();
+    }
+}
+
+// Function to take the oldest published record, false if there is none
+bool Dequeue(LogRecord& record) {
+    Slot& slot = g_ring[g_dequeuePosition % kRingSize];
+    if (slot.sequence.load(std::memory_order_acquire) != g_dequeuePosition + 1) {
+        return false;
+    }
+    record = std::move(slot.record);
+    slot.sequence.store(g_dequeuePosition + kRingSize, std::memory_order_release);
+    ++g_dequeuePosition;
+    return true;
+}
+
+// Function to move <file> to <file>.1, <file>.1 to <file>.2 and so on, dropping the oldest
+void RotateLogFile() {
+    g_file.close();
+    std::error_code ec;
+    const std::string& path = g_options.filePath;
+    fs::remove(path + "." + std::to_string(g_options.keepFiles), ec);
+    for (int i = g_options.keepFiles - 1; i >= 1; --i) {
+        fs::rename(path + "." + std::to_string(i), path + "." + std::to_string(i + 1), ec);
+    }
+    if (g_options.keepFiles > 0) {
+        fs::rename(path, path + ".1", ec);
+    } else {
+        fs::remove(path, ec);
+    }
+    g_file.open(path, std::ios::binary | std::ios::app);
+    g_fileBytes = 0;
+}
+
+std::string FormatJsonLine(const LogRecord& record) {
+    std::time_t seconds = std::chrono::system_clock::to_time_t(record.time);
+    auto milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(record.time.time_since_epoch()).count() % 1000;
+    char timestamp[32];
+    std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%S", std::gmtime(&seconds));
+    char fraction[8];
+    std::snprintf(fraction, sizeof(fraction), ".%03dZ", static_cast<int>(milliseconds));
+
+    // Written by hand to keep the fields in this order; only the message needs escaping
+    return std::string("{\"time\":\"") + timestamp + fraction + "\",\"level\":\"" + LevelName(record.level) +
+           "\",\"message\":" + json(record.message).dump(-1, ' ', false, json::error_handler_t::replace) + "}\n";
+}
+
+void WriteRecord(const LogRecord& record) {
+    // Once something is held, everything after it waits too, to keep the order
+    if (g_consoleHeld.load() || !g_heldRecords.empty()) {
+        g_heldRecords.push_back(record);
+    } else {
+        ConsoleStream(record.level) << record.message << '\n';
+    }
+
+    if (g_file.is_open()) {
+        std::string line = FormatJsonLine(record);
+        if (g_fileBytes > 0 && g_fileBytes + line.size() > g_options.maxFileBytes) {
+            RotateLogFile();
+        }
+        g_file << line;
+        g_fileBytes += line.size();
+    }
+}
+
+// Function to write everything queued, flushing the outputs once per batch
+void Drain() {
+    LogRecord record;
+    bool wrote = false;
+    while (Dequeue(record)) {
+        WriteRecord(record);
+        wrote = true;
+    }
+    if (!g_consoleHeld.load() && !g_heldRecords.empty()) {
+        for (const auto& held : g_heldRecords) {
+            ConsoleStream(held.level) << held.message << '\n';
+        }
+        g_heldRecords.clear();
+        wrote = true;
+    }
+    if (!wrote) {
+        return;
+    }
+    std::cout.flush();
+    std::cerr.flush();
+    if (g_file.is_open()) {
+        g_file.flush();
+    }
+
+    std::lock_guard<std::mutex> lock(g_flushMutex);
+    g_written = g_dequeuePosition;
+    g_flushed.notify_all();
+}
+
+void WriterLoop() {
+    for (;;) {
+        Drain();
+        if (g_stopping.load()) {
+            break;
+        }
+
+        // Sleep until a caller enqueues; the timeout covers a wake-up sent
+        // between the check and the wait
+        g_writerSleeping.store(true);
+        std::unique_lock<std::mutex> lock(g_wakeMutex);
+        g_wake.wait_for(lock, kWriterIdleWait, [] { return !g_writerSleeping.load() || g_stopping.load(); });
+        g_writerSleeping.store(false);
+    }
+}
+
+} // namespace
+
+bool StartLogging(const LogOptions& options) {
+    if (g_running.load()) {
+        return true;
+    }
+    g_options = options;
+    g_level.store(static_cast<int>(options.level));
+
+    if (!options.filePath.empty()) {
+        g_file.open(options.filePath, std::ios::binary | std::ios::app);
+        if (!g_file.is_open()) {
+            std::cerr << "Failed to open log file: " << options.filePath << std::endl;
+            return false;
+        }
+        std::error_code ec;
+        g_fileBytes = fs::file_size(options.filePath, ec);
+        if (ec) {
+            g_fileBytes = 0;
+        }
+    }
+
+    size_t position = g_enqueuePosition.load();
+    for (size_t i = 0; i < kRingSize; ++i) {
+        g_ring[(position + i) % kRingSize].sequence.store(position + i);
+    }
+    g_dequeuePosition = position;
+    g_written = position;
+    g_stopping.store(false);
+    g_writer = std::thread(WriterLoop);
+    g_running.store(true);
+    return true;
+}
+
+void FlushLog() {
+    if (!g_running.load()) {
+        std::cout.flush();
+        return;
+    }
+    size_t target = g_enqueuePosition.load();
+    g_writerSleeping.store(false);
+    g_wake.notify_one();
+    std::unique_lock<std::mutex> lock(g_flushMutex);
+    g_flushed.wait(lock, [target] { return g_written >= target; });
+}
+
+void StopLogging() {
+    if (!g_running.exchange(false)) {
+        return;
+    }
+    g_stopping.store(true);
+    g_consoleHeld.store(false);
+    g_wake.notify_one();
+    g_writer.join();
+
+    // Whatever a caller managed to enqueue while the writer was stopping
+    Drain();
+    g_file.close();
+}
+
+void HoldConsoleLog(bool hold) {
+    g_consoleHeld.store(hold);
+    if (!hold) {
+        g_writerSleeping.store(false);
+        g_wake.notify_one();
+    }
+}
+
+bool LogEnabled(LogLevel level) {
+    return static_cast<int>(level) >= g_level.load(std::memory_order_relaxed);
+}
+
+void LogMessage(LogLevel level, std::string message) {
+    if (!LogEnabled(level)) {
+        return;
+    }
+    if (!g_running.load(std::memory_order_acquire)) {
+        std::lock_guard<std::mutex> lock(g_directMutex);
+        ConsoleStream(level) << message << std::endl;
+        return;
+    }
+
+    LogRecord record;
+    record.level = level;
+    record.time = std::chrono::system_clock::now();
+    record.message = std::move(message);
+    Enqueue(std::move(record));
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <sstream>
+#include <string>
+
+// Logging for the updater. Messages are written by a background thread, so a
+// log line costs its caller one enqueue on a lock-free ring buffer instead of a
+// console flush (which is slow on Windows consoles). Info and debug messages go
+// to stdout, warnings and errors to stderr, and everything can also be written
+// to a file as JSON lines.
+//
+//   LogInfo() << "Downloaded " << bytes << " bytes";
+//
+// Until StartLogging (and after StopLogging) messages are written directly,
+// so tools that never start the logger print as before.
+
+enum class LogLevel {
+    Debug,      // per-step diagnostics (attributes, ...), shown with --verbose
+    Info,
+    Warning,
+    Error,
+};
+
+// Process-wide logging settings
+struct LogOptions {
+    LogLevel level = LogLevel::Info;        // least severe level written
+    std::string filePath;                   // JSON lines log, "" for none
+    uintmax_t maxFileBytes = 10 * 1024 * 1024; // size at which the file is rotated
+    int keepFiles = 3;                      // rotated files kept as <file>.1 ... <file>.N
+};
+
+// Function to start the background writer (and open the log file)
+bool StartLogging(const LogOptions& options);
+
+// Function to wait until every message logged so far has been written, e.g.
+// before prompting on the console
+void FlushLog();
+
+// Function to hold back (or, with false, release) what other threads log to
+// the console while a prompt is shown, so it doesn't end up in the middle of
+// the prompt. The log file is written meanwhile as usual.
+void HoldConsoleLog(bool hold);
+
+// Function to write what is still queued and stop the background writer
+void StopLogging();
+
+// Function to check whether messages of a level are written at all
+bool LogEnabled(LogLevel level);
+
+// Function to log one message (without a trailing line break)
+void LogMessage(LogLevel level, std::string message);
+
+// One log message, built with << and logged when it goes out of scope.
+// Nothing is formatted for a level that isn't written.
+class LogLine {
+public:
+    explicit LogLine(LogLevel level) : level_(level), enabled_(LogEnabled(level)) {}
+    ~LogLine() {
+        if (enabled_) {
+            LogMessage(level_, stream_.str());
+        }
+    }
+
+    LogLine(const LogLine&) = delete;
+    LogLine& operator=(const LogLine&) = delete;
+
+    template <typename T>
+    LogLine& operator<<(const T& value) {
+        if (enabled_) {
+            stream_ << value;
+        }
+        return *this;
+    }
+
+    // Manipulators such as std::fixed
+    LogLine& operator<<(std::ios_base& (*manipulator)(std::ios_base&)) {
+        if (enabled_) {
+            stream_ << manipulator;
+        }
+        return *this;
+    }
+
+private:
+    LogLevel level_;
+    bool enabled_;
+    std::ostringstream stream_;
+};
+
+inline LogLine LogDebug() { return LogLine(LogLevel::Debug); }
+inline LogLine LogInfo() { return LogLine(LogLevel::Info); }
+inline LogLine LogWarning() { return LogLine(LogLevel::Warning); }
+inline LogLine LogError() { return LogLine(LogLevel::Error); }
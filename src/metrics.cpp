@@ -0,0 +1,303 @@
+#include "metrics.h"
+
+#include <algorithm>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "logger.h"
+#include "transfer_context.h"
+
+using json = nlohmann::json;
+namespace fs = std::filesystem;
+
+namespace {
+
+struct PhaseMetrics {
+    std::string label;
+    std::string path;
+    int64_t durationUs = 0;
+};
+
+// The run being collected; installs into several targets record from worker threads
+std::mutex g_metricsMutex;
+std::time_t g_runStarted = 0;
+std::chrono::steady_clock::time_point g_runStart;
+std::vector<RequestMetrics> g_requests;
+std::vector<PhaseMetrics> g_phases;
+TransferStats g_transfersAtStart;   // to tell this run's throttling from earlier runs
+
+// Durations of the request phases, derived from curl's cumulative times
+struct RequestPhases {
+    curl_off_t dns = 0;
+    curl_off_t connect = 0;
+    curl_off_t tls = 0;
+    curl_off_t ttfb = 0;        // request sent until the first response byte
+    curl_off_t transfer = 0;    // first to last byte
+};
+
+RequestPhases SplitPhases(const RequestMetrics& request) {
+    // Reused connections report 0 for the steps they skipped
+    curl_off_t connected = std::max(request.nameLookupUs, request.connectUs);
+    curl_off_t secured = std::max(connected, request.appConnectUs);
+    curl_off_t firstByte = std::max(secured, request.startTransferUs);
+
+    RequestPhases phases;
+    phases.dns = request.nameLookupUs;
+    phases.connect = connected - request.nameLookupUs;
+    phases.tls = secured - connected;
+    phases.ttfb = firstByte - secured;
+    phases.transfer = std::max<curl_off_t>(0, request.totalUs - firstByte);
+    return phases;
+}
+
+// Function to write contents to path through a temporary file, so readers
+// (e.g. node_exporter's textfile collector) never see a partial file
+bool WriteFileAtomically(const std::string& path, const std::string& contents) {
+    std::string tempPath = path + ".tmp";
+    std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        LogError() << "Failed to create metrics file: " << tempPath;
+        return false;
+    }
+
+    file << contents;
+    file.close();
+    if (!file) {
+        LogError() << "Failed to write metrics file: " << tempPath;
+        fs::remove(tempPath);
+        return false;
+    }
+
+    std::error_code ec;
+    fs::rename(tempPath, path, ec);
+    if (ec) {
+        LogError() << "Failed to replace metrics file " << path << ": " << ec.message();
+        fs::remove(tempPath);
+        return false;
+    }
+    return true;
+}
+
+double Seconds(int64_t microseconds) {
+    return static_cast<double>(microseconds) / 1e6;
+}
+
+// Rate limiting and idle pauses applied during the run
+struct QosMetrics {
+    int64_t throttledMs = 0;
+    int64_t pausedMs = 0;
+    long pauses = 0;
+};
+
+QosMetrics RunQos() {
+    TransferStats now = GetTransferStats();
+    QosMetrics qos;
+    qos.throttledMs = now.throttledMs - g_transfersAtStart.throttledMs;
+    qos.pausedMs = now.pausedMs - g_transfersAtStart.pausedMs;
+    qos.pauses = now.pauses - g_transfersAtStart.pauses;
+    return qos;
+}
+
+std::string BuildReport(double runSeconds, bool ok, bool updated) {
+    json requests = json::array();
+    for (const auto& request : g_requests) {
+        RequestPhases phases = SplitPhases(request);
+        requests.push_back({
+            {"label", request.label},
+            {"url", request.url},
+            {"response_code", request.responseCode},
+            {"namelookup_us", request.nameLookupUs},
+            {"connect_us", request.connectUs},
+            {"appconnect_us", request.appConnectUs},
+            {"starttransfer_us", request.startTransferUs},
+            {"total_us", request.totalUs},
+            {"redirect_us", request.redirectUs},
+            {"redirects", request.redirects},
+            {"bytes", request.bytes},
+            {"speed_bytes_per_s", request.speedBytesPerSecond},
+            {"phases_us", {
+                {"dns", phases.dns},
+                {"connect", phases.connect},
+                {"tls", phases.tls},
+                {"ttfb", phases.ttfb},
+                {"transfer", phases.transfer}
+            }}
+        });
+    }
+
+    json phases = json::array();
+    for (const auto& phase : g_phases) {
+        phases.push_back({{"label", phase.label}, {"path", phase.path}, {"duration_us", phase.durationUs}});
+    }
+
+    QosMetrics qos = RunQos();
+    json report = {
+        {"started", static_cast<long long>(g_runStarted)},
+        {"duration_s", runSeconds},
+        {"ok", ok},
+        {"updated", updated},
+        {"requests", requests},
+        {"phases", phases},
+        {"qos", {
+            {"throttled_s", Seconds(qos.throttledMs * 1000)},
+            {"paused_s", Seconds(qos.pausedMs * 1000)},
+            {"pauses", qos.pauses}
+        }}
+    };
+    return report.dump(2) + "\n";
+}
+
+std::string BuildPrometheus(double runSeconds, bool ok, bool updated) {
+    // Everything is summed per request label / local step, one series each
+    std::map<std::string, RequestPhases> requestPhases;
+    std::map<std::string, long> requestCounts;
+    std::map<std::string, curl_off_t> requestBytes;
+    std::map<std::string, long> requestRedirects;
+    for (const auto& request : g_requests) {
+        RequestPhases phases = SplitPhases(request);
+        RequestPhases& sum = requestPhases[request.label];
+        sum.dns += phases.dns;
+        sum.connect += phases.connect;
+        sum.tls += phases.tls;
+        sum.ttfb += phases.ttfb;
+        sum.transfer += phases.transfer;
+        ++requestCounts[request.label];
+        requestBytes[request.label] += request.bytes;
+        requestRedirects[request.label] += request.redirects;
+    }
+    std::map<std::string, int64_t> localPhases;
+    for (const auto& phase : g_phases) {
+        localPhases[phase.label] += phase.durationUs;
+    }
+
+    std::ostringstream out;
+    out << "# HELP yt_dlp_updater_request_phase_seconds Time spent in each phase of the last run's requests.\n"
+        << "# TYPE yt_dlp_updater_request_phase_seconds gauge\n";
+    for (const auto& entry : requestPhases) {
+        const std::pair<const char*, curl_off_t> values[] = {
+            {"dns", entry.second.dns}, {"connect", entry.second.connect}, {"tls", entry.second.tls},
+            {"ttfb", entry.second.ttfb}, {"transfer", entry.second.transfer}
+        };
+        for (const auto& value : values) {
+            out << "yt_dlp_updater_request_phase_seconds{request=\"" << entry.first << "\",phase=\"" << value.first
+                << "\"} " << Seconds(value.second) << "\n";
+        }
+    }
+
+    out << "# HELP yt_dlp_updater_requests Requests made in the last run.\n"
+        << "# TYPE yt_dlp_updater_requests gauge\n";
+    for (const auto& entry : requestCounts) {
+        out << "yt_dlp_updater_requests{request=\"" << entry.first << "\"} " << entry.second << "\n";
+    }
+    out << "# HELP yt_dlp_updater_request_bytes Body bytes received in the last run.\n"
+        << "# TYPE yt_dlp_updater_request_bytes gauge\n";
+    for (const auto& entry : requestBytes) {
+        out << "yt_dlp_updater_request_bytes{request=\"" << entry.first << "\"} " << entry.second << "\n";
+    }
+    out << "# HELP yt_dlp_updater_request_redirects Redirects followed in the last run.\n"
+        << "# TYPE yt_dlp_updater_request_redirects gauge\n";
+    for (const auto& entry : requestRedirects) {
+        out << "yt_dlp_updater_request_redirects{request=\"" << entry.first << "\"} " << entry.second << "\n";
+    }
+
+    out << "# HELP yt_dlp_updater_local_phase_seconds Time spent in local install steps in the last run.\n"
+        << "# TYPE yt_dlp_updater_local_phase_seconds gauge\n";
+    for (const auto& entry : localPhases) {
+        out << "yt_dlp_updater_local_phase_seconds{phase=\"" << entry.first << "\"} " << Seconds(entry.second) << "\n";
+    }
+
+    QosMetrics qos = RunQos();
+    out << "# HELP yt_dlp_updater_qos_wait_seconds Time downloads were held back in the last run, summed over transfers.\n"
+        << "# TYPE yt_dlp_updater_qos_wait_seconds gauge\n"
+        << "yt_dlp_updater_qos_wait_seconds{reason=\"rate_limit\"} " << Seconds(qos.throttledMs * 1000) << "\n"
+        << "yt_dlp_updater_qos_wait_seconds{reason=\"idle\"} " << Seconds(qos.pausedMs * 1000) << "\n"
+        << "# HELP yt_dlp_updater_qos_pauses Times the idle policy paused downloads in the last run.\n"
+        << "# TYPE yt_dlp_updater_qos_pauses gauge\n"
+        << "yt_dlp_updater_qos_pauses " << qos.pauses << "\n";
+
+    out << "# HELP yt_dlp_updater_run_seconds Duration of the last run.\n"
+        << "# TYPE yt_dlp_updater_run_seconds gauge\n"
+        << "yt_dlp_updater_run_seconds " << runSeconds << "\n"
+        << "# HELP yt_dlp_updater_run_success Whether the last run succeeded.\n"
+        << "# TYPE yt_dlp_updater_run_success gauge\n"
+        << "yt_dlp_updater_run_success " << (ok ? 1 : 0) << "\n"
+        << "# HELP yt_dlp_updater_run_updated Whether the last run installed a new release.\n"
+        << "# TYPE yt_dlp_updater_run_updated gauge\n"
+        << "yt_dlp_updater_run_updated " << (updated ? 1 : 0) << "\n"
+        << "# HELP yt_dlp_updater_last_run_timestamp_seconds When the last run started.\n"
+        << "# TYPE yt_dlp_updater_last_run_timestamp_seconds gauge\n"
+        << "yt_dlp_updater_last_run_timestamp_seconds " << static_cast<long long>(g_runStarted) << "\n";
+    return out.str();
+}
+
+} // namespace
+
+void BeginRunMetrics() {
+    std::lock_guard<std::mutex> lock(g_metricsMutex);
+    g_runStarted = std::time(nullptr);
+    g_runStart = std::chrono::steady_clock::now();
+    g_requests.clear();
+    g_phases.clear();
+    g_transfersAtStart = GetTransferStats();
+}
+
+void RecordRequestMetrics(CURL* curl, const std::string& label) {
+    RequestMetrics request;
+    request.label = label;
+    char* url = nullptr;
+    if (curl_easy_getinfo(curl, CURLINFO_EFFECTIVE_URL, &url) == CURLE_OK && url) {
+        request.url = url;
+    }
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &request.responseCode);
+    curl_easy_getinfo(curl, CURLINFO_NAMELOOKUP_TIME_T, &request.nameLookupUs);
+    curl_easy_getinfo(curl, CURLINFO_CONNECT_TIME_T, &request.connectUs);
+    curl_easy_getinfo(curl, CURLINFO_APPCONNECT_TIME_T, &request.appConnectUs);
+    curl_easy_getinfo(curl, CURLINFO_STARTTRANSFER_TIME_T, &request.startTransferUs);
+    curl_easy_getinfo(curl, CURLINFO_TOTAL_TIME_T, &request.totalUs);
+    curl_easy_getinfo(curl, CURLINFO_REDIRECT_TIME_T, &request.redirectUs);
+    curl_easy_getinfo(curl, CURLINFO_REDIRECT_COUNT, &request.redirects);
+    curl_easy_getinfo(curl, CURLINFO_SIZE_DOWNLOAD_T, &request.bytes);
+    curl_easy_getinfo(curl, CURLINFO_SPEED_DOWNLOAD_T, &request.speedBytesPerSecond);
+
+    std::lock_guard<std::mutex> lock(g_metricsMutex);
+    g_requests.push_back(request);
+}
+
+void RecordPhase(const std::string& label, const std::string& path, std::chrono::steady_clock::duration duration) {
+    PhaseMetrics phase;
+    phase.label = label;
+    phase.path = path;
+    phase.durationUs = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+
+    std::lock_guard<std::mutex> lock(g_metricsMutex);
+    g_phases.push_back(phase);
+}
+
+bool ExportRunMetrics(const std::string& reportPath, const std::string& prometheusPath, bool ok, bool updated) {
+    std::string report;
+    std::string prometheus;
+    {
+        std::lock_guard<std::mutex> lock(g_metricsMutex);
+        double runSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - g_runStart).count();
+        if (!reportPath.empty()) {
+            report = BuildReport(runSeconds, ok, updated);
+        }
+        if (!prometheusPath.empty()) {
+            prometheus = BuildPrometheus(runSeconds, ok, updated);
+        }
+    }
+
+    bool written = true;
+    if (!reportPath.empty()) {
+        written = WriteFileAtomically(reportPath, report) && written;
+    }
+    if (!prometheusPath.empty()) {
+        written = WriteFileAtomically(prometheusPath, prometheus) && written;
+    }
+    return written;
+}
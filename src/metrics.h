@@ -0,0 +1,49 @@
+#pragma once
+
+#include <chrono>
+#include <curl/curl.h>
+#include <string>
+
+// Timing of one update run: every HTTP request's phases as curl measured them
+// and the local install steps. Collected process-wide; a run starts with
+// BeginRunMetrics and is written out with ExportRunMetrics.
+
+// Times of one request in microseconds, each measured from the start of the
+// request the way curl reports them (so they add up, they don't sum)
+struct RequestMetrics {
+    std::string label;                  // "release", "checksums", "probe", "download", "segment", "manifest"
+    std::string url;                    // effective URL, after redirects
+    long responseCode = 0;
+    curl_off_t nameLookupUs = 0;        // CURLINFO_NAMELOOKUP_TIME_T
+    curl_off_t connectUs = 0;           // CURLINFO_CONNECT_TIME_T
+    curl_off_t appConnectUs = 0;        // CURLINFO_APPCONNECT_TIME_T, 0 without TLS
+    curl_off_t startTransferUs = 0;     // CURLINFO_STARTTRANSFER_TIME_T: first byte
+    curl_off_t totalUs = 0;             // CURLINFO_TOTAL_TIME_T
+    curl_off_t redirectUs = 0;          // CURLINFO_REDIRECT_TIME_T
+    long redirects = 0;
+    curl_off_t bytes = 0;               // body bytes received
+    curl_off_t speedBytesPerSecond = 0; // average download speed
+};
+
+// Function to start collecting a new run, dropping what the previous one recorded
+void BeginRunMetrics();
+
+// Function to record the timings of the request just performed on curl; call
+// it before the handle goes back with ReleaseEasyHandle
+void RecordRequestMetrics(CURL* curl, const std::string& label);
+
+// Function to record how long a local step took (attribute change, rename, ...)
+void RecordPhase(const std::string& label, const std::string& path, std::chrono::steady_clock::duration duration);
+
+// Function to run step, record how long it took as a local phase and return its result
+template <typename Step>
+auto TimePhase(const std::string& label, const std::string& path, Step step) -> decltype(step()) {
+    auto start = std::chrono::steady_clock::now();
+    auto result = step();
+    RecordPhase(label, path, std::chrono::steady_clock::now() - start);
+    return result;
+}
+
+// Function to finish the run and write it as a JSON report to reportPath and as
+// a Prometheus textfile-collector file to prometheusPath (either may be "")
+bool ExportRunMetrics(const std::string& reportPath, const std::string& prometheusPath, bool ok, bool updated);
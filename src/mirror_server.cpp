@@ -0,0 +1,507 @@
+#include "mirror_server.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <nlohmann/json.hpp>
+#include "artifact_store.h"
+#include "block_manifest.h"
+#include "logger.h"
+#include "platform.h"
+
+using json = nlohmann::json;
+namespace fs = std::filesystem;
+
+struct MirrorServer::Request {
+    std::string method;
+    std::string path;
+    std::map<std::string, std::string> headers;  // lower-cased names
+    bool keepAlive = true;
+};
+
+namespace {
+
+using Request = MirrorServer::Request;
+
+// Name of the binary's block manifest next to it, as published for delta updates
+const char* const kBlockManifestName = "yt-dlp.exe.blocks.json";
+
+// Largest request head accepted
+const size_t kMaxRequestHead = 16 * 1024;
+
+// Idle keep-alive connections are closed after this long, freeing their worker
+const int kIdleTimeoutSeconds = 30;
+
+// Function to stamp a file with its modification time and size ("-" if it is missing)
+std::string FileStamp(const std::string& path) {
+    std::error_code ec;
+    auto modified = fs::last_write_time(path, ec);
+    if (ec) {
+        return "-";
+    }
+    uint64_t size = fs::file_size(path, ec);
+    return std::to_string(modified.time_since_epoch().count()) + ":" + std::to_string(ec ? 0 : size);
+}
+
+std::string ToLower(std::string value) {
+    std::transform(value.begin(), value.end(), value.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return value;
+}
+
+// Function to parse a request head (everything before the blank line)
+bool ParseRequest(const std::string& head, Request& request) {
+    std::istringstream stream(head);
+    std::string line;
+    std::string version;
+    if (!std::getline(stream, line)) {
+        return false;
+    }
+    std::istringstream requestLine(line);
+    if (!(requestLine >> request.method >> request.path >> version)) {
+        return false;
+    }
+
+    while (std::getline(stream, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        size_t colon = line.find(':');
+        if (colon == std::string::npos) {
+            continue;
+        }
+        size_t valueStart = line.find_first_not_of(" \t", colon + 1);
+        request.headers[ToLower(line.substr(0, colon))] = valueStart == std::string::npos ? "" : line.substr(valueStart);
+    }
+
+    std::string connection = ToLower(request.headers["connection"]);
+    request.keepAlive = version == "HTTP/1.1" ? connection != "close" : connection == "keep-alive";
+    return true;
+}
+
+// Function to parse a decimal range bound; false if it is empty or overflows
+bool ParseRangeNumber(const std::string& digits, uint64_t& value) {
+    if (digits.empty()) {
+        return false;
+    }
+    errno = 0;
+    value = std::strtoull(digits.c_str(), nullptr, 10);
+    return errno != ERANGE;
+}
+
+// Function to parse a single "bytes=first-last" range against a file size.
+// Returns false for multiple or malformed ranges, which are answered with the
+// whole file. A bound too large to represent is never satisfiable.
+bool ParseRange(const std::string& value, uint64_t size, uint64_t& first, uint64_t& last, bool& satisfiable) {
+    if (value.compare(0, 6, "bytes=") != 0 || value.find(',') != std::string::npos) {
+        return false;
+    }
+    std::string spec = value.substr(6);
+    size_t dash = spec.find('-');
+    if (dash == std::string::npos) {
+        return false;
+    }
+    std::string start = spec.substr(0, dash);
+    std::string end = spec.substr(dash + 1);
+    if (start.find_first_not_of("0123456789") != std::string::npos ||
+        end.find_first_not_of("0123456789") != std::string::npos || (start.empty() && end.empty())) {
+        return false;
+    }
+
+    if (start.empty()) {
+        // Suffix range: the last N bytes
+        uint64_t suffix = 0;
+        satisfiable = ParseRangeNumber(end, suffix) && suffix > 0 && size > 0;
+        first = suffix >= size ? 0 : size - suffix;
+        last = size - 1;
+        return true;
+    }
+
+    uint64_t requestedLast = 0;
+    if (!ParseRangeNumber(start, first) || (!end.empty() && !ParseRangeNumber(end, requestedLast))) {
+        satisfiable = false;
+        return true;
+    }
+    last = end.empty() ? size - 1 : std::min<uint64_t>(requestedLast, size - 1);
+    satisfiable = first < size && first <= last;
+    return true;
+}
+
+std::string StatusText(int status) {
+    switch (status) {
+    case 200: return "OK";
+    case 206: return "Partial Content";
+    case 304: return "Not Modified";
+    case 400: return "Bad Request";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 416: return "Range Not Satisfiable";
+    default: return "Internal Server Error";
+    }
+}
+
+// Function to send a status line and headers; the body (if any) follows separately
+bool SendHead(SocketHandle connection, int status, const std::vector<std::pair<std::string, std::string>>& headers,
+              uint64_t contentLength, bool keepAlive) {
+    std::ostringstream head;
+    head << "HTTP/1.1 " << status << " " << StatusText(status) << "\r\n";
+    for (const auto& header : headers) {
+        head << header.first << ": " << header.second << "\r\n";
+    }
+    head << "Content-Length: " << contentLength << "\r\n";
+    head << "Connection: " << (keepAlive ? "keep-alive" : "close") << "\r\n\r\n";
+    std::string text = head.str();
+    return SendAll(connection, text.data(), text.size());
+}
+
+bool SendBody(SocketHandle connection, const Request& request, int status, const std::string& contentType,
+              const std::string& body, const std::vector<std::pair<std::string, std::string>>& extraHeaders = {}) {
+    std::vector<std::pair<std::string, std::string>> headers = extraHeaders;
+    headers.emplace_back("Content-Type", contentType);
+    if (!SendHead(connection, status, headers, body.size(), request.keepAlive)) {
+        return false;
+    }
+    return request.method == "HEAD" || SendAll(connection, body.data(), body.size());
+}
+
+bool SendError(SocketHandle connection, const Request& request, int status) {
+    json body = {{"message", StatusText(status)}};
+    return SendBody(connection, request, status, "application/json", body.dump());
+}
+
+// Function to send a stored file, honouring a single Range
+bool SendFile(SocketHandle connection, const Request& request, const std::string& filePath, uint64_t size,
+              const std::string& etag) {
+    std::vector<std::pair<std::string, std::string>> headers = {
+        {"Content-Type", "application/octet-stream"},
+        {"Accept-Ranges", "bytes"},
+        {"ETag", etag}
+    };
+
+    uint64_t first = 0;
+    uint64_t last = size == 0 ? 0 : size - 1;
+    bool satisfiable = true;
+    auto range = request.headers.find("range");
+    bool partial = range != request.headers.end() && ParseRange(range->second, size, first, last, satisfiable);
+    if (partial && !satisfiable) {
+        headers.emplace_back("Content-Range", "bytes */" + std::to_string(size));
+        return SendHead(connection, 416, headers, 0, request.keepAlive);
+    }
+
+    uint64_t length = size == 0 ? 0 : last - first + 1;
+    if (partial) {
+        headers.emplace_back("Content-Range", "bytes " + std::to_string(first) + "-" + std::to_string(last) + "/" + std::to_string(size));
+    }
+    if (!SendHead(connection, partial ? 206 : 200, headers, length, request.keepAlive)) {
+        return false;
+    }
+    return request.method == "HEAD" || length == 0 || SendFileRange(connection, filePath, first, length);
+}
+
+} // namespace
+
+MirrorServer::MirrorServer(const std::string& vrchatToolsPath, size_t workers)
+    : vrchatToolsPath_(vrchatToolsPath), workerCount_(workers == 0 ? 1 : workers) {}
+
+MirrorServer::~MirrorServer() {
+    Stop();
+}
+
+bool MirrorServer::Start(const std::string& address, int port) {
+    if (!StartSockets()) {
+        return false;
+    }
+    listener_ = ListenTcp(address, port);
+    if (listener_ == kInvalidSocket) {
+        return false;
+    }
+
+    for (size_t i = 0; i < workerCount_; ++i) {
+        workers_.emplace_back(&MirrorServer::WorkerLoop, this);
+    }
+    acceptThread_ = std::thread(&MirrorServer::AcceptLoop, this);
+
+    LogInfo() << "Serving " << vrchatToolsPath_ << " on http://" << address << ":" << port
+              << " (clients: --mirror http://<this host>:" << port << ")";
+    return true;
+}
+
+void MirrorServer::Stop() {
+    if (listener_ == kInvalidSocket) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        for (SocketHandle connection : active_) {
+            ShutdownSocket(connection);
+        }
+    }
+    ShutdownSocket(listener_);
+    queued_.notify_all();
+
+    if (acceptThread_.joinable()) {
+        acceptThread_.join();
+    }
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+    workers_.clear();
+
+    for (SocketHandle connection : pending_) {
+        CloseSocket(connection);
+    }
+    pending_.clear();
+    CloseSocket(listener_);
+    listener_ = kInvalidSocket;
+}
+
+void MirrorServer::AcceptLoop() {
+    while (true) {
+        SocketHandle connection = AcceptConnection(listener_);
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_ || connection == kInvalidSocket) {
+            if (connection != kInvalidSocket) {
+                CloseSocket(connection);
+            }
+            return;
+        }
+        pending_.push_back(connection);
+        queued_.notify_one();
+
+        // No worker free: displace the connection that has been idle the longest
+        if (active_.size() + pending_.size() > workerCount_ && !idle_.empty()) {
+            ShutdownSocket(idle_.front());
+            idle_.pop_front();
+        }
+    }
+}
+
+void MirrorServer::WorkerLoop() {
+    while (true) {
+        SocketHandle connection;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            queued_.wait(lock, [this]() { return stopping_ || !pending_.empty(); });
+            if (stopping_) {
+                return;
+            }
+            connection = pending_.front();
+            pending_.pop_front();
+            active_.insert(connection);
+        }
+
+        ServeConnection(connection);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        active_.erase(connection);
+        CloseSocket(connection);
+    }
+}
+
+void MirrorServer::ServeConnection(SocketHandle connection) {
+    SetReceiveTimeout(connection, kIdleTimeoutSeconds);
+
+    std::string buffer;
+    bool served = false;
+    while (true) {
+        size_t headEnd;
+        if (!WaitForRequest(connection, buffer, served, headEnd)) {
+            return;
+        }
+        served = true;
+
+        Request request;
+        bool parsed = ParseRequest(buffer.substr(0, headEnd), request);
+        buffer.erase(0, headEnd + 4);
+        if (!parsed) {
+            request.keepAlive = false;
+            SendError(connection, request, 400);
+            return;
+        }
+
+        // Requests never carry a body this server cares about
+        if (request.headers.count("content-length") || request.headers.count("transfer-encoding")) {
+            request.keepAlive = false;
+        }
+        if (request.keepAlive && !KeepAliveAllowed()) {
+            request.keepAlive = false;
+        }
+
+        bool ok;
+        if (request.method != "GET" && request.method != "HEAD") {
+            request.keepAlive = false;
+            ok = SendError(connection, request, 405);
+        } else {
+            // Nothing a request carries may take the whole server down
+            try {
+                ok = HandleRequest(connection, request);
+            } catch (const std::exception& e) {
+                LogError() << "Failed to handle " << request.method << " " << request.path << ": " << e.what();
+                request.keepAlive = false;
+                ok = SendError(connection, request, 500);
+            }
+        }
+        if (!ok || !request.keepAlive) {
+            return;
+        }
+    }
+}
+
+// Function to read until a complete request head is buffered (a pipelined one
+// may already be); headEnd receives its end. Between requests the connection
+// counts as idle, and the accept loop may shut it down to make room.
+bool MirrorServer::WaitForRequest(SocketHandle connection, std::string& buffer, bool betweenRequests, size_t& headEnd) {
+    bool idle = false;
+    if (betweenRequests && buffer.find("\r\n\r\n") == std::string::npos) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!pending_.empty()) {
+            return false;  // a client is waiting for this worker
+        }
+        idle_.push_back(connection);
+        idle = true;
+    }
+
+    char chunk[4096];
+    while ((headEnd = buffer.find("\r\n\r\n")) == std::string::npos) {
+        if (buffer.size() > kMaxRequestHead) {
+            return false;
+        }
+        long received = ReceiveSome(connection, chunk, sizeof(chunk));
+        if (idle) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto position = std::find(idle_.begin(), idle_.end(), connection);
+            if (position == idle_.end()) {
+                return false;  // displaced by a new connection
+            }
+            idle_.erase(position);
+            idle = false;
+        }
+        if (received <= 0) {
+            return false;
+        }
+        buffer.append(chunk, static_cast<size_t>(received));
+    }
+    return true;
+}
+
+// Function to check whether a connection may stay open after its response:
+// only while a worker is left for new clients
+bool MirrorServer::KeepAliveAllowed() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pending_.empty() && active_.size() < workerCount_;
+}
+
+bool MirrorServer::HandleRequest(SocketHandle connection, const Request& request) {
+    std::string path = request.path.substr(0, request.path.find('?'));
+
+    ArtifactStore store;
+    std::string tag;
+    if (!GetStore(store, tag)) {
+        return SendError(connection, request, 500);
+    }
+
+    if (path == kLatestReleasePath) {
+        StoreEntry* entry = FindStoreEntry(store, tag);
+        if (!entry) {
+            return SendError(connection, request, 404);
+        }
+
+        std::string etag = "\"" + tag + "-" + entry->sha256.substr(0, 16) + "\"";
+        auto ifNoneMatch = request.headers.find("if-none-match");
+        if (ifNoneMatch != request.headers.end() && ifNoneMatch->second == etag) {
+            return SendHead(connection, 304, {{"ETag", etag}}, 0, request.keepAlive);
+        }
+
+        // Asset links point back at this mirror under the name the client used for it
+        auto host = request.headers.find("host");
+        std::string base = "http://" + (host != request.headers.end() ? host->second : std::string("localhost")) + "/download/" + tag + "/";
+        std::string sums = entry->sha256 + "  yt-dlp.exe\n";
+        json release = {
+            {"tag_name", tag},
+            {"name", "yt-dlp " + tag},
+            {"assets", json::array({
+                {{"name", "yt-dlp.exe"}, {"size", entry->size}, {"browser_download_url", base + "yt-dlp.exe"}},
+                {{"name", "SHA2-256SUMS"}, {"size", sums.size()}, {"browser_download_url", base + "SHA2-256SUMS"}}
+            })}
+        };
+        return SendBody(connection, request, 200, "application/json", release.dump(), {{"ETag", etag}});
+    }
+
+    // /download/<tag>/<asset> for any stored release
+    const std::string prefix = "/download/";
+    size_t slash = path.find('/', prefix.size());
+    if (path.compare(0, prefix.size(), prefix) != 0 || slash == std::string::npos) {
+        return SendError(connection, request, 404);
+    }
+    StoreEntry* entry = FindStoreEntry(store, path.substr(prefix.size(), slash - prefix.size()));
+    if (!entry) {
+        return SendError(connection, request, 404);
+    }
+
+    std::string asset = path.substr(slash + 1);
+    std::string objectPath = StoreObjectPath(store, entry->sha256);
+    if (asset == "yt-dlp.exe") {
+        return SendFile(connection, request, objectPath, entry->size, "\"" + entry->sha256 + "\"");
+    }
+    if (asset == "SHA2-256SUMS") {
+        return SendBody(connection, request, 200, "text/plain", entry->sha256 + "  yt-dlp.exe\n");
+    }
+    if (asset == kBlockManifestName) {
+        std::string manifest;
+        if (!GetBlockManifest(entry->sha256, objectPath, manifest)) {
+            return SendError(connection, request, 500);
+        }
+        return SendBody(connection, request, 200, "application/json", manifest);
+    }
+    return SendError(connection, request, 404);
+}
+
+bool MirrorServer::GetBlockManifest(const std::string& sha256, const std::string& objectPath, std::string& manifestJson) {
+    std::lock_guard<std::mutex> lock(manifestMutex_);
+    auto cached = manifests_.find(sha256);
+    if (cached != manifests_.end()) {
+        manifestJson = cached->second;
+        return true;
+    }
+
+    BlockManifest manifest;
+    if (!BuildBlockManifest(objectPath, kDefaultManifestBlockSize, manifest)) {
+        return false;
+    }
+    manifestJson = SerializeBlockManifest(manifest);
+    manifests_[sha256] = manifestJson;
+    return true;
+}
+
+// Function to get the store and the installed tag. Both are read again only
+// when the index or the version file changed, e.g. the updater installed a
+// new release meanwhile.
+bool MirrorServer::GetStore(ArtifactStore& store, std::string& latestTag) {
+    std::string versionPath = JoinPath(vrchatToolsPath_, "yt-dlp-version.txt");
+    std::string stamp = FileStamp(StoreIndexPath(vrchatToolsPath_)) + "|" + FileStamp(versionPath);
+
+    std::lock_guard<std::mutex> lock(storeMutex_);
+    if (stamp != storeStamp_) {
+        ArtifactStore fresh;
+        if (!OpenArtifactStore(vrchatToolsPath_, fresh)) {
+            return false;
+        }
+        std::string tag;
+        std::ifstream versionFile(versionPath);
+        std::getline(versionFile, tag);
+
+        store_ = std::move(fresh);
+        latestTag_ = tag;
+        storeStamp_ = stamp;
+    }
+    store = store_;
+    latestTag = latestTag_;
+    return true;
+}
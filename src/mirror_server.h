@@ -0,0 +1,71 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include "artifact_store.h"
+#include "socket.h"
+
+// Path of the latest-release document below an API base URL, as on api.github.com
+const char* const kLatestReleasePath = "/repos/yt-dlp/yt-dlp/releases/latest";
+
+// LAN mirror of a Tools directory: serves its installed release as a GitHub
+// style releases/latest document, and every stored release under
+// /download/<tag>/ (yt-dlp.exe with Range support, SHA2-256SUMS and the block
+// manifest for delta updates). Connections are handled by a fixed pool of
+// worker threads; file bodies are sent zero-copy. Keep-alive is bounded by the
+// pool: while every worker is taken, responses close their connection and a
+// new client displaces a connection idling between requests.
+class MirrorServer {
+public:
+    MirrorServer(const std::string& vrchatToolsPath, size_t workers);
+    ~MirrorServer();
+
+    MirrorServer(const MirrorServer&) = delete;
+    MirrorServer& operator=(const MirrorServer&) = delete;
+
+    // Start listening on address:port and serving in the background
+    bool Start(const std::string& address, int port);
+
+    // Stop accepting, drop open connections and wait for the workers
+    void Stop();
+
+    // Parsed request head (see mirror_server.cpp)
+    struct Request;
+
+private:
+    void AcceptLoop();
+    void WorkerLoop();
+    void ServeConnection(SocketHandle connection);
+    bool WaitForRequest(SocketHandle connection, std::string& buffer, bool betweenRequests, size_t& headEnd);
+    bool KeepAliveAllowed();
+    bool HandleRequest(SocketHandle connection, const Request& request);
+    bool GetStore(ArtifactStore& store, std::string& latestTag);
+    bool GetBlockManifest(const std::string& sha256, const std::string& objectPath, std::string& manifestJson);
+
+    std::string vrchatToolsPath_;
+    size_t workerCount_;
+    SocketHandle listener_ = kInvalidSocket;
+    std::thread acceptThread_;
+    std::vector<std::thread> workers_;
+
+    std::mutex mutex_;
+    std::condition_variable queued_;
+    std::deque<SocketHandle> pending_;
+    std::set<SocketHandle> active_;
+    std::deque<SocketHandle> idle_;  // active connections waiting for their next request, oldest first
+    bool stopping_ = false;
+
+    std::mutex manifestMutex_;
+    std::map<std::string, std::string> manifests_;  // block manifests by object hash, built on first request
+
+    std::mutex storeMutex_;
+    std::string storeStamp_;        // times and sizes of the store index and version file store_ was read from
+    ArtifactStore store_;
+    std::string latestTag_;
+};
@@ -0,0 +1,303 @@
+#include "options.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include "asset_variant.h"
+#include "logger.h"
+
+namespace {
+
+// Failover threshold once mirrors are configured, unless --failover-below says otherwise
+const curl_off_t kDefaultFailoverBytesPerSecond = 64 * 1024;
+
+// Function to parse a duration such as "90", "90s", "15m" or "6h" (default unit: seconds)
+bool ParseDuration(const std::string& value, std::chrono::seconds& duration) {
+    char* end = nullptr;
+    long long count = std::strtoll(value.c_str(), &end, 10);
+    if (end == value.c_str() || count <= 0) {
+        return false;
+    }
+
+    std::string unit(end);
+    if (unit.empty() || unit == "s") {
+        duration = std::chrono::seconds(count);
+    } else if (unit == "m") {
+        duration = std::chrono::minutes(count);
+    } else if (unit == "h") {
+        duration = std::chrono::hours(count);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Function to parse a rate such as "500K" or "2M" in bytes per second (K, M
+// and G are binary multiples, as in curl's --limit-rate); sizes use it too
+bool ParseRate(const std::string& value, curl_off_t& bytesPerSecond) {
+    char* end = nullptr;
+    long long count = std::strtoll(value.c_str(), &end, 10);
+    if (end == value.c_str() || count <= 0) {
+        return false;
+    }
+
+    std::string unit(end);
+    if (unit.empty()) {
+        bytesPerSecond = count;
+    } else if (unit == "K" || unit == "k") {
+        bytesPerSecond = count * 1024;
+    } else if (unit == "M" || unit == "m") {
+        bytesPerSecond = count * 1024 * 1024;
+    } else if (unit == "G" || unit == "g") {
+        bytesPerSecond = count * 1024 * 1024 * 1024;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Function to read an options file into command line arguments
+bool ReadOptionsFile(const std::string& path, std::vector<std::string>& args) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        LogError() << "Failed to open config file: " << path;
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(file, line)) {
+        size_t begin = line.find_first_not_of(" \t\r");
+        if (begin == std::string::npos || line[begin] == '#') {
+            continue;
+        }
+
+        // The option name, then everything after the first blank as its value
+        size_t nameEnd = line.find_first_of(" \t\r", begin);
+        args.push_back(line.substr(begin, nameEnd - begin));
+        if (nameEnd != std::string::npos) {
+            size_t valueBegin = line.find_first_not_of(" \t\r", nameEnd);
+            size_t valueEnd = line.find_last_not_of(" \t\r");
+            if (valueBegin != std::string::npos) {
+                args.push_back(line.substr(valueBegin, valueEnd - valueBegin + 1));
+            }
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+bool ParseOptions(int argc, char* argv[], UpdaterOptions& options) {
+    std::vector<std::string> args(argv + 1, argv + argc);
+    bool configRead = false;
+    bool failoverSet = false;
+
+    for (size_t i = 0; i < args.size(); ++i) {
+        std::string arg = args[i];
+        bool hasValue = i + 1 < args.size();
+
+        if (arg == "--delta") {
+            options.useDelta = true;
+        } else if (arg == "--variant" && hasValue) {
+            options.assetVariant = args[++i];
+            const AssetVariant* variant = FindAssetVariant(options.assetVariant);
+            if (options.assetVariant != "auto" && (!variant || !VariantRunsHere(*variant))) {
+                LogError() << "Unknown yt-dlp build for --variant (or one that can't run here): " << options.assetVariant;
+                return false;
+            }
+        } else if (arg == "--http2") {
+            options.transfer.multiplex = true;
+        } else if (arg == "--cacert" && hasValue) {
+            options.transfer.caInfo = args[++i];
+        } else if ((arg == "--limit-rate" || arg == "--idle-threshold") && hasValue) {
+            curl_off_t& rate = arg == "--limit-rate" ? options.transfer.maxRecvBytesPerSecond
+                                                     : options.transfer.idleThresholdBytesPerSecond;
+            if (!ParseRate(args[++i], rate)) {
+                LogError() << "Invalid rate for " << arg << ": " << args[i];
+                return false;
+            }
+        } else if (arg == "--failover-below" && hasValue) {
+            curl_off_t& rate = options.transfer.failoverBytesPerSecond;
+            if (args[++i] == "0") {
+                rate = 0;
+            } else if (!ParseRate(args[i], rate)) {
+                LogError() << "Invalid rate for " << arg << ": " << args[i];
+                return false;
+            }
+            failoverSet = true;
+        } else if (arg == "--asset-mirror" && hasValue) {
+            options.assetMirrors.push_back(args[++i]);
+        } else if (arg == "--idle-only") {
+            options.transfer.idleOnly = true;
+        } else if (arg == "--pause-while" && hasValue) {
+            options.transfer.pauseWhile.push_back(args[++i]);
+        } else if (arg == "--daemon") {
+            options.daemon = true;
+            options.nonInteractive = true;
+        } else if (arg == "--non-interactive") {
+            options.nonInteractive = true;
+        } else if (arg == "--target" && hasValue) {
+            options.targets.push_back(args[++i]);
+        } else if (arg == "--all-profiles") {
+            options.allProfiles = true;
+        } else if (arg == "--browser" && hasValue) {
+            options.browser = args[++i];
+        } else if (arg == "--export-cookies") {
+            options.exportCookies = true;
+        } else if (arg == "--cookie-domain" && hasValue) {
+            // Matched against cookie hosts, which are lowercase and may start with a dot
+            std::string domain = args[++i];
+            std::transform(domain.begin(), domain.end(), domain.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+            size_t start = domain.find_first_not_of('.');
+            options.cookieDomains.push_back(start == std::string::npos ? domain : domain.substr(start));
+        } else if ((arg == "--poll-min" || arg == "--poll-max" || arg == "--cookie-refresh") && hasValue) {
+            std::chrono::seconds& interval = arg == "--poll-min" ? options.minPollInterval
+                                           : arg == "--poll-max" ? options.maxPollInterval : options.cookieRefreshInterval;
+            if (!ParseDuration(args[++i], interval)) {
+                LogError() << "Invalid duration for " << arg << ": " << args[i];
+                return false;
+            }
+        } else if (arg == "--store-max" && hasValue) {
+            char* end = nullptr;
+            long long megabytes = std::strtoll(args[++i].c_str(), &end, 10);
+            if (*end != '\0' || megabytes <= 0) {
+                LogError() << "Invalid size for --store-max: " << args[i];
+                return false;
+            }
+            options.storeMaxBytes = static_cast<uint64_t>(megabytes) * 1024 * 1024;
+        } else if (arg == "--mirror" && hasValue) {
+            options.apiBaseUrl = args[++i];
+            while (!options.apiBaseUrl.empty() && options.apiBaseUrl.back() == '/') {
+                options.apiBaseUrl.pop_back();
+            }
+        } else if (arg == "--companions" && hasValue) {
+            options.companionManifest = args[++i];
+        } else if (arg == "--listen" && hasValue) {
+            std::string listen = args[++i];
+            size_t colon = listen.rfind(':');
+            char* end = nullptr;
+            long port = colon == std::string::npos ? 0 : std::strtol(listen.c_str() + colon + 1, &end, 10);
+            if (port <= 0 || port > 65535 || *end != '\0') {
+                LogError() << "Invalid --listen address (expected address:port): " << listen;
+                return false;
+            }
+            options.listenAddress = listen.substr(0, colon);
+            options.listenPort = static_cast<int>(port);
+        } else if (arg == "--verbose") {
+            options.log.level = LogLevel::Debug;
+        } else if (arg == "--log-level" && hasValue) {
+            std::string level = args[++i];
+            if (level == "debug") {
+                options.log.level = LogLevel::Debug;
+            } else if (level == "info") {
+                options.log.level = LogLevel::Info;
+            } else if (level == "warning") {
+                options.log.level = LogLevel::Warning;
+            } else if (level == "error") {
+                options.log.level = LogLevel::Error;
+            } else {
+                LogError() << "Invalid --log-level (expected debug, info, warning or error): " << level;
+                return false;
+            }
+        } else if (arg == "--log-file" && hasValue) {
+            options.log.filePath = args[++i];
+        } else if (arg == "--log-max-size" && hasValue) {
+            curl_off_t bytes = 0;
+            if (!ParseRate(args[++i], bytes)) {
+                LogError() << "Invalid size for --log-max-size: " << args[i];
+                return false;
+            }
+            options.log.maxFileBytes = static_cast<uintmax_t>(bytes);
+        } else if (arg == "--report" && hasValue) {
+            options.reportPath = args[++i];
+        } else if (arg == "--prometheus" && hasValue) {
+            options.prometheusPath = args[++i];
+        } else if (options.command.empty() && (arg == "rollback" || arg == "versions" || arg == "serve")) {
+            options.command = arg;
+            if (arg == "serve") {
+                options.daemon = true;
+                options.nonInteractive = true;
+            }
+        } else if (options.command == "rollback" && options.commandArgument.empty() && arg.compare(0, 2, "--") != 0) {
+            options.commandArgument = arg;
+        } else if (arg == "--config" && hasValue && !configRead) {
+            // Splice the file's options in place so later arguments still win
+            std::vector<std::string> fileArgs;
+            if (!ReadOptionsFile(args[i + 1], fileArgs)) {
+                return false;
+            }
+            args.erase(args.begin() + i, args.begin() + i + 2);
+            args.insert(args.begin() + i, fileArgs.begin(), fileArgs.end());
+            configRead = true;
+            --i;
+        } else {
+            LogError() << "Unknown or incomplete option: " << arg;
+            return false;
+        }
+    }
+
+    // Other updaters take the mirror's release as yt-dlp.exe for Windows
+    if (options.command == "serve" && options.assetVariant != "onefile") {
+        LogError() << "serve only mirrors the onefile build; drop --variant";
+        return false;
+    }
+    if (!options.assetMirrors.empty() && !failoverSet) {
+        options.transfer.failoverBytesPerSecond = kDefaultFailoverBytesPerSecond;
+    }
+    if (options.maxPollInterval < options.minPollInterval) {
+        LogError() << "--poll-max must not be shorter than --poll-min";
+        return false;
+    }
+    return true;
+}
+
+void PrintUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [options] [rollback [tag] | versions | serve]\n"
+              << "  rollback [tag]        Switch back to a stored release (default: the previous one), offline\n"
+              << "  versions              List the releases kept in the store\n"
+              << "  serve                 Keep up to date and serve the release to other updaters on the LAN\n"
+              << "  --delta               Try a delta update against the installed yt-dlp.exe first\n"
+              << "  --variant <build>     onefile (default), onedir, linux, linux-onedir, or auto to\n"
+              << "                        install the build that starts fastest on this machine\n"
+              << "  --http2               Negotiate HTTP/2 and multiplex parallel segments\n"
+              << "  --cacert <file>       Extra CA bundle for TLS verification\n"
+              << "  --limit-rate <rate>   Cap all downloads together, e.g. 500K or 2M bytes/s\n"
+              << "  --idle-only           Pause downloads while other programs use the network\n"
+              << "  --idle-threshold <rate>\n"
+              << "                        Other traffic that counts as using the network (default 128K)\n"
+              << "  --pause-while <name>  Pause downloads while this process runs (repeatable)\n"
+              << "  --asset-mirror <url|dir>\n"
+              << "                        Also download releases from this mirror or directory, whichever\n"
+              << "                        answers first (repeatable)\n"
+              << "  --failover-below <rate>\n"
+              << "                        Switch sources when a download stays slower than this (default 64K\n"
+              << "                        with --asset-mirror, 0 for never)\n"
+              << "  --companions <file>   Also keep the tools in this manifest (ffmpeg, ...) up to date\n"
+              << "  --target <dir>        Tools directory to install into (repeatable)\n"
+              << "  --all-profiles        Install into the Tools directory of every user profile\n"
+              << "  --browser <name>      Browser to take cookies from when creating yt-dlp.conf\n"
+              << "  --export-cookies      Export the browser's cookies to cookies.txt for yt-dlp instead\n"
+              << "                        of having it decrypt them for every video\n"
+              << "  --cookie-domain <domain>\n"
+              << "                        Site to export cookies of (repeatable; default youtube.com, twitch.tv)\n"
+              << "  --cookie-refresh <duration>\n"
+              << "                        How often the daemon refreshes the export (default 10m)\n"
+              << "  --non-interactive     Never prompt or wait for a key press\n"
+              << "  --daemon              Keep running and check for new releases periodically\n"
+              << "  --poll-min <duration> Shortest interval between checks (default 5m)\n"
+              << "  --poll-max <duration> Longest interval between checks (default 6h)\n"
+              << "  --mirror <url>        Get releases from a LAN mirror instead of GitHub\n"
+              << "  --listen <addr:port>  Address for serve (default 0.0.0.0:8080)\n"
+              << "  --store-max <MB>      Size cap of the release store (default 256)\n"
+              << "  --verbose             Also log per-step diagnostics (same as --log-level debug)\n"
+              << "  --log-level <level>   debug, info (default), warning or error\n"
+              << "  --log-file <file>     Also write the log to a file as JSON lines\n"
+              << "  --log-max-size <size> Size at which the log file is rotated, e.g. 10M (default)\n"
+              << "  --report <file>       Write a JSON timing report of every update check\n"
+              << "  --prometheus <file>   Write the timings as a Prometheus textfile\n"
+              << "  --config <file>       Read options from a file, one per line" << std::endl;
+}
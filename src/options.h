@@ -0,0 +1,49 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "artifact_store.h"
+#include "logger.h"
+#include "transfer_context.h"
+
+// Everything the updater can be told on the command line or in a config file
+struct UpdaterOptions {
+    bool useDelta = false;                          // --delta
+    std::string assetVariant = "onefile";           // --variant <name>: yt-dlp build to install, or "auto"
+    bool daemon = false;                            // --daemon: keep running and poll for releases
+    bool nonInteractive = false;                    // --non-interactive: never read stdin (implied by --daemon)
+    std::string browser;                            // --browser <name>: cookie source for a new yt-dlp.conf
+    std::vector<std::string> targets;               // --target <dir>, repeatable: Tools directories to install into
+    bool allProfiles = false;                       // --all-profiles: every user profile's Tools directory
+    std::chrono::seconds minPollInterval{5 * 60};   // --poll-min <duration>
+    std::chrono::seconds maxPollInterval{6 * 60 * 60}; // --poll-max <duration>
+    TransferOptions transfer;                       // --http2, --cacert <file>, --limit-rate <rate>,
+                                                    // --idle-only, --idle-threshold <rate>, --pause-while <process>,
+                                                    // --failover-below <rate>
+    std::vector<std::string> assetMirrors;          // --asset-mirror <url|dir>, repeatable: other sources of the release asset
+    uint64_t storeMaxBytes = kDefaultStoreMaxBytes; // --store-max <MB>: size cap of the release store
+    std::string apiBaseUrl = "https://api.github.com"; // --mirror <url>: where to ask for the latest release
+    bool exportCookies = false;                     // --export-cookies: hand yt-dlp a cookies.txt instead of the browser
+    std::vector<std::string> cookieDomains;         // --cookie-domain <domain>, repeatable: sites to export (default YouTube, Twitch)
+    std::chrono::seconds cookieRefreshInterval{10 * 60}; // --cookie-refresh <duration>: how often the daemon refreshes it
+    std::string companionManifest;                  // --companions <file>: tools to keep next to yt-dlp.exe
+    std::string listenAddress = "0.0.0.0";          // --listen <address:port> for serve
+    int listenPort = 8080;
+    std::string reportPath;                         // --report <file>: JSON timing report of each run
+    std::string prometheusPath;                     // --prometheus <file>: the same as a Prometheus textfile
+    LogOptions log;                                 // --verbose, --log-level <level>, --log-file <file>,
+                                                    // --log-max-size <size>
+    std::string command;                            // "rollback", "versions" or "serve"; "" to check for updates
+    std::string commandArgument;                    // rollback: release tag to go back to
+};
+
+// Function to parse the command line into options. An optional command
+// ("rollback [tag]", "versions" or "serve") replaces the update check. "--config <file>" reads
+// further options from a file, one per line as they'd be written on the command
+// line ("--browser firefox"), with # comments; options after it override the file.
+bool ParseOptions(int argc, char* argv[], UpdaterOptions& options);
+
+// Function to print the command line synopsis
+void PrintUsage(const char* program);
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Platform layer: everything the updater needs from the operating system beyond
+// networking and std::filesystem. Exactly one backend is compiled in
+// (platform_win.cpp or platform_posix.cpp).
+
+// Function to get the VRChat Tools directory path, "" on failure
+std::string GetVRChatToolsPath();
+
+// Function to find the VRChat Tools directories of every user profile on this
+// machine that has VRChat data (the Tools directory itself may not exist yet)
+std::vector<std::string> DiscoverVRChatToolsPaths();
+
+// Function to join a directory and a file name with the platform's separator
+std::string JoinPath(const std::string& directory, const std::string& name);
+
+// Function to remove read-only attribute from a file
+bool RemoveReadOnlyAttribute(const std::string& filePath);
+
+// Function to set read-only attribute on a file
+bool SetReadOnlyAttribute(const std::string& filePath);
+
+// Function to log the attributes of a file or directory for diagnostics (at
+// debug level; nothing is read unless --verbose asks for it)
+void CheckAttributes(const std::string& path, const std::string& label);
+
+// Function to give a file the medium mandatory integrity label so VRChat (which
+// runs at a lower integrity level than the updater) is allowed to execute it
+bool SetMediumIntegrityLevel(const std::string& filePath);
+
+// Function to check whether two paths are owned by the same account. A hard link
+// shares the file's permissions, so it's only a valid install across same-owner directories.
+bool SameOwner(const std::string& pathA, const std::string& pathB);
+
+// Function to create target as a copy-on-write clone of source, false where the
+// filesystem can't do that (the caller then falls back to a plain copy)
+bool CloneFile(const std::string& source, const std::string& target);
+
+// Function to write a file's contents through to disk. Call it while the file
+// is still writable; a read-only file can't be opened for writing on Windows.
+bool FlushFileToDisk(const std::string& filePath);
+
+// Function to move source over target in a single rename, even when source or
+// target is read-only or (on Windows) target is a running executable, and
+// persist the rename. source must already be flushed (FlushFileToDisk). Both
+// must be in the same directory. false where the OS can't do that in one step.
+bool ReplaceFileAtomically(const std::string& source, const std::string& target);
+
+// Function to get the bytes received so far by all physical network interfaces
+// together (loopback excluded), false where the counters can't be read
+bool ReadReceivedBytes(uint64_t& bytes);
+
+// Function to check whether a process with one of the given executable names
+// (e.g. "VRChat.exe", compared case-insensitively) is running; found gets the matching name
+bool FindRunningProcess(const std::vector<std::string>& names, std::string& found);
+
+// Function to run an executable with arguments, its output discarded, and wait
+// for it to exit. false if it couldn't be started at all.
+bool RunProcess(const std::string& executable, const std::vector<std::string>& arguments, int& exitCode);
+
+// Function to evict a file's cached pages from memory, so the next read comes
+// from disk (best effort; false where the OS doesn't let us)
+bool DropFromFileCache(const std::string& filePath);
+
+// Function to get the directory a browser keeps its data in: Firefox's
+// directory of profiles, or a Chromium browser's "User Data" directory (the
+// one with "Local State" in it). "" if the browser isn't supported here.
+std::string GetBrowserDataPath(const std::string& browser);
+
+// Function to decrypt data the current user protected with DPAPI (Chromium's
+// cookie key on Windows), false where that isn't available
+bool UnprotectUserData(const std::string& data, std::string& plain);
+
+// Function to route Ctrl+C / SIGINT / SIGTERM (console close, logoff and
+// shutdown on Windows) into a shutdown request instead of killing the process
+bool InstallShutdownHandler();
+
+// Function to sleep for up to timeout, returns true as soon as a shutdown has been requested
+bool WaitForShutdown(std::chrono::milliseconds timeout);
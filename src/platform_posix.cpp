@@ -0,0 +1,498 @@
+#include "platform.h"
+
+#include <csignal>
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string.h>
+#include <utility>
+#include <sys/stat.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "logger.h"
+#ifdef __linux__
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/xattr.h>
+#endif
+
+namespace fs = std::filesystem;
+
+extern char** environ;
+
+namespace {
+
+// VRChat's Steam app id; under Proton its Windows profile lives in this prefix
+const char* const kVRChatCompatDataPath = "steamapps/compatdata/438100/pfx/drive_c/users/steamuser/AppData/LocalLow/VRChat/VRChat";
+
+// DOS attribute bits as Wine stores them in the user.DOSATTRIB extended attribute
+const unsigned long kDosHidden = 0x2;
+const unsigned long kDosSystem = 0x4;
+
+// Self-pipe the signal handler writes to, so WaitForShutdown can wake up on it
+int g_shutdownPipe[2] = {-1, -1};
+volatile sig_atomic_t g_shutdownRequested = 0;
+
+void OnShutdownSignal(int) {
+    g_shutdownRequested = 1;
+    if (g_shutdownPipe[1] != -1) {
+        ssize_t ignored = write(g_shutdownPipe[1], "x", 1);
+        (void)ignored;
+    }
+}
+
+// Function to read the DOS attributes Wine keeps for a file (0 if there are none)
+unsigned long ReadDosAttributes(const std::string& path) {
+#ifdef __linux__
+    char value[32] = {};
+    ssize_t length = getxattr(path.c_str(), "user.DOSATTRIB", value, sizeof(value) - 1);
+    if (length > 0) {
+        return std::strtoul(value, nullptr, 0);
+    }
+#else
+    (void)path;
+#endif
+    return 0;
+}
+
+// Function to add and remove permission bits on a file
+bool ChangeMode(const std::string& filePath, mode_t add, mode_t remove, const char* action) {
+    struct stat info;
+    if (stat(filePath.c_str(), &info) != 0) {
+        LogError() << "Failed to get file attributes: " << filePath;
+        LogError() << "Error code: " << errno << " - " << strerror(errno);
+        return false;
+    }
+
+    mode_t mode = ((info.st_mode & 07777) | add) & ~remove;
+    if (mode != (info.st_mode & 07777) && chmod(filePath.c_str(), mode) != 0) {
+        LogError() << "Failed to " << action << ": " << filePath;
+        LogError() << "Error code: " << errno << " - " << strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+std::string GetEnv(const char* name) {
+    const char* value = std::getenv(name);
+    return value ? value : "";
+}
+
+// Function to list the Tools directories of the VRChat Proton prefixes in a
+// user's Steam installations (native, legacy ~/.steam and Flatpak)
+std::vector<std::string> FindProtonToolsPaths(const std::string& home, const std::string& dataHome) {
+    std::string steamRoots[] = {
+        dataHome + "/Steam",
+        home + "/.steam/steam",
+        home + "/.var/app/com.valvesoftware.Steam/.local/share/Steam"
+    };
+
+    std::vector<std::string> toolsPaths;
+    for (const auto& steamRoot : steamRoots) {
+        std::string vrchatPath = steamRoot + "/" + kVRChatCompatDataPath;
+        std::error_code ec;
+        if (!fs::is_directory(vrchatPath, ec)) {
+            continue;
+        }
+
+        // ~/.steam/steam is usually a symlink to one of the other roots
+        std::string toolsPath = fs::canonical(vrchatPath, ec).string() + "/Tools";
+        if (!ec && std::find(toolsPaths.begin(), toolsPaths.end(), toolsPath) == toolsPaths.end()) {
+            toolsPaths.push_back(toolsPath);
+        }
+    }
+    return toolsPaths;
+}
+
+} // namespace
+
+void CheckAttributes(const std::string& path, const std::string& label) {
+    if (!LogEnabled(LogLevel::Debug)) {
+        return;
+    }
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) {
+        LogDebug() << "Failed to get attributes for " << label << ": " << path;
+        return;
+    }
+
+    unsigned long dosAttributes = ReadDosAttributes(path);
+    bool hidden = fs::path(path).filename().string().rfind('.', 0) == 0 || (dosAttributes & kDosHidden);
+
+    LogLine line(LogLevel::Debug);
+    line << "Attributes for " << label << " (" << path << "): ";
+    if (!(info.st_mode & (S_IWUSR | S_IWGRP | S_IWOTH))) line << "READONLY ";
+    if (hidden) line << "HIDDEN ";
+    if (dosAttributes & kDosSystem) line << "SYSTEM ";
+    if (S_ISDIR(info.st_mode)) line << "DIRECTORY ";
+}
+
+bool RemoveReadOnlyAttribute(const std::string& filePath) {
+    // Check if the path is a file (not a directory)
+    if (!fs::is_regular_file(filePath)) {
+        LogError() << "Path is not a file: " << filePath;
+        return false;
+    }
+
+    struct stat info;
+    if (stat(filePath.c_str(), &info) == 0 && !(info.st_mode & S_IWUSR)) {
+        if (!ChangeMode(filePath, S_IWUSR, 0, "remove read-only attribute")) {
+            return false;
+        }
+        LogDebug() << "Removed read-only attribute from: " << filePath;
+    }
+    return true;
+}
+
+bool SetReadOnlyAttribute(const std::string& filePath) {
+    // Check if the path is a file (not a directory)
+    if (!fs::is_regular_file(filePath)) {
+        LogError() << "Path is not a file: " << filePath;
+        return false;
+    }
+
+    // Wine reports a file without write permission as FILE_ATTRIBUTE_READONLY
+    if (!ChangeMode(filePath, 0, S_IWUSR | S_IWGRP | S_IWOTH, "set read-only attribute")) {
+        return false;
+    }
+    LogDebug() << "Set read-only attribute on: " << filePath;
+    return true;
+}
+
+// There are no integrity levels here; the equivalent requirement is that the
+// binary may be executed by whoever can read it
+bool SetMediumIntegrityLevel(const std::string& filePath) {
+    struct stat info;
+    if (stat(filePath.c_str(), &info) != 0) {
+        LogError() << "Failed to get file attributes: " << filePath;
+        return false;
+    }
+
+    mode_t execute = 0;
+    if (info.st_mode & S_IRUSR) execute |= S_IXUSR;
+    if (info.st_mode & S_IRGRP) execute |= S_IXGRP;
+    if (info.st_mode & S_IROTH) execute |= S_IXOTH;
+    return ChangeMode(filePath, execute, 0, "set execute permission");
+}
+
+std::string JoinPath(const std::string& directory, const std::string& name) {
+    return directory + "/" + name;
+}
+
+// VRChat is a Windows application; on Linux it runs under Steam's Proton, so the
+// Tools directory lives inside its Wine prefix. Steam's data directory follows
+// the XDG base directory spec, with the legacy ~/.steam link and the Flatpak
+// location as fallbacks.
+std::string GetVRChatToolsPath() {
+    std::string home = GetEnv("HOME");
+    std::string dataHome = GetEnv("XDG_DATA_HOME");
+    if (dataHome.empty() && !home.empty()) {
+        dataHome = home + "/.local/share";
+    }
+    if (dataHome.empty()) {
+        LogError() << "Failed to get the data directory: neither XDG_DATA_HOME nor HOME is set";
+        return "";
+    }
+
+    std::vector<std::string> toolsPaths = FindProtonToolsPaths(home, dataHome);
+    if (!toolsPaths.empty()) {
+        return toolsPaths.front();
+    }
+
+    // No Proton prefix yet: keep the same layout under the XDG data directory
+    return dataHome + "/VRChat/VRChat/Tools";
+}
+
+std::vector<std::string> DiscoverVRChatToolsPaths() {
+    std::vector<std::string> toolsPaths;
+    std::string home = GetEnv("HOME");
+    std::string dataHome = GetEnv("XDG_DATA_HOME");
+    if (dataHome.empty() && !home.empty()) {
+        dataHome = home + "/.local/share";
+    }
+    if (!dataHome.empty()) {
+        toolsPaths = FindProtonToolsPaths(home, dataHome);
+    }
+
+    // Other accounts, assuming the default data directory
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator("/home", ec)) {
+        std::string userHome = entry.path().string();
+        if (userHome == home) {
+            continue;
+        }
+        for (const auto& toolsPath : FindProtonToolsPaths(userHome, userHome + "/.local/share")) {
+            if (std::find(toolsPaths.begin(), toolsPaths.end(), toolsPath) == toolsPaths.end()) {
+                toolsPaths.push_back(toolsPath);
+            }
+        }
+    }
+    return toolsPaths;
+}
+
+bool SameOwner(const std::string& pathA, const std::string& pathB) {
+    struct stat infoA;
+    struct stat infoB;
+    return stat(pathA.c_str(), &infoA) == 0 && stat(pathB.c_str(), &infoB) == 0 && infoA.st_uid == infoB.st_uid;
+}
+
+bool CloneFile(const std::string& source, const std::string& target) {
+#ifdef FICLONE
+    int sourceFd = open(source.c_str(), O_RDONLY | O_CLOEXEC);
+    if (sourceFd < 0) {
+        return false;
+    }
+    int targetFd = open(target.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (targetFd < 0) {
+        close(sourceFd);
+        return false;
+    }
+
+    // Btrfs and XFS share the extents; everything else refuses
+    bool cloned = ioctl(targetFd, FICLONE, sourceFd) == 0;
+    close(targetFd);
+    close(sourceFd);
+    if (!cloned) {
+        unlink(target.c_str());
+    }
+    return cloned;
+#else
+    (void)source;
+    (void)target;
+    return false;
+#endif
+}
+
+bool FlushFileToDisk(const std::string& filePath) {
+    int fileFd = open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fileFd < 0 || fsync(fileFd) != 0) {
+        LogError() << "Failed to flush " << filePath << ": " << strerror(errno);
+        if (fileFd >= 0) {
+            close(fileFd);
+        }
+        return false;
+    }
+    close(fileFd);
+    return true;
+}
+
+bool ReplaceFileAtomically(const std::string& source, const std::string& target) {
+    // rename() replaces the directory entry atomically; the file's own mode doesn't matter
+    if (rename(source.c_str(), target.c_str()) != 0) {
+        LogError() << "Failed to move " << source << " to " << target << ": " << strerror(errno);
+        return false;
+    }
+
+    // Persist the directory entry too
+    int directoryFd = open(fs::path(target).parent_path().c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (directoryFd >= 0) {
+        fsync(directoryFd);
+        close(directoryFd);
+    }
+    return true;
+}
+
+bool ReadReceivedBytes(uint64_t& bytes) {
+#ifdef __linux__
+    std::ifstream netDev("/proc/net/dev");
+    if (!netDev.is_open()) {
+        return false;
+    }
+
+    // Two header lines, then one "name: rx_bytes rx_packets ..." line per interface
+    bytes = 0;
+    std::string line;
+    while (std::getline(netDev, line)) {
+        size_t colon = line.find(':');
+        if (colon == std::string::npos) {
+            continue;
+        }
+        size_t nameBegin = line.find_first_not_of(' ');
+        if (line.compare(nameBegin, colon - nameBegin, "lo") == 0) {
+            continue;
+        }
+        bytes += std::strtoull(line.c_str() + colon + 1, nullptr, 10);
+    }
+    return true;
+#else
+    (void)bytes;
+    return false;
+#endif
+}
+
+bool FindRunningProcess(const std::vector<std::string>& names, std::string& found) {
+    auto sameName = [](const std::string& a, const std::string& b) {
+        return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+            return std::tolower(static_cast<unsigned char>(x)) == std::tolower(static_cast<unsigned char>(y));
+        });
+    };
+
+    std::error_code ec;
+    for (fs::directory_iterator it("/proc", ec), end; !ec && it != end; it.increment(ec)) {
+        std::string pid = it->path().filename().string();
+        if (pid.empty() || !std::all_of(pid.begin(), pid.end(), [](char c) { return std::isdigit(static_cast<unsigned char>(c)); })) {
+            continue;
+        }
+
+        // comm is cut at 15 characters, so take argv[0]; under Wine that's the Windows path of the .exe
+        std::ifstream cmdline(it->path() / "cmdline", std::ios::binary);
+        std::string argv0;
+        std::getline(cmdline, argv0, '\0');
+        std::string name = argv0.substr(argv0.find_last_of("/\\") + 1);
+        if (name.empty()) {
+            continue;
+        }
+        for (const auto& candidate : names) {
+            if (sameName(name, candidate)) {
+                found = candidate;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool RunProcess(const std::string& executable, const std::vector<std::string>& arguments, int& exitCode) {
+    std::vector<char*> argv;
+    argv.push_back(const_cast<char*>(executable.c_str()));
+    for (const auto& argument : arguments) {
+        argv.push_back(const_cast<char*>(argument.c_str()));
+    }
+    argv.push_back(nullptr);
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+    posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+    posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null", O_WRONLY, 0);
+    pid_t pid = 0;
+    int result = posix_spawn(&pid, executable.c_str(), &actions, nullptr, argv.data(), environ);
+    posix_spawn_file_actions_destroy(&actions);
+    if (result != 0) {
+        LogError() << "Failed to start " << executable << ": " << strerror(result);
+        return false;
+    }
+
+    int status = 0;
+    while (waitpid(pid, &status, 0) < 0) {
+        if (errno != EINTR) {
+            LogError() << "Failed to wait for " << executable << ": " << strerror(errno);
+            return false;
+        }
+    }
+    exitCode = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+    return true;
+}
+
+std::string GetBrowserDataPath(const std::string& browser) {
+    std::string home = GetEnv("HOME");
+    std::string configHome = GetEnv("XDG_CONFIG_HOME");
+    if (configHome.empty() && !home.empty()) {
+        configHome = home + "/.config";
+    }
+    if (home.empty()) {
+        return "";
+    }
+
+    // Firefox may also be the Snap or Flatpak package
+    if (browser == "firefox") {
+        std::string candidates[] = {
+            home + "/.mozilla/firefox",
+            home + "/snap/firefox/common/.mozilla/firefox",
+            home + "/.var/app/org.mozilla.firefox/.mozilla/firefox"
+        };
+        for (const auto& candidate : candidates) {
+            std::error_code ec;
+            if (fs::is_directory(candidate, ec)) {
+                return candidate;
+            }
+        }
+        return candidates[0];
+    }
+
+    static const std::pair<const char*, const char*> chromiumBrowsers[] = {
+        {"chrome", "google-chrome"},
+        {"chromium", "chromium"},
+        {"brave", "BraveSoftware/Brave-Browser"},
+        {"edge", "microsoft-edge"},
+        {"opera", "opera"},
+        {"vivaldi", "vivaldi"},
+        {"whale", "naver-whale"}
+    };
+    for (const auto& chromiumBrowser : chromiumBrowsers) {
+        if (browser == chromiumBrowser.first) {
+            return configHome + "/" + chromiumBrowser.second;
+        }
+    }
+    return "";
+}
+
+bool UnprotectUserData(const std::string& data, std::string& plain) {
+    // DPAPI only exists on Windows; Linux browsers use their own keys
+    (void)data;
+    (void)plain;
+    return false;
+}
+
+bool DropFromFileCache(const std::string& filePath) {
+#ifdef POSIX_FADV_DONTNEED
+    int fd = open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    // Clean pages are dropped right away, without needing root
+    bool dropped = posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+    close(fd);
+    return dropped;
+#else
+    (void)filePath;
+    return false;
+#endif
+}
+
+bool InstallShutdownHandler() {
+    if (pipe(g_shutdownPipe) != 0) {
+        LogError() << "Failed to create shutdown pipe: " << strerror(errno);
+        return false;
+    }
+    for (int fd : g_shutdownPipe) {
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    }
+
+    // A second signal gets the default action, so a stuck shutdown can still be forced
+    struct sigaction action = {};
+    action.sa_handler = OnShutdownSignal;
+    action.sa_flags = SA_RESETHAND;
+    sigemptyset(&action.sa_mask);
+    if (sigaction(SIGINT, &action, nullptr) != 0 || sigaction(SIGTERM, &action, nullptr) != 0) {
+        LogError() << "Failed to install signal handlers: " << strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+bool WaitForShutdown(std::chrono::milliseconds timeout) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (!g_shutdownRequested) {
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        if (remaining.count() <= 0) {
+            return false;
+        }
+
+        struct pollfd fd = {g_shutdownPipe[0], POLLIN, 0};
+        int ready = poll(&fd, g_shutdownPipe[0] != -1 ? 1 : 0, static_cast<int>(remaining.count()));
+        if (ready < 0 && errno != EINTR) {
+            LogError() << "poll() failed: " << strerror(errno);
+            return false;
+        }
+    }
+    return true;
+}
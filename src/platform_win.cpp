@@ -0,0 +1,524 @@
+#include "platform.h"
+
+// windows.h has to come before the other Win32 headers, winsock2.h before windows.h
+#include <winsock2.h>
+#include <windows.h>
+#include <aclapi.h>
+#include <dpapi.h>
+#include <ws2ipdef.h>
+#include <iphlpapi.h>
+#include <sddl.h>
+#include <shlobj.h>
+#include <tlhelp32.h>
+
+#include <cstring>
+#include <filesystem>
+#include <vector>
+#include "logger.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Manual-reset event signalled by the console control handler
+HANDLE g_shutdownEvent = NULL;
+
+BOOL WINAPI OnConsoleControl(DWORD controlType) {
+    switch (controlType) {
+    case CTRL_C_EVENT:
+    case CTRL_BREAK_EVENT:
+    case CTRL_CLOSE_EVENT:
+    case CTRL_LOGOFF_EVENT:
+    case CTRL_SHUTDOWN_EVENT:
+        SetEvent(g_shutdownEvent);
+        return TRUE;
+    default:
+        return FALSE;
+    }
+}
+
+// Function to get error message from error code
+std::string GetErrorMessage(DWORD errorCode) {
+    LPSTR messageBuffer = nullptr;
+    size_t size = FormatMessageA(
+        FORMAT_MESSAGE_ALLOCATE_BUFFER | FORMAT_MESSAGE_FROM_SYSTEM | FORMAT_MESSAGE_IGNORE_INSERTS,
+        NULL,
+        errorCode,
+        MAKELANGID(LANG_NEUTRAL, SUBLANG_DEFAULT),
+        (LPSTR)&messageBuffer,
+        0,
+        NULL
+    );
+    
+    if (size == 0 || messageBuffer == nullptr) {
+        return "Unknown error";
+    }
+    
+    std::string message(messageBuffer);
+    LocalFree(messageBuffer);
+    
+    // Trim whitespace and newlines from the end
+    while (!message.empty() && (message.back() == '\n' || message.back() == '\r' || message.back() == ' ')) {
+        message.pop_back();
+    }
+    
+    return message;
+}
+
+// Function to convert a UTF-8 path to the wide form the W APIs expect
+std::wstring ToWide(const std::string& value) {
+    int length = MultiByteToWideChar(CP_UTF8, 0, value.c_str(), -1, NULL, 0);
+    if (length <= 0) {
+        return L"";
+    }
+    std::wstring wide(length, L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, value.c_str(), -1, &wide[0], length);
+    wide.resize(length - 1);
+    return wide;
+}
+
+// Function to convert a wide string from a W API to UTF-8
+std::string ToNarrow(const wchar_t* value) {
+    int length = WideCharToMultiByte(CP_UTF8, 0, value, -1, NULL, 0, NULL, NULL);
+    if (length <= 0) {
+        return "";
+    }
+    std::string narrow(length, '\0');
+    WideCharToMultiByte(CP_UTF8, 0, value, -1, &narrow[0], length, NULL, NULL);
+    narrow.resize(length - 1);
+    return narrow;
+}
+
+} // namespace
+
+// Function to check file attributes
+void CheckAttributes(const std::string& path, const std::string& label) {
+    if (!LogEnabled(LogLevel::Debug)) {
+        return;
+    }
+    DWORD attributes = GetFileAttributesW(ToWide(path).c_str());
+    if (attributes == INVALID_FILE_ATTRIBUTES) {
+        LogDebug() << "Failed to get attributes for " << label << ": " << path;
+        return;
+    }
+    
+    LogLine line(LogLevel::Debug);
+    line << "Attributes for " << label << " (" << path << "): ";
+    if (attributes & FILE_ATTRIBUTE_READONLY) line << "READONLY ";
+    if (attributes & FILE_ATTRIBUTE_HIDDEN) line << "HIDDEN ";
+    if (attributes & FILE_ATTRIBUTE_SYSTEM) line << "SYSTEM ";
+    if (attributes & FILE_ATTRIBUTE_DIRECTORY) line << "DIRECTORY ";
+}
+
+// Function to remove read-only attribute from a file
+bool RemoveReadOnlyAttribute(const std::string& filePath) {
+    // Check if the path is a file (not a directory)
+    if (!fs::is_regular_file(filePath)) {
+        LogError() << "Path is not a file: " << filePath;
+        return false;
+    }
+    
+    std::wstring widePath = ToWide(filePath);
+    DWORD attributes = GetFileAttributesW(widePath.c_str());
+    if (attributes == INVALID_FILE_ATTRIBUTES) {
+        DWORD error = GetLastError();
+        LogError() << "Failed to get file attributes: " << filePath;
+        LogError() << "Error code: " << error << " - " << GetErrorMessage(error);
+        return false;
+    }
+    
+    if (attributes & FILE_ATTRIBUTE_READONLY) {
+        attributes &= ~FILE_ATTRIBUTE_READONLY;
+        if (!SetFileAttributesW(widePath.c_str(), attributes)) {
+            DWORD error = GetLastError();
+            LogError() << "Failed to remove read-only attribute: " << filePath;
+            LogError() << "Error code: " << error << " - " << GetErrorMessage(error);
+            return false;
+        }
+        LogDebug() << "Removed read-only attribute from: " << filePath;
+    }
+    
+    return true;
+}
+
+// Function to set read-only attribute on a file
+bool SetReadOnlyAttribute(const std::string& filePath) {
+    // Check if the path is a file (not a directory)
+    if (!fs::is_regular_file(filePath)) {
+        LogError() << "Path is not a file: " << filePath;
+        return false;
+    }
+    
+    std::wstring widePath = ToWide(filePath);
+    DWORD attributes = GetFileAttributesW(widePath.c_str());
+    if (attributes == INVALID_FILE_ATTRIBUTES) {
+        DWORD error = GetLastError();
+        LogError() << "Failed to get file attributes: " << filePath;
+        LogError() << "Error code: " << error << " - " << GetErrorMessage(error);
+        return false;
+    }
+    
+    attributes |= FILE_ATTRIBUTE_READONLY;
+    if (!SetFileAttributesW(widePath.c_str(), attributes)) {
+        DWORD error = GetLastError();
+        LogError() << "Failed to set read-only attribute: " << filePath;
+        LogError() << "Error code: " << error << " - " << GetErrorMessage(error);
+        return false;
+    }
+    LogDebug() << "Set read-only attribute on: " << filePath;
+    
+    return true;
+}
+
+// Function to set the medium mandatory label in-process (what
+// "icacls <file> /setintegritylevel medium" does, without spawning a shell)
+bool SetMediumIntegrityLevel(const std::string& filePath) {
+    // Medium integrity, no-write-up: the same label icacls applies
+    PSECURITY_DESCRIPTOR descriptor = nullptr;
+    if (!ConvertStringSecurityDescriptorToSecurityDescriptorW(L"S:(ML;;NW;;;ME)", SDDL_REVISION_1, &descriptor, NULL)) {
+        DWORD error = GetLastError();
+        LogError() << "Failed to build integrity label. Error code: " << error << " - " << GetErrorMessage(error);
+        return false;
+    }
+    
+    PACL sacl = nullptr;
+    BOOL saclPresent = FALSE;
+    BOOL saclDefaulted = FALSE;
+    if (!GetSecurityDescriptorSacl(descriptor, &saclPresent, &sacl, &saclDefaulted) || !saclPresent) {
+        DWORD error = GetLastError();
+        LogError() << "Failed to read integrity label. Error code: " << error << " - " << GetErrorMessage(error);
+        LocalFree(descriptor);
+        return false;
+    }
+    
+    std::wstring widePath = ToWide(filePath);
+    DWORD result = SetNamedSecurityInfoW(&widePath[0], SE_FILE_OBJECT, LABEL_SECURITY_INFORMATION,
+                                         NULL, NULL, NULL, sacl);
+    LocalFree(descriptor);
+    
+    if (result != ERROR_SUCCESS) {
+        LogError() << "Failed to set integrity level on " << filePath;
+        LogError() << "Error code: " << result << " - " << GetErrorMessage(result);
+        return false;
+    }
+    
+    return true;
+}
+
+std::string JoinPath(const std::string& directory, const std::string& name) {
+    return directory + "\\" + name;
+}
+
+// Function to get the VRChat Tools directory path
+std::string GetVRChatToolsPath() {
+    PWSTR localAppDataLowPath = nullptr;
+    HRESULT hr = SHGetKnownFolderPath(FOLDERID_LocalAppDataLow, 0, NULL, &localAppDataLowPath);
+    
+    if (FAILED(hr) || !localAppDataLowPath) {
+        LogError() << "Failed to get LocalAppDataLow folder path. Error code: " << hr;
+        return "";
+    }
+    
+    // Convert wide string to narrow string
+    int bufferSize = WideCharToMultiByte(CP_UTF8, 0, localAppDataLowPath, -1, NULL, 0, NULL, NULL);
+    std::string localAppDataLow(bufferSize, 0);
+    int result = WideCharToMultiByte(CP_UTF8, 0, localAppDataLowPath, -1, &localAppDataLow[0], bufferSize, NULL, NULL);
+    
+    // Ensure the string is properly null-terminated and doesn't have extra characters
+    if (result > 0) {
+        localAppDataLow.resize(result - 1);
+    }
+    
+    // Free the wide string
+    CoTaskMemFree(localAppDataLowPath);
+    
+    // Construct the full path
+    std::string vrchatToolsPath = localAppDataLow + "\\VRChat\\VRChat\\Tools";
+    return vrchatToolsPath;
+}
+
+std::vector<std::string> DiscoverVRChatToolsPaths() {
+    std::vector<std::string> toolsPaths;
+    
+    // Every local account's profile directory is listed under ProfileList
+    HKEY profileList = NULL;
+    LONG status = RegOpenKeyExW(HKEY_LOCAL_MACHINE, L"SOFTWARE\\Microsoft\\Windows NT\\CurrentVersion\\ProfileList", 0, KEY_READ, &profileList);
+    if (status != ERROR_SUCCESS) {
+        LogError() << "Failed to open the profile list: " << GetErrorMessage(status);
+        return toolsPaths;
+    }
+    
+    wchar_t sid[256];
+    for (DWORD index = 0;; ++index) {
+        DWORD sidLength = sizeof(sid) / sizeof(sid[0]);
+        if (RegEnumKeyExW(profileList, index, sid, &sidLength, NULL, NULL, NULL, NULL) != ERROR_SUCCESS) {
+            break;
+        }
+        
+        // REG_EXPAND_SZ values are expanded when asking for REG_SZ
+        wchar_t profilePath[MAX_PATH];
+        DWORD pathSize = sizeof(profilePath);
+        if (RegGetValueW(profileList, sid, L"ProfileImagePath", RRF_RT_REG_SZ, NULL, profilePath, &pathSize) != ERROR_SUCCESS) {
+            continue;
+        }
+        
+        std::string vrchatPath = ToNarrow(profilePath) + "\\AppData\\LocalLow\\VRChat\\VRChat";
+        std::error_code ec;
+        if (fs::is_directory(vrchatPath, ec)) {
+            toolsPaths.push_back(vrchatPath + "\\Tools");
+        }
+    }
+    
+    RegCloseKey(profileList);
+    return toolsPaths;
+}
+
+bool SameOwner(const std::string& pathA, const std::string& pathB) {
+    PSID owners[2] = {NULL, NULL};
+    PSECURITY_DESCRIPTOR descriptors[2] = {NULL, NULL};
+    const std::string* paths[2] = {&pathA, &pathB};
+    
+    bool ok = true;
+    for (int i = 0; i < 2 && ok; ++i) {
+        std::wstring widePath = ToWide(*paths[i]);
+        ok = GetNamedSecurityInfoW(widePath.c_str(), SE_FILE_OBJECT, OWNER_SECURITY_INFORMATION,
+                                   &owners[i], NULL, NULL, NULL, &descriptors[i]) == ERROR_SUCCESS;
+    }
+    bool same = ok && EqualSid(owners[0], owners[1]);
+    
+    for (PSECURITY_DESCRIPTOR descriptor : descriptors) {
+        if (descriptor) {
+            LocalFree(descriptor);
+        }
+    }
+    return same;
+}
+
+bool CloneFile(const std::string& source, const std::string& target) {
+    // CopyFile already uses block cloning on volumes that support it (ReFS, Dev
+    // Drive), so the plain copy fallback gets the same benefit there
+    (void)source;
+    (void)target;
+    return false;
+}
+
+bool FlushFileToDisk(const std::string& filePath) {
+    HANDLE file = CreateFileW(ToWide(filePath).c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_DELETE,
+                              NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        LogError() << "Failed to open " << filePath << ": " << GetErrorMessage(GetLastError());
+        return false;
+    }
+    bool flushed = FlushFileBuffers(file) != FALSE;
+    DWORD error = GetLastError();
+    CloseHandle(file);
+    if (!flushed) {
+        LogError() << "Failed to flush " << filePath << ": " << GetErrorMessage(error);
+    }
+    return flushed;
+}
+
+bool ReplaceFileAtomically(const std::string& source, const std::string& target) {
+#ifdef FILE_RENAME_FLAG_POSIX_SEMANTICS
+    // Windows 10 1809+: a POSIX-semantics rename replaces the target even while
+    // it's running or read-only, in one step. The source is read-only by now,
+    // so it is opened without write access to its data (FinishInstall has
+    // flushed it while it was still writable).
+    HANDLE file = CreateFileW(ToWide(source).c_str(), DELETE | FILE_WRITE_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_DELETE,
+                              NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        LogError() << "Failed to open " << source << ": " << GetErrorMessage(GetLastError());
+        return false;
+    }
+    
+    std::wstring wideTarget = ToWide(fs::absolute(target).string());
+    size_t size = sizeof(FILE_RENAME_INFO) + wideTarget.size() * sizeof(wchar_t);
+    std::vector<char> buffer(size, 0);
+    FILE_RENAME_INFO* info = reinterpret_cast<FILE_RENAME_INFO*>(buffer.data());
+    info->Flags = FILE_RENAME_FLAG_REPLACE_IF_EXISTS | FILE_RENAME_FLAG_POSIX_SEMANTICS | FILE_RENAME_FLAG_IGNORE_READONLY_ATTRIBUTE;
+    info->FileNameLength = static_cast<DWORD>(wideTarget.size() * sizeof(wchar_t));
+    memcpy(info->FileName, wideTarget.c_str(), info->FileNameLength);
+    
+    bool renamed = SetFileInformationByHandle(file, FileRenameInfoEx, info, static_cast<DWORD>(size)) != FALSE;
+    DWORD error = GetLastError();
+    CloseHandle(file);
+    if (!renamed) {
+        // Older Windows and some filesystems (FAT, network shares) reject the flags
+        LogError() << "Atomic replace of " << target << " not available: " << GetErrorMessage(error);
+    }
+    return renamed;
+#else
+    (void)source;
+    (void)target;
+    return false;
+#endif
+}
+
+bool ReadReceivedBytes(uint64_t& bytes) {
+    MIB_IF_TABLE2* table = nullptr;
+    DWORD result = GetIfTable2(&table);
+    if (result != NO_ERROR) {
+        LogError() << "Failed to read network interface counters: " << GetErrorMessage(result);
+        return false;
+    }
+
+    // Filter interfaces (QoS, WFP, virtual switches) repeat the traffic of the adapter below them
+    bytes = 0;
+    for (ULONG i = 0; i < table->NumEntries; ++i) {
+        const MIB_IF_ROW2& row = table->Table[i];
+        if (row.Type != IF_TYPE_SOFTWARE_LOOPBACK && row.InterfaceAndOperStatusFlags.HardwareInterface &&
+            !row.InterfaceAndOperStatusFlags.FilterInterface) {
+            bytes += row.InOctets;
+        }
+    }
+    FreeMibTable(table);
+    return true;
+}
+
+bool FindRunningProcess(const std::vector<std::string>& names, std::string& found) {
+    HANDLE snapshot = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
+    if (snapshot == INVALID_HANDLE_VALUE) {
+        LogError() << "Failed to list processes: " << GetErrorMessage(GetLastError());
+        return false;
+    }
+
+    std::vector<std::wstring> wideNames;
+    for (const auto& name : names) {
+        wideNames.push_back(ToWide(name));
+    }
+
+    bool running = false;
+    PROCESSENTRY32W entry = {};
+    entry.dwSize = sizeof(entry);
+    for (BOOL more = Process32FirstW(snapshot, &entry); more && !running; more = Process32NextW(snapshot, &entry)) {
+        for (size_t i = 0; i < wideNames.size(); ++i) {
+            if (_wcsicmp(entry.szExeFile, wideNames[i].c_str()) == 0) {
+                found = names[i];
+                running = true;
+                break;
+            }
+        }
+    }
+    CloseHandle(snapshot);
+    return running;
+}
+
+bool RunProcess(const std::string& executable, const std::vector<std::string>& arguments, int& exitCode) {
+    // Quote everything; the arguments we pass never contain quotes themselves
+    std::wstring commandLine = L"\"" + ToWide(executable) + L"\"";
+    for (const auto& argument : arguments) {
+        commandLine += L" \"" + ToWide(argument) + L"\"";
+    }
+
+    SECURITY_ATTRIBUTES inheritable = {sizeof(inheritable), NULL, TRUE};
+    HANDLE nul = CreateFileW(L"NUL", GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, &inheritable,
+                             OPEN_EXISTING, 0, NULL);
+    STARTUPINFOW startup = {};
+    startup.cb = sizeof(startup);
+    startup.dwFlags = STARTF_USESTDHANDLES;
+    startup.hStdInput = nul;
+    startup.hStdOutput = nul;
+    startup.hStdError = nul;
+
+    PROCESS_INFORMATION process = {};
+    BOOL created = CreateProcessW(ToWide(executable).c_str(), &commandLine[0], NULL, NULL, TRUE, CREATE_NO_WINDOW,
+                                  NULL, NULL, &startup, &process);
+    DWORD error = GetLastError();
+    if (nul != INVALID_HANDLE_VALUE) {
+        CloseHandle(nul);
+    }
+    if (!created) {
+        LogError() << "Failed to start " << executable << ": " << GetErrorMessage(error);
+        return false;
+    }
+
+    WaitForSingleObject(process.hProcess, INFINITE);
+    DWORD code = 0;
+    GetExitCodeProcess(process.hProcess, &code);
+    exitCode = static_cast<int>(code);
+    CloseHandle(process.hThread);
+    CloseHandle(process.hProcess);
+    return true;
+}
+
+bool DropFromFileCache(const std::string& filePath) {
+    // Opening a file unbuffered makes the cache manager flush and drop its
+    // cached pages, as long as no other handle has it open
+    HANDLE file = CreateFileW(ToWide(filePath).c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                              NULL, OPEN_EXISTING, FILE_FLAG_NO_BUFFERING, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    CloseHandle(file);
+    return true;
+}
+
+std::string GetBrowserDataPath(const std::string& browser) {
+    // Roaming or local application data, and the browser's directory under it
+    struct BrowserLocation {
+        const char* browser;
+        bool roaming;
+        const char* path;
+    };
+    static const BrowserLocation locations[] = {
+        {"firefox", true, "Mozilla\\Firefox\\Profiles"},
+        {"chrome", false, "Google\\Chrome\\User Data"},
+        {"chromium", false, "Chromium\\User Data"},
+        {"brave", false, "BraveSoftware\\Brave-Browser\\User Data"},
+        {"edge", false, "Microsoft\\Edge\\User Data"},
+        {"opera", true, "Opera Software\\Opera Stable"},
+        {"vivaldi", false, "Vivaldi\\User Data"},
+        {"whale", false, "Naver\\Naver Whale\\User Data"}
+    };
+    
+    for (const auto& location : locations) {
+        if (browser != location.browser) {
+            continue;
+        }
+        PWSTR folderPath = nullptr;
+        HRESULT hr = SHGetKnownFolderPath(location.roaming ? FOLDERID_RoamingAppData : FOLDERID_LocalAppData, 0, NULL, &folderPath);
+        if (FAILED(hr) || !folderPath) {
+            LogError() << "Failed to get the application data folder. Error code: " << hr;
+            return "";
+        }
+        std::string folder = ToNarrow(folderPath);
+        CoTaskMemFree(folderPath);
+        return folder + "\\" + location.path;
+    }
+    return "";
+}
+
+bool UnprotectUserData(const std::string& data, std::string& plain) {
+    DATA_BLOB input;
+    input.pbData = reinterpret_cast<BYTE*>(const_cast<char*>(data.data()));
+    input.cbData = static_cast<DWORD>(data.size());
+    DATA_BLOB output = {0, NULL};
+    if (!CryptUnprotectData(&input, NULL, NULL, NULL, NULL, 0, &output)) {
+        return false;
+    }
+    plain.assign(reinterpret_cast<const char*>(output.pbData), output.cbData);
+    SecureZeroMemory(output.pbData, output.cbData);
+    LocalFree(output.pbData);
+    return true;
+}
+
+bool InstallShutdownHandler() {
+    g_shutdownEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+    if (g_shutdownEvent == NULL) {
+        LogError() << "Failed to create shutdown event: " << GetErrorMessage(GetLastError());
+        return false;
+    }
+    if (!SetConsoleCtrlHandler(OnConsoleControl, TRUE)) {
+        LogError() << "Failed to install console control handler: " << GetErrorMessage(GetLastError());
+        return false;
+    }
+    return true;
+}
+
+bool WaitForShutdown(std::chrono::milliseconds timeout) {
+    if (g_shutdownEvent == NULL) {
+        Sleep(static_cast<DWORD>(timeout.count()));
+        return false;
+    }
+    return WaitForSingleObject(g_shutdownEvent, static_cast<DWORD>(timeout.count())) == WAIT_OBJECT_0;
+}
@@ -0,0 +1,62 @@
+#include "poll_scheduler.h"
+
+#include <cmath>
+#include <random>
+
+namespace {
+
+// Below this many remaining API calls, checks are spread out until the reset
+const long kLowRateLimitRemaining = 10;
+
+// Margin after the advertised reset time, for clock skew
+const std::chrono::seconds kRateLimitResetSlack(5);
+
+// Random spread applied to each delay so a fleet started together doesn't poll in lockstep
+const double kDelayJitter = 0.1;
+
+} // namespace
+
+PollScheduler::PollScheduler(std::chrono::seconds minInterval, std::chrono::seconds maxInterval)
+    : minInterval_(minInterval), maxInterval_(maxInterval < minInterval ? minInterval : maxInterval), interval_(minInterval) {}
+
+void PollScheduler::OnUnchanged() {
+    interval_ = interval_ * 2 > maxInterval_ ? maxInterval_ : interval_ * 2;
+}
+
+void PollScheduler::OnNewRelease() {
+    interval_ = minInterval_;
+}
+
+void PollScheduler::OnFailure() {
+    // Network trouble or an outage: back off the same way as a quiet period
+    OnUnchanged();
+}
+
+void PollScheduler::OnRateLimit(const RateLimit& rateLimit, std::time_t now) {
+    rateLimitFloor_ = std::chrono::seconds(0);
+
+    if (rateLimit.retryAfter >= 0) {
+        rateLimitFloor_ = std::chrono::seconds(rateLimit.retryAfter);
+    }
+
+    if (rateLimit.remaining < 0 || rateLimit.remaining >= kLowRateLimitRemaining || rateLimit.reset <= now) {
+        return;
+    }
+
+    // Out of calls: wait for the window to refill. Running low: spread what's left over the window.
+    std::chrono::seconds untilReset(static_cast<long long>(rateLimit.reset - now));
+    std::chrono::seconds floor = rateLimit.remaining == 0
+        ? untilReset + kRateLimitResetSlack
+        : untilReset / rateLimit.remaining;
+    if (floor > rateLimitFloor_) {
+        rateLimitFloor_ = floor;
+    }
+}
+
+std::chrono::seconds PollScheduler::NextDelay() {
+    static std::mt19937 generator(std::random_device{}());
+    std::uniform_real_distribution<double> spread(1.0 - kDelayJitter, 1.0 + kDelayJitter);
+
+    std::chrono::seconds delay(std::llround(interval_.count() * spread(generator)));
+    return delay > rateLimitFloor_ ? delay : rateLimitFloor_;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <chrono>
+#include <ctime>
+#include "http_headers.h"
+
+// Adaptive interval between release checks in daemon mode. Quiet periods
+// double the interval up to the maximum, a new release drops it back to the
+// minimum (follow-up hotfixes tend to land soon after), and the server's rate
+// limit puts a floor under whatever the next delay would be.
+class PollScheduler {
+public:
+    PollScheduler(std::chrono::seconds minInterval, std::chrono::seconds maxInterval);
+
+    // Function to record a check that found the release unchanged
+    void OnUnchanged();
+
+    // Function to record a check that found (and installed) a new release
+    void OnNewRelease();
+
+    // Function to record a failed check
+    void OnFailure();
+
+    // Function to record the rate limit reported with the last API response
+    void OnRateLimit(const RateLimit& rateLimit, std::time_t now);
+
+    // Function to get how long to sleep before the next check
+    std::chrono::seconds NextDelay();
+
+private:
+    std::chrono::seconds minInterval_;
+    std::chrono::seconds maxInterval_;
+    std::chrono::seconds interval_;
+    std::chrono::seconds rateLimitFloor_{0};
+};
@@ -0,0 +1,82 @@
+#include "release_cache.h"
+
+#include <filesystem>
+#include <fstream>
+#include <nlohmann/json.hpp>
+#include "logger.h"
+
+using json = nlohmann::json;
+namespace fs = std::filesystem;
+
+bool ReadReleaseCache(const std::string& cachePath, ReleaseCache& cache) {
+    if (!fs::exists(cachePath)) {
+        return false;
+    }
+
+    std::ifstream file(cachePath);
+    if (!file.is_open()) {
+        LogError() << "Failed to open release cache: " << cachePath;
+        return false;
+    }
+
+    try {
+        json data = json::parse(file);
+        cache.etag = data.value("etag", "");
+        cache.lastModified = data.value("last_modified", "");
+        cache.tagName = data.value("tag_name", "");
+        cache.downloadUrl = data.value("download_url", "");
+
+        // Caches written before checksums were verified can't answer for them
+        if (!data.contains("checksums_url")) {
+            return false;
+        }
+        cache.checksumsUrl = data.value("checksums_url", "");
+        cache.assetUrls = data.value("asset_urls", std::map<std::string, std::string>());
+    } catch (const json::exception& e) {
+        LogWarning() << "Ignoring invalid release cache: " << e.what();
+        return false;
+    }
+
+    // A cache without a validator or without the release it describes cannot answer a 304
+    if ((cache.etag.empty() && cache.lastModified.empty()) || cache.tagName.empty() || cache.downloadUrl.empty()) {
+        return false;
+    }
+
+    return true;
+}
+
+bool WriteReleaseCache(const std::string& cachePath, const ReleaseCache& cache) {
+    json data = {
+        {"etag", cache.etag},
+        {"last_modified", cache.lastModified},
+        {"tag_name", cache.tagName},
+        {"download_url", cache.downloadUrl},
+        {"checksums_url", cache.checksumsUrl},
+        {"asset_urls", cache.assetUrls}
+    };
+
+    std::string tempPath = cachePath + ".tmp";
+    std::ofstream file(tempPath, std::ios::trunc);
+    if (!file.is_open()) {
+        LogError() << "Failed to create release cache: " << tempPath;
+        return false;
+    }
+
+    file << data.dump(2);
+    file.close();
+    if (!file) {
+        LogError() << "Failed to write release cache: " << tempPath;
+        fs::remove(tempPath);
+        return false;
+    }
+
+    std::error_code ec;
+    fs::rename(tempPath, cachePath, ec);
+    if (ec) {
+        LogError() << "Failed to replace release cache: " << ec.message();
+        fs::remove(tempPath);
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <map>
+#include <string>
+
+// Release metadata remembered between runs so the GitHub API can be queried
+// conditionally (If-None-Match / If-Modified-Since). A 304 answer means the
+// cached tag and download URL are still current.
+struct ReleaseCache {
+    std::string etag;
+    std::string lastModified;
+    std::string tagName;
+    std::string downloadUrl;
+    std::string checksumsUrl;   // SHA2-256SUMS asset, empty if the release has none
+    std::map<std::string, std::string> assetUrls;   // every asset asked for, "" for those the release lacks
+};
+
+// Function to read the release cache, returns false if it is missing or unusable
+bool ReadReleaseCache(const std::string& cachePath, ReleaseCache& cache);
+
+// Function to write the release cache (written to a temporary file and renamed into place)
+bool WriteReleaseCache(const std::string& cachePath, const ReleaseCache& cache);
@@ -0,0 +1,196 @@
+#include "release_parser.h"
+
+#include <algorithm>
+#include <nlohmann/json.hpp>
+#include <vector>
+#include "logger.h"
+
+using json = nlohmann::json;
+
+namespace {
+
+const char* const kChecksumsAssetName = "SHA2-256SUMS";
+
+// Function to get the preference rank of an asset name, assetNames.size() if it isn't wanted
+size_t AssetRank(const std::vector<std::string>& assetNames, const std::string& name) {
+    return static_cast<size_t>(std::find(assetNames.begin(), assetNames.end(), name) - assetNames.begin());
+}
+
+// Function to describe the wanted assets for error messages
+std::string DescribeAssets(const std::vector<std::string>& assetNames) {
+    std::string description;
+    for (const auto& name : assetNames) {
+        description += (description.empty() ? "" : " or ") + name;
+    }
+    return description;
+}
+
+// SAX handler that tracks just enough structure to find the top-level tag_name
+// and the name/browser_download_url pairs of the top-level assets array
+class ReleaseSaxHandler : public nlohmann::json_sax<json> {
+public:
+    ReleaseSaxHandler(const std::vector<std::string>& assetNames, ReleaseFields& fields)
+        : assetNames_(assetNames), fields_(fields), bestRank_(assetNames.size()) {}
+
+    bool Complete() const { return !fields_.tagName.empty() && !fields_.downloadUrl.empty(); }
+    bool Stopped() const { return stopped_; }
+    const std::string& Error() const { return error_; }
+
+    bool null() override { return true; }
+    bool boolean(bool) override { return true; }
+    bool number_integer(number_integer_t) override { return true; }
+    bool number_unsigned(number_unsigned_t) override { return true; }
+    bool number_float(number_float_t, const string_t&) override { return true; }
+    bool binary(binary_t&) override { return true; }
+
+    bool string(string_t& value) override {
+        if (InTopLevelObject() && key_ == "tag_name") {
+            fields_.tagName = value;
+        } else if (InAsset() && key_ == "name") {
+            currentName_ = value;
+        } else if (InAsset() && key_ == "browser_download_url") {
+            currentUrl_ = value;
+        }
+        return true;
+    }
+
+    bool key(string_t& value) override {
+        // Keys of deeper objects are never needed, so don't copy them
+        if (InTopLevelObject() || InAsset()) {
+            key_ = value;
+        } else {
+            key_.clear();
+        }
+        return true;
+    }
+
+    bool start_object(std::size_t) override {
+        containers_.push_back('o');
+        if (InAsset()) {
+            currentName_.clear();
+            currentUrl_.clear();
+        }
+        return true;
+    }
+
+    bool end_object() override {
+        if (InAsset()) {
+            size_t rank = AssetRank(assetNames_, currentName_);
+            if (rank < assetNames_.size()) {
+                fields_.assetUrls[currentName_] = currentUrl_;
+            }
+            if (rank < bestRank_) {
+                fields_.downloadUrl = currentUrl_;
+                bestRank_ = rank;
+            } else if (currentName_ == kChecksumsAssetName) {
+                fields_.checksumsUrl = currentUrl_;
+            }
+        }
+        containers_.pop_back();
+        return Continue();
+    }
+
+    bool start_array(std::size_t) override {
+        if (InTopLevelObject() && key_ == "assets") {
+            inAssets_ = true;
+        }
+        containers_.push_back('a');
+        return true;
+    }
+
+    bool end_array() override {
+        containers_.pop_back();
+        if (inAssets_ && containers_.size() == 1) {
+            inAssets_ = false;
+            assetsDone_ = true;
+        }
+        return Continue();
+    }
+
+    bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception& e) override {
+        error_ = e.what();
+        return false;
+    }
+
+private:
+    bool InTopLevelObject() const { return containers_.size() == 1 && containers_[0] == 'o'; }
+    bool InAsset() const { return inAssets_ && containers_.size() == 3 && containers_[2] == 'o'; }
+
+    // Stop as soon as everything is known: every wanted asset (or the end of the
+    // assets array) and the checksum asset, which is optional, so without it the
+    // end of the assets array is the earliest stopping point
+    bool Continue() {
+        if (Complete() && (fields_.assetUrls.size() == assetNames_.size() || assetsDone_) &&
+            (!fields_.checksumsUrl.empty() || assetsDone_)) {
+            stopped_ = true;
+            return false;
+        }
+        return true;
+    }
+
+    const std::vector<std::string>& assetNames_;
+    ReleaseFields& fields_;
+    size_t bestRank_;
+    std::vector<char> containers_;
+    std::string key_;
+    std::string currentName_;
+    std::string currentUrl_;
+    bool inAssets_ = false;
+    bool assetsDone_ = false;
+    bool stopped_ = false;
+    std::string error_;
+};
+
+} // namespace
+
+bool ExtractReleaseInfo(std::istream& input, const std::vector<std::string>& assetNames, ReleaseFields& fields) {
+    fields = ReleaseFields();
+    ReleaseSaxHandler handler(assetNames, fields);
+    json::sax_parse(input, &handler);
+
+    if (!handler.Error().empty() && !handler.Stopped()) {
+        LogError() << "JSON parsing error: " << handler.Error();
+        return false;
+    }
+
+    if (!handler.Complete()) {
+        LogError() << DescribeAssets(assetNames) << " asset not found in the latest release.";
+        return false;
+    }
+    return true;
+}
+
+bool ExtractReleaseInfoDom(const std::string& body, const std::vector<std::string>& assetNames, ReleaseFields& fields) {
+    fields = ReleaseFields();
+    try {
+        // Parse JSON response
+        json data = json::parse(body);
+
+        // Find the most preferred asset and the checksum listing
+        size_t bestRank = assetNames.size();
+        for (const auto& asset : data["assets"]) {
+            std::string name = asset["name"];
+            size_t rank = AssetRank(assetNames, name);
+            if (rank < assetNames.size()) {
+                fields.assetUrls[name] = asset["browser_download_url"];
+            }
+            if (rank < bestRank) {
+                fields.downloadUrl = asset["browser_download_url"];
+                bestRank = rank;
+            } else if (name == kChecksumsAssetName) {
+                fields.checksumsUrl = asset["browser_download_url"];
+            }
+        }
+
+        if (fields.downloadUrl.empty()) {
+            LogError() << DescribeAssets(assetNames) << " asset not found in the latest release.";
+            return false;
+        }
+
+        fields.tagName = data["tag_name"];
+        return true;
+    } catch (const json::exception& e) {
+        LogError() << "JSON parsing error: " << e.what();
+        return false;
+    }
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <istream>
+#include <map>
+#include <string>
+#include <vector>
+
+// The parts of a GitHub release that the updater uses
+struct ReleaseFields {
+    std::string tagName;
+    std::string downloadUrl;    // browser_download_url of the most preferred asset found
+    std::string checksumsUrl;   // browser_download_url of SHA2-256SUMS, if published
+    std::map<std::string, std::string> assetUrls;   // browser_download_url of every wanted asset found, by name
+};
+
+// Function to extract the release fields from a GitHub release JSON document
+// with a SAX parser. Only the needed strings are kept and parsing stops as soon
+// as they have all been seen (every one of assetNames, or the end of the assets
+// array), so the rest of the document (release notes, uploader objects, ...) is
+// never read. assetNames are the acceptable assets, most preferred first.
+// Returns false if the document is invalid or none of the assets is listed.
+bool ExtractReleaseInfo(std::istream& input, const std::vector<std::string>& assetNames, ReleaseFields& fields);
+
+// Function to extract the same fields by parsing the whole document into a DOM
+bool ExtractReleaseInfoDom(const std::string& body, const std::vector<std::string>& assetNames, ReleaseFields& fields);
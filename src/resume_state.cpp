@@ -0,0 +1,76 @@
+#include "resume_state.h"
+
+#include <filesystem>
+#include <fstream>
+#include <nlohmann/json.hpp>
+#include "logger.h"
+
+using json = nlohmann::json;
+namespace fs = std::filesystem;
+
+curl_off_t ResumeBytesWritten(const ResumeState& state) {
+    curl_off_t total = 0;
+    for (const auto& segment : state.segments) {
+        total += segment.written;
+    }
+    return total;
+}
+
+bool ReadResumeState(const std::string& statePath, ResumeState& state) {
+    if (!fs::exists(statePath)) {
+        return false;
+    }
+
+    std::ifstream file(statePath);
+    if (!file.is_open()) {
+        LogError() << "Failed to open resume state: " << statePath;
+        return false;
+    }
+
+    try {
+        json data = json::parse(file);
+        state.url = data.at("url").get<std::string>();
+        state.validator = data.at("validator").get<std::string>();
+        state.contentLength = data.at("content_length").get<curl_off_t>();
+        state.segments.clear();
+        for (const auto& item : data.at("segments")) {
+            SegmentProgress segment;
+            segment.start = item.at("start").get<curl_off_t>();
+            segment.end = item.at("end").get<curl_off_t>();
+            segment.written = item.at("written").get<curl_off_t>();
+            if (segment.written < 0 || segment.written > segment.end - segment.start + 1) {
+                return false;
+            }
+            state.segments.push_back(segment);
+        }
+    } catch (const json::exception& e) {
+        LogWarning() << "Ignoring invalid resume state: " << e.what();
+        return false;
+    }
+
+    return !state.segments.empty();
+}
+
+bool WriteResumeState(const std::string& statePath, const ResumeState& state) {
+    json segments = json::array();
+    for (const auto& segment : state.segments) {
+        segments.push_back({{"start", segment.start}, {"end", segment.end}, {"written", segment.written}});
+    }
+
+    json data = {
+        {"url", state.url},
+        {"validator", state.validator},
+        {"content_length", state.contentLength},
+        {"segments", segments}
+    };
+
+    std::ofstream file(statePath, std::ios::trunc);
+    if (!file.is_open()) {
+        LogError() << "Failed to create resume state: " << statePath;
+        return false;
+    }
+
+    file << data.dump(2);
+    file.close();
+    return static_cast<bool>(file);
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <curl/curl.h>
+#include <string>
+#include <vector>
+
+// Progress of one byte range of a download; end is inclusive
+struct SegmentProgress {
+    curl_off_t start = 0;
+    curl_off_t end = 0;
+    curl_off_t written = 0;
+};
+
+// Sidecar kept next to a partial .tmp download so an interrupted transfer can
+// continue with a Range request instead of starting over. The partial is only
+// reused while the server still reports the same validator (ETag or
+// Last-Modified) and length for the same URL.
+struct ResumeState {
+    std::string url;
+    std::string validator;
+    curl_off_t contentLength = -1;
+    std::vector<SegmentProgress> segments;
+};
+
+// Function to get the number of bytes already on disk according to the state
+curl_off_t ResumeBytesWritten(const ResumeState& state);
+
+// Function to read a resume sidecar, returns false if it is missing or unusable
+bool ReadResumeState(const std::string& statePath, ResumeState& state);
+
+// Function to write a resume sidecar
+bool WriteResumeState(const std::string& statePath, const ResumeState& state);
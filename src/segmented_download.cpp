@@ -0,0 +1,324 @@
+#include "logger.h"
+#include "segmented_download.h"
+#include "http_headers.h"
+#include "metrics.h"
+#include "transfer_context.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Upper bound on parallel connections; further segments wait for a free one
+const long kMaxSegmentConnections = 8;
+
+// The handle and file position fetching one segment
+struct Segment {
+    SegmentProgress* progress = nullptr;
+    DownloadHasher* hasher = nullptr;
+    CURL* curl = nullptr;
+    FILE* fp = nullptr;
+    std::string range;
+    bool checkedResponse = false;
+    bool done = false;
+    bool held = false;              // paused until the hash catches up
+    curl_off_t heldAt = 0;          // hashed bytes when it was paused
+};
+
+bool SeekTo(FILE* fp, curl_off_t offset) {
+#ifdef _WIN32
+    return _fseeki64(fp, offset, SEEK_SET) == 0;
+#else
+    return fseeko(fp, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+}
+
+// Write callback for a segment; refuses bytes past the end of its range so a
+// server that ignores the Range header cannot overwrite a neighbouring segment.
+// A segment too far ahead of the hash is paused before writing anything; curl
+// delivers the same bytes again once it is resumed.
+size_t SegmentWriteCallback(void* contents, size_t size, size_t nmemb, Segment* segment) {
+    // Only a 206 carries this segment's range; anything else (a server that
+    // ignores Range answers 200 with the file's start) must not reach the file
+    if (!segment->checkedResponse) {
+        long responseCode = 0;
+        curl_easy_getinfo(segment->curl, CURLINFO_RESPONSE_CODE, &responseCode);
+        if (responseCode != 206) {
+            return 0;
+        }
+        segment->checkedResponse = true;
+    }
+
+    SegmentProgress* progress = segment->progress;
+    size_t length = size * nmemb;
+    curl_off_t remaining = progress->end - progress->start + 1 - progress->written;
+    if (static_cast<curl_off_t>(length) > remaining) {
+        return 0;
+    }
+
+    if (segment->hasher && !segment->hasher->Write(progress->start + progress->written, contents, length)) {
+        segment->held = true;
+        segment->heldAt = segment->hasher->HashedBytes();
+        HoldTransfer(segment->curl, PauseReason::Hash);
+        return CURL_WRITEFUNC_PAUSE;
+    }
+
+    size_t result = fwrite(contents, 1, length, segment->fp);
+    progress->written += static_cast<curl_off_t>(result);
+    return result;
+}
+
+void CleanupSegments(CURLM* multi, std::vector<Segment>& transfers, struct curl_slist* headers) {
+    for (auto& segment : transfers) {
+        if (segment.curl) {
+            curl_multi_remove_handle(multi, segment.curl);
+            ReleaseEasyHandle(segment.curl);
+        }
+        if (segment.fp) {
+            fclose(segment.fp);
+        }
+    }
+    curl_multi_cleanup(multi);
+    curl_slist_free_all(headers);
+}
+
+} // namespace
+
+bool ProbeDownload(const std::string& url, DownloadProbe& probe) {
+    CURL* curl = AcquireEasyHandle();
+    if (!curl) {
+        LogError() << "Failed to initialize CURL";
+        return false;
+    }
+
+    HttpHeaders responseHeaders;
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_NOBODY, 1L);
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, HeaderCallback);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, &responseHeaders);
+    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L); // Follow redirects
+    curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 1L); // Verify SSL certificate
+
+    struct curl_slist* headers = NULL;
+    headers = curl_slist_append(headers, "User-Agent: yt-dlp-updater");
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+
+    CURLcode res = curl_easy_perform(curl);
+
+    long responseCode = 0;
+    char* effectiveUrl = nullptr;
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &responseCode);
+    curl_easy_getinfo(curl, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &probe.contentLength);
+    curl_easy_getinfo(curl, CURLINFO_EFFECTIVE_URL, &effectiveUrl);
+    probe.effectiveUrl = effectiveUrl ? effectiveUrl : url;
+    probe.acceptRanges = GetHeader(responseHeaders, "Accept-Ranges") == "bytes";
+    probe.validator = GetHeader(responseHeaders, "ETag");
+    if (probe.validator.empty()) {
+        probe.validator = GetHeader(responseHeaders, "Last-Modified");
+    }
+
+    RecordRequestMetrics(curl, "probe");
+    curl_slist_free_all(headers);
+    ReleaseEasyHandle(curl);
+
+    if (res != CURLE_OK) {
+        LogError() << "Download probe failed: " << curl_easy_strerror(res);
+        return false;
+    }
+
+    if (responseCode != 200) {
+        LogError() << "Download probe failed with response code: " << responseCode;
+        return false;
+    }
+
+    return true;
+}
+
+std::vector<SegmentProgress> SplitIntoSegments(curl_off_t contentLength, int segmentCount) {
+    std::vector<SegmentProgress> segments;
+    if (contentLength <= 0 || segmentCount < 1) {
+        return segments;
+    }
+
+    if (segmentCount > contentLength) {
+        segmentCount = static_cast<int>(contentLength);
+    }
+    curl_off_t segmentSize = contentLength / segmentCount;
+
+    for (int i = 0; i < segmentCount; ++i) {
+        SegmentProgress segment;
+        segment.start = i * segmentSize;
+        segment.end = (i == segmentCount - 1) ? contentLength - 1 : segment.start + segmentSize - 1;
+        segments.push_back(segment);
+    }
+    return segments;
+}
+
+bool DownloadSegmented(const std::string& url, const std::string& filePath, curl_off_t contentLength, std::vector<SegmentProgress>& segments, DownloadHasher* hasher) {
+    if (contentLength <= 0 || segments.empty()) {
+        return false;
+    }
+
+    // Preallocate the file so every segment can write at its own offset. An
+    // existing partial keeps its contents; resizing only fills in the gaps.
+    {
+        std::error_code ec;
+        if (!fs::exists(filePath)) {
+            FILE* fp = fopen(filePath.c_str(), "wb");
+            if (!fp) {
+                LogError() << "Failed to open file for writing: " << filePath;
+                return false;
+            }
+            fclose(fp);
+        }
+        if (fs::file_size(filePath, ec) != static_cast<uintmax_t>(contentLength)) {
+            fs::resize_file(filePath, static_cast<uintmax_t>(contentLength), ec);
+        }
+        if (ec) {
+            LogError() << "Failed to preallocate " << filePath << ": " << ec.message();
+            return false;
+        }
+    }
+
+    CURLM* multi = curl_multi_init();
+    if (!multi) {
+        LogError() << "Failed to initialize CURL multi handle";
+        return false;
+    }
+
+    curl_multi_setopt(multi, CURLMOPT_MAX_TOTAL_CONNECTIONS, kMaxSegmentConnections);
+    ConfigureMultiHandle(multi);
+
+    struct curl_slist* headers = NULL;
+    headers = curl_slist_append(headers, "User-Agent: yt-dlp-updater");
+
+    // Only the unfinished part of each segment is requested
+    std::vector<Segment> transfers;
+    transfers.reserve(segments.size());
+    for (auto& progress : segments) {
+        if (progress.written >= progress.end - progress.start + 1) {
+            continue;
+        }
+        transfers.emplace_back();
+        transfers.back().progress = &progress;
+        transfers.back().hasher = hasher;
+    }
+
+    for (auto& segment : transfers) {
+        SegmentProgress* progress = segment.progress;
+        curl_off_t offset = progress->start + progress->written;
+        segment.range = std::to_string(offset) + "-" + std::to_string(progress->end);
+
+        // Each segment gets its own handle on the file, positioned at its offset
+        segment.fp = fopen(filePath.c_str(), "r+b");
+        if (!segment.fp || !SeekTo(segment.fp, offset)) {
+            LogError() << "Failed to open segment " << segment.range << " of " << filePath;
+            CleanupSegments(multi, transfers, headers);
+            return false;
+        }
+
+        segment.curl = AcquireEasyHandle();
+        if (!segment.curl) {
+            LogError() << "Failed to initialize CURL";
+            CleanupSegments(multi, transfers, headers);
+            return false;
+        }
+
+        curl_easy_setopt(segment.curl, CURLOPT_URL, url.c_str());
+        curl_easy_setopt(segment.curl, CURLOPT_RANGE, segment.range.c_str());
+        curl_easy_setopt(segment.curl, CURLOPT_WRITEFUNCTION, SegmentWriteCallback);
+        curl_easy_setopt(segment.curl, CURLOPT_WRITEDATA, &segment);
+        curl_easy_setopt(segment.curl, CURLOPT_FOLLOWLOCATION, 1L); // Follow redirects
+        curl_easy_setopt(segment.curl, CURLOPT_SSL_VERIFYPEER, 1L); // Verify SSL certificate
+        curl_easy_setopt(segment.curl, CURLOPT_HTTPHEADER, headers);
+        curl_easy_setopt(segment.curl, CURLOPT_PRIVATE, &segment);
+        ApplyFailoverThreshold(segment.curl, static_cast<int>(transfers.size()));
+        curl_multi_add_handle(multi, segment.curl);
+    }
+
+    curl_off_t alreadyWritten = 0;
+    for (const auto& progress : segments) {
+        alreadyWritten += progress.written;
+    }
+    if (alreadyWritten == 0) {
+        LogInfo() << "Downloading in " << transfers.size() << " segments...";
+    } else {
+        LogInfo() << "Resuming " << transfers.size() << " of " << segments.size() << " segments...";
+    }
+
+    // Drive all transfers until they finish. A failed segment doesn't stop the
+    // others, so as much as possible is on disk for the next attempt.
+    bool ok = true;
+    int running = 0;
+    do {
+        CURLMcode mc = curl_multi_perform(multi, &running);
+        if (mc != CURLM_OK) {
+            LogError() << "curl_multi failed: " << curl_multi_strerror(mc);
+            ok = false;
+            break;
+        }
+
+        CURLMsg* msg = nullptr;
+        int queued = 0;
+        while ((msg = curl_multi_info_read(multi, &queued))) {
+            if (msg->msg != CURLMSG_DONE) {
+                continue;
+            }
+
+            Segment* segment = nullptr;
+            long responseCode = 0;
+            curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, &segment);
+            curl_easy_getinfo(msg->easy_handle, CURLINFO_RESPONSE_CODE, &responseCode);
+            RecordRequestMetrics(msg->easy_handle, "segment");
+            segment->done = true;
+
+            if (responseCode > 0 && responseCode != 206) {
+                LogError() << "Segment " << segment->range << " failed with response code: " << responseCode;
+                ok = false;
+            } else if (msg->data.result != CURLE_OK) {
+                LogError() << "Segment " << segment->range << " failed: " << curl_easy_strerror(msg->data.result);
+                ok = false;
+            } else if (segment->progress->written != segment->progress->end - segment->progress->start + 1) {
+                LogError() << "Segment " << segment->range << " is incomplete (" << segment->progress->written << " bytes)";
+                ok = false;
+            }
+        }
+
+        // Segments held back by the hash go on once its prefix has moved. If
+        // every unfinished one is held, the prefix belongs to a segment that
+        // failed: nothing can move it in this attempt, so end it here and let
+        // the next one resume them all from what they wrote.
+        size_t unfinished = 0;
+        size_t held = 0;
+        for (auto& segment : transfers) {
+            if (segment.held && segment.hasher->HashedBytes() > segment.heldAt) {
+                segment.held = false;
+                ReleaseTransfer(segment.curl, PauseReason::Hash);
+            }
+            if (!segment.done) {
+                ++unfinished;
+                held += segment.held ? 1 : 0;
+            }
+        }
+        if (held > 0 && held == unfinished) {
+            LogWarning() << "Segments are waiting for a failed one, ending this attempt.";
+            ok = false;
+            break;
+        }
+
+        if (running) {
+            mc = curl_multi_poll(multi, NULL, 0, TransferPollTimeoutMs(1000), NULL);
+            if (mc != CURLM_OK) {
+                LogError() << "curl_multi failed: " << curl_multi_strerror(mc);
+                ok = false;
+                break;
+            }
+        }
+    } while (running);
+
+    CleanupSegments(multi, transfers, headers);
+    return ok;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "resume_state.h"
+#include "sha256.h"
+
+#include <curl/curl.h>
+#include <string>
+#include <vector>
+
+// What a HEAD request tells us about a download before fetching it
+struct DownloadProbe {
+    std::string effectiveUrl;   // URL after following redirects
+    curl_off_t contentLength = -1;
+    bool acceptRanges = false;
+    std::string validator;      // ETag, or Last-Modified when there is no ETag
+};
+
+// Function to probe a download URL (follows redirects), returns false if the probe itself failed
+bool ProbeDownload(const std::string& url, DownloadProbe& probe);
+
+// Function to split contentLength bytes into at most segmentCount ranges
+std::vector<SegmentProgress> SplitIntoSegments(curl_off_t contentLength, int segmentCount);
+
+// Function to download contentLength bytes of url into filePath, fetching every
+// unfinished segment concurrently with HTTP Range requests on a single curl_multi
+// handle. The file is preallocated and every segment writes directly at its own
+// offset; progress is recorded in segments so a failed run can be resumed. Written
+// bytes are also fed to hasher, if given; a segment that gets too far ahead of it
+// is paused until it catches up, and the attempt ends once every unfinished
+// segment is waiting on one that failed. On failure the partial file is left for
+// the caller to keep or clean up.
+bool DownloadSegmented(const std::string& url, const std::string& filePath, curl_off_t contentLength, std::vector<SegmentProgress>& segments, DownloadHasher* hasher);
@@ -0,0 +1,186 @@
+#include "sha256.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <iterator>
+#include <sstream>
+#include <vector>
+#include "logger.h"
+
+DownloadHasher::DownloadHasher(const std::string& filePath, size_t maxReorderBytes)
+    : filePath_(filePath), maxReorderBytes_(maxReorderBytes), ctx_(EVP_MD_CTX_new()) {
+    Reset();
+}
+
+DownloadHasher::~DownloadHasher() {
+    EVP_MD_CTX_free(ctx_);
+}
+
+bool DownloadHasher::Write(curl_off_t offset, const void* data, size_t length) {
+    if (failed_) {
+        return true;    // Finish fails anyway; holding transfers back would only stall them
+    }
+    Drain();
+
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    curl_off_t end = offset + static_cast<curl_off_t>(length);
+    if (offset <= hashed_) {
+        if (end > hashed_) {
+            size_t skip = static_cast<size_t>(hashed_ - offset);
+            EVP_DigestUpdate(ctx_, bytes + skip, length - skip);
+            hashed_ = end;
+            Drain();
+        }
+        return true;
+    }
+
+    if (bufferedBytes_ + length > maxReorderBytes_) {
+        return false;
+    }
+
+    // A segment's chunks arrive in order, so most continue the chunk before them
+    auto next = buffered_.lower_bound(offset);
+    if (next != buffered_.begin()) {
+        auto previous = std::prev(next);
+        if (previous->first + static_cast<curl_off_t>(previous->second.size()) == offset) {
+            previous->second.insert(previous->second.end(), bytes, bytes + length);
+            bufferedBytes_ += length;
+            return true;
+        }
+    }
+    std::vector<unsigned char>& chunk = buffered_[offset];
+    if (chunk.size() < length) {
+        bufferedBytes_ += length - chunk.size();
+        chunk.assign(bytes, bytes + length);
+    }
+    return true;
+}
+
+void DownloadHasher::HashFromFile(curl_off_t offset, curl_off_t length) {
+    if (length > 0) {
+        fromFile_[offset] = std::max(fromFile_[offset], length);
+    }
+}
+
+void DownloadHasher::Reset() {
+    EVP_DigestInit_ex(ctx_, EVP_sha256(), nullptr);
+    hashed_ = 0;
+    buffered_.clear();
+    bufferedBytes_ = 0;
+    fromFile_.clear();
+    failed_ = false;
+}
+
+// Function to hash buffered chunks and file ranges for as long as they continue the prefix
+void DownloadHasher::Drain() {
+    while (!failed_) {
+        auto chunk = buffered_.begin();
+        if (chunk != buffered_.end() && chunk->first <= hashed_) {
+            curl_off_t end = chunk->first + static_cast<curl_off_t>(chunk->second.size());
+            if (end > hashed_) {
+                size_t skip = static_cast<size_t>(hashed_ - chunk->first);
+                EVP_DigestUpdate(ctx_, chunk->second.data() + skip, chunk->second.size() - skip);
+                hashed_ = end;
+            }
+            bufferedBytes_ -= chunk->second.size();
+            buffered_.erase(chunk);
+            continue;
+        }
+
+        auto range = fromFile_.begin();
+        if (range != fromFile_.end() && range->first <= hashed_) {
+            curl_off_t end = range->first + range->second;
+            fromFile_.erase(range);
+            if (end > hashed_ && !HashFileRange(end)) {
+                failed_ = true;
+            }
+            continue;
+        }
+        return;
+    }
+}
+
+// Function to hash the file from the prefix up to end
+bool DownloadHasher::HashFileRange(curl_off_t end) {
+    FILE* fp = fopen(filePath_.c_str(), "rb");
+    if (!fp) {
+        LogError() << "Failed to open file for hashing: " << filePath_;
+        return false;
+    }
+
+#ifdef _WIN32
+    bool seeked = _fseeki64(fp, hashed_, SEEK_SET) == 0;
+#else
+    bool seeked = fseeko(fp, static_cast<off_t>(hashed_), SEEK_SET) == 0;
+#endif
+    std::vector<unsigned char> buffer(64 * 1024);
+    while (seeked && hashed_ < end) {
+        size_t wanted = static_cast<size_t>(std::min<curl_off_t>(end - hashed_, buffer.size()));
+        size_t read = fread(buffer.data(), 1, wanted, fp);
+        if (read == 0) {
+            break;
+        }
+        EVP_DigestUpdate(ctx_, buffer.data(), read);
+        hashed_ += static_cast<curl_off_t>(read);
+    }
+    fclose(fp);
+    return hashed_ == end;
+}
+
+bool DownloadHasher::Finish(curl_off_t totalLength, std::string& hexDigest) {
+    // Gaps nothing was written into (or a file that was never streamed) are read from the file
+    Drain();
+    while (!failed_ && hashed_ < totalLength) {
+        curl_off_t end = totalLength;
+        if (!buffered_.empty()) {
+            end = std::min(end, buffered_.begin()->first);
+        }
+        if (!fromFile_.empty()) {
+            end = std::min(end, fromFile_.begin()->first);
+        }
+        failed_ = !HashFileRange(end);
+        Drain();
+    }
+    if (failed_) {
+        LogError() << "Failed to read " << filePath_ << " for hashing";
+        return false;
+    }
+
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int digestLength = 0;
+    EVP_DigestFinal_ex(ctx_, digest, &digestLength);
+
+    static const char* hexChars = "0123456789abcdef";
+    hexDigest.clear();
+    for (unsigned int i = 0; i < digestLength; ++i) {
+        hexDigest += hexChars[digest[i] >> 4];
+        hexDigest += hexChars[digest[i] & 0x0f];
+    }
+    return true;
+}
+
+std::string FindChecksum(const std::string& checksums, const std::string& fileName) {
+    std::istringstream stream(checksums);
+    std::string line;
+    while (std::getline(stream, line)) {
+        std::istringstream fields(line);
+        std::string digest;
+        std::string name;
+        if (!(fields >> digest >> name)) {
+            continue;
+        }
+
+        // Binary-mode listings mark the name with a leading '*'
+        if (!name.empty() && name[0] == '*') {
+            name.erase(0, 1);
+        }
+
+        if (name == fileName && digest.size() == 64) {
+            std::transform(digest.begin(), digest.end(), digest.begin(),
+                           [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+            return digest;
+        }
+    }
+    return "";
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <curl/curl.h>
+#include <openssl/evp.h>
+#include <map>
+#include <string>
+#include <vector>
+
+// Default cap on the out-of-order bytes a DownloadHasher holds in memory
+const size_t kDefaultReorderBytes = 32 * 1024 * 1024;
+
+// Incremental SHA-256 of a file as it is being downloaded. The write path feeds
+// every chunk with its file offset; chunks that continue the hashed prefix are
+// hashed immediately. Chunks ahead of the prefix (other segments of a parallel
+// download) wait in a bounded reorder buffer until the prefix reaches them, so
+// a download is verified without reading it back. Only bytes a partial from an
+// earlier run already had are read from the file.
+class DownloadHasher {
+public:
+    explicit DownloadHasher(const std::string& filePath, size_t maxReorderBytes = kDefaultReorderBytes);
+    ~DownloadHasher();
+
+    DownloadHasher(const DownloadHasher&) = delete;
+    DownloadHasher& operator=(const DownloadHasher&) = delete;
+
+    // Called from the write path with the file offset of the chunk. Returns
+    // false, taking nothing, if the chunk is ahead of the prefix and the reorder
+    // buffer is full; its transfer should wait until HashedBytes() has grown.
+    bool Write(curl_off_t offset, const void* data, size_t length);
+
+    // Bytes [offset, offset + length) are in the file from an earlier run and
+    // won't be written again; they are read from it when the prefix gets there
+    void HashFromFile(curl_off_t offset, curl_off_t length);
+
+    // Forget everything hashed so far (the file is being started over)
+    void Reset();
+
+    // Hash whatever is still missing up to totalLength and return the hex
+    // digest. Bytes that never came through Write are read from the file.
+    bool Finish(curl_off_t totalLength, std::string& hexDigest);
+
+    curl_off_t HashedBytes() const { return hashed_; }
+
+private:
+    void Drain();
+    bool HashFileRange(curl_off_t end);
+
+    std::string filePath_;
+    size_t maxReorderBytes_;
+    EVP_MD_CTX* ctx_ = nullptr;
+    curl_off_t hashed_ = 0;
+    std::map<curl_off_t, std::vector<unsigned char>> buffered_;  // chunks ahead of the prefix by offset
+    size_t bufferedBytes_ = 0;
+    std::map<curl_off_t, curl_off_t> fromFile_;                 // offset -> length of ranges to read from the file
+    bool failed_ = false;                                       // the file couldn't be read
+};
+
+// Function to find the checksum of fileName in a SHA2-256SUMS style listing
+// ("<hex digest>  <file name>" per line), returns "" if it is not listed
+std::string FindChecksum(const std::string& checksums, const std::string& fileName);
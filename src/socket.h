@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Minimal blocking TCP server sockets for the LAN mirror. Exactly one backend
+// is compiled in (socket_win.cpp or socket_posix.cpp).
+
+using SocketHandle = intptr_t;
+const SocketHandle kInvalidSocket = -1;
+
+// Function to initialize the socket library (Winsock), once per process
+bool StartSockets();
+
+// Function to open a listening TCP socket on address:port
+SocketHandle ListenTcp(const std::string& address, int port);
+
+// Function to get the port a socket is bound to (useful after listening on port 0), -1 on error
+int LocalPort(SocketHandle socket);
+
+// Function to wait for the next connection, kInvalidSocket once the listener was shut down
+SocketHandle AcceptConnection(SocketHandle listener);
+
+// Function to make receives on a connection give up after idleSeconds without data
+void SetReceiveTimeout(SocketHandle socket, int idleSeconds);
+
+// Function to receive up to length bytes, returns 0 on close and -1 on error or timeout
+long ReceiveSome(SocketHandle socket, char* buffer, size_t length);
+
+// Function to send the whole buffer
+bool SendAll(SocketHandle socket, const char* data, size_t length);
+
+// Function to send length bytes of a file starting at offset, zero-copy where
+// the OS supports it (sendfile, TransmitFile)
+bool SendFileRange(SocketHandle socket, const std::string& filePath, uint64_t offset, uint64_t length);
+
+// Function to stop all traffic on a socket, waking up a thread blocked on it
+void ShutdownSocket(SocketHandle socket);
+
+// Function to close a socket
+void CloseSocket(SocketHandle socket);
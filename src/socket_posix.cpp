@@ -0,0 +1,147 @@
+#include "socket.h"
+
+#include <csignal>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
+#include "logger.h"
+
+bool StartSockets() {
+    // Writing to a connection the client already closed must fail, not kill the process
+    signal(SIGPIPE, SIG_IGN);
+    return true;
+}
+
+SocketHandle ListenTcp(const std::string& address, int port) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        LogError() << "Failed to create socket: " << strerror(errno);
+        return kInvalidSocket;
+    }
+
+    int reuse = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    if (inet_pton(AF_INET, address.c_str(), &addr.sin_addr) != 1) {
+        LogError() << "Invalid listen address: " << address;
+        close(fd);
+        return kInvalidSocket;
+    }
+
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(fd, SOMAXCONN) != 0) {
+        LogError() << "Failed to listen on " << address << ":" << port << ": " << strerror(errno);
+        close(fd);
+        return kInvalidSocket;
+    }
+    return fd;
+}
+
+int LocalPort(SocketHandle socket) {
+    sockaddr_in addr = {};
+    socklen_t length = sizeof(addr);
+    if (getsockname(static_cast<int>(socket), reinterpret_cast<sockaddr*>(&addr), &length) != 0) {
+        return -1;
+    }
+    return ntohs(addr.sin_port);
+}
+
+SocketHandle AcceptConnection(SocketHandle listener) {
+    while (true) {
+        int fd = accept4(static_cast<int>(listener), nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd >= 0) {
+            int noDelay = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+            return fd;
+        }
+        if (errno != EINTR && errno != ECONNABORTED) {
+            return kInvalidSocket;
+        }
+    }
+}
+
+void SetReceiveTimeout(SocketHandle socket, int idleSeconds) {
+    timeval timeout = {};
+    timeout.tv_sec = idleSeconds;
+    setsockopt(static_cast<int>(socket), SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+}
+
+long ReceiveSome(SocketHandle socket, char* buffer, size_t length) {
+    while (true) {
+        ssize_t received = recv(static_cast<int>(socket), buffer, length, 0);
+        if (received >= 0 || errno != EINTR) {
+            return static_cast<long>(received);
+        }
+    }
+}
+
+bool SendAll(SocketHandle socket, const char* data, size_t length) {
+    while (length > 0) {
+        ssize_t sent = send(static_cast<int>(socket), data, length, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += sent;
+        length -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+bool SendFileRange(SocketHandle socket, const std::string& filePath, uint64_t offset, uint64_t length) {
+    int fd = open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    bool ok = true;
+#ifdef __linux__
+    // The kernel copies straight from the page cache into the socket
+    off_t position = static_cast<off_t>(offset);
+    while (length > 0 && ok) {
+        ssize_t sent = sendfile(static_cast<int>(socket), fd, &position, length);
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        ok = sent > 0;
+        if (ok) {
+            length -= static_cast<uint64_t>(sent);
+        }
+    }
+#else
+    char buffer[64 * 1024];
+    while (length > 0 && ok) {
+        size_t chunk = length < sizeof(buffer) ? static_cast<size_t>(length) : sizeof(buffer);
+        ssize_t got = pread(fd, buffer, chunk, static_cast<off_t>(offset));
+        ok = got > 0 && SendAll(socket, buffer, static_cast<size_t>(got));
+        if (ok) {
+            offset += static_cast<uint64_t>(got);
+            length -= static_cast<uint64_t>(got);
+        }
+    }
+#endif
+
+    close(fd);
+    return ok;
+}
+
+void ShutdownSocket(SocketHandle socket) {
+    shutdown(static_cast<int>(socket), SHUT_RDWR);
+}
+
+void CloseSocket(SocketHandle socket) {
+    close(static_cast<int>(socket));
+}
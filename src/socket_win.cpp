@@ -0,0 +1,133 @@
+#include "socket.h"
+
+// winsock2.h has to come before windows.h
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <mswsock.h>
+#include <windows.h>
+
+#include "logger.h"
+
+namespace {
+
+// Function to convert a UTF-8 path to the wide form the W APIs expect
+std::wstring ToWide(const std::string& value) {
+    int length = MultiByteToWideChar(CP_UTF8, 0, value.c_str(), -1, NULL, 0);
+    if (length <= 0) {
+        return L"";
+    }
+    std::wstring wide(length, L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, value.c_str(), -1, &wide[0], length);
+    wide.resize(length - 1);
+    return wide;
+}
+
+// Largest chunk TransmitFile accepts in one call
+const DWORD kMaxTransmitChunk = 1u << 30;
+
+} // namespace
+
+bool StartSockets() {
+    WSADATA data;
+    int result = WSAStartup(MAKEWORD(2, 2), &data);
+    if (result != 0) {
+        LogError() << "WSAStartup failed with error: " << result;
+        return false;
+    }
+    return true;
+}
+
+SocketHandle ListenTcp(const std::string& address, int port) {
+    SOCKET listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (listener == INVALID_SOCKET) {
+        LogError() << "Failed to create socket: " << WSAGetLastError();
+        return kInvalidSocket;
+    }
+
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<u_short>(port));
+    if (inet_pton(AF_INET, address.c_str(), &addr.sin_addr) != 1) {
+        LogError() << "Invalid listen address: " << address;
+        closesocket(listener);
+        return kInvalidSocket;
+    }
+
+    if (bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == SOCKET_ERROR ||
+        listen(listener, SOMAXCONN) == SOCKET_ERROR) {
+        LogError() << "Failed to listen on " << address << ":" << port << ": " << WSAGetLastError();
+        closesocket(listener);
+        return kInvalidSocket;
+    }
+    return static_cast<SocketHandle>(listener);
+}
+
+int LocalPort(SocketHandle socket) {
+    sockaddr_in addr = {};
+    int length = sizeof(addr);
+    if (getsockname(static_cast<SOCKET>(socket), reinterpret_cast<sockaddr*>(&addr), &length) == SOCKET_ERROR) {
+        return -1;
+    }
+    return ntohs(addr.sin_port);
+}
+
+SocketHandle AcceptConnection(SocketHandle listener) {
+    SOCKET connection = accept(static_cast<SOCKET>(listener), NULL, NULL);
+    if (connection == INVALID_SOCKET) {
+        return kInvalidSocket;
+    }
+    BOOL noDelay = TRUE;
+    setsockopt(connection, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&noDelay), sizeof(noDelay));
+    return static_cast<SocketHandle>(connection);
+}
+
+void SetReceiveTimeout(SocketHandle socket, int idleSeconds) {
+    DWORD timeout = static_cast<DWORD>(idleSeconds) * 1000;
+    setsockopt(static_cast<SOCKET>(socket), SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&timeout), sizeof(timeout));
+}
+
+long ReceiveSome(SocketHandle socket, char* buffer, size_t length) {
+    int received = recv(static_cast<SOCKET>(socket), buffer, static_cast<int>(length), 0);
+    return received == SOCKET_ERROR ? -1 : received;
+}
+
+bool SendAll(SocketHandle socket, const char* data, size_t length) {
+    while (length > 0) {
+        int sent = send(static_cast<SOCKET>(socket), data, static_cast<int>(length), 0);
+        if (sent == SOCKET_ERROR) {
+            return false;
+        }
+        data += sent;
+        length -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+bool SendFileRange(SocketHandle socket, const std::string& filePath, uint64_t offset, uint64_t length) {
+    HANDLE file = CreateFileW(ToWide(filePath).c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL,
+                              OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    // Without an OVERLAPPED, TransmitFile sends from the current file position
+    LARGE_INTEGER position;
+    position.QuadPart = static_cast<LONGLONG>(offset);
+    bool ok = SetFilePointerEx(file, position, NULL, FILE_BEGIN) != 0;
+    while (ok && length > 0) {
+        DWORD chunk = length < kMaxTransmitChunk ? static_cast<DWORD>(length) : kMaxTransmitChunk;
+        ok = TransmitFile(static_cast<SOCKET>(socket), file, chunk, 0, NULL, NULL, 0) != FALSE;
+        length -= chunk;
+    }
+
+    CloseHandle(file);
+    return ok;
+}
+
+void ShutdownSocket(SocketHandle socket) {
+    shutdown(static_cast<SOCKET>(socket), SD_BOTH);
+}
+
+void CloseSocket(SocketHandle socket) {
+    closesocket(static_cast<SOCKET>(socket));
+}
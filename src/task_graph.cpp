@@ -0,0 +1,103 @@
+#include "task_graph.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include "metrics.h"
+
+TaskGraph::TaskId TaskGraph::Add(const std::string& name, std::function<bool()> step, const std::vector<TaskId>& dependencies) {
+    TaskId id = tasks_.size();
+    Task task;
+    task.name = name;
+    task.step = std::move(step);
+    for (TaskId dependency : dependencies) {
+        if (dependency < id) {
+            tasks_[dependency].dependents.push_back(id);
+            ++task.pending;
+        }
+    }
+    tasks_.push_back(std::move(task));
+    return id;
+}
+
+bool TaskGraph::Run(size_t workers) {
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<TaskId> ready;
+    size_t finished = 0;
+
+    // Function to settle a task that won't run and, in turn, everything waiting
+    // on it; called with the mutex held
+    std::function<void(TaskId, State)> settle = [&](TaskId id, State state) {
+        tasks_[id].state = state;
+        ++finished;
+        for (TaskId dependent : tasks_[id].dependents) {
+            Task& task = tasks_[dependent];
+            task.blocked = task.blocked || state != State::Succeeded;
+            if (--task.pending == 0) {
+                if (task.blocked) {
+                    settle(dependent, State::Skipped);
+                } else {
+                    task.state = State::Ready;
+                    ready.push_back(dependent);
+                }
+            }
+        }
+    };
+
+    for (TaskId id = 0; id < tasks_.size(); ++id) {
+        if (tasks_[id].pending == 0) {
+            tasks_[id].state = State::Ready;
+            ready.push_back(id);
+        }
+    }
+
+    auto worker = [&]() {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            changed.wait(lock, [&] { return !ready.empty() || finished == tasks_.size(); });
+            if (ready.empty()) {
+                return;
+            }
+            TaskId id = ready.front();
+            ready.pop_front();
+            Task& task = tasks_[id];
+            task.state = State::Running;
+
+            lock.unlock();
+            auto start = std::chrono::steady_clock::now();
+            bool ok = task.step();
+            RecordPhase("task_" + task.name, "", std::chrono::steady_clock::now() - start);
+            lock.lock();
+
+            settle(id, ok ? State::Succeeded : State::Failed);
+            changed.notify_all();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < workers && i < tasks_.size(); ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    for (const auto& task : tasks_) {
+        if (task.state != State::Succeeded) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool TaskGraph::Succeeded(TaskId task) const {
+    return task < tasks_.size() && tasks_[task].state == State::Succeeded;
+}
+
+bool TaskGraph::Skipped(TaskId task) const {
+    return task < tasks_.size() && tasks_[task].state == State::Skipped;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+// A small dependency graph of steps, run on a few threads: every task starts as
+// soon as all tasks it depends on have succeeded, so independent stages (the
+// release request, a prompt, local file checks) overlap. A task whose
+// dependency failed or was skipped is skipped as well. Dependencies are tasks
+// added earlier, so the graph can't have cycles.
+//
+//   TaskGraph graph;
+//   TaskGraph::TaskId release = graph.Add("release", [&]() { return Fetch(); });
+//   graph.Add("install", [&]() { return Install(); }, {release});
+//   graph.Run(4);
+class TaskGraph {
+public:
+    using TaskId = size_t;
+
+    // Function to add a task. Its run time is recorded as the phase "task_<name>"
+    // in the run metrics.
+    TaskId Add(const std::string& name, std::function<bool()> step, const std::vector<TaskId>& dependencies = {});
+
+    // Function to run every task on at most workers threads, the calling
+    // thread being one of them. Returns whether all tasks succeeded.
+    bool Run(size_t workers);
+
+    // Function to check whether a task ran and succeeded
+    bool Succeeded(TaskId task) const;
+
+    // Function to check whether a task was skipped because a dependency failed
+    bool Skipped(TaskId task) const;
+
+private:
+    enum class State { Waiting, Ready, Running, Succeeded, Failed, Skipped };
+
+    struct Task {
+        std::string name;
+        std::function<bool()> step;
+        std::vector<TaskId> dependents;
+        size_t pending = 0;             // dependencies that haven't finished
+        bool blocked = false;           // one of them didn't succeed
+        State state = State::Waiting;
+    };
+
+    std::vector<Task> tasks_;
+};
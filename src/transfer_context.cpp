@@ -0,0 +1,411 @@
+#include "transfer_context.h"
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <vector>
+#include "logger.h"
+#include "platform.h"
+
+namespace {
+
+// Idle easy handles kept around for reuse
+const size_t kMaxPooledHandles = 8;
+
+// How far downloads may run ahead of the rate limit; also sizes the socket
+// receive buffer, which caps how much data can queue up ahead of other traffic
+const std::chrono::milliseconds kBurstWindow(250);
+const curl_off_t kMinBurstBytes = 64 * 1024;
+const curl_off_t kMaxReceiveBufferBytes = 4 * 1024 * 1024;
+
+// How often the idle policy looks at the network counters and the process list
+const std::chrono::seconds kIdleCheckInterval(1);
+
+// Longest poll of a transfer loop while QoS holds a transfer paused, so it
+// resumes about when its tokens are in
+const int kHeldPollMs = 20;
+
+// Video players fetch in bursts a few seconds apart, so the network has to stay
+// quiet this long before paused downloads resume
+const std::chrono::seconds kIdleQuietPeriod(10);
+
+// How long a download may stay below the failover threshold
+const std::chrono::seconds kFailoverPeriod(10);
+
+// TCP/IP and TLS framing on top of the body bytes curl counts, so our own
+// downloads don't show up as other traffic
+const double kWireOverhead = 1.06;
+
+TransferOptions g_options;
+CURLSH* g_share = nullptr;
+std::mutex g_shareLocks[CURL_LOCK_DATA_LAST];
+std::mutex g_poolMutex;
+std::vector<CURL*> g_pool;
+TransferStats g_stats;
+long long g_throttledUs = 0;
+long long g_pausedUs = 0;
+
+// A transfer QoS has paused (curl_easy_pause) until it may receive again
+struct HeldTransfer {
+    std::chrono::steady_clock::time_point since;
+    std::chrono::steady_clock::time_point tokensDue;    // when the rate limit lets it go on
+};
+
+// QoS state shared by every transfer, so parallel segments stay under the limit together
+std::mutex g_qosMutex;
+std::map<CURL*, curl_off_t> g_charged;      // body bytes each handle has been charged for
+std::map<CURL*, HeldTransfer> g_held;       // transfers paused by QoS
+
+// Reasons (PauseReason bits) each paused transfer is held for
+std::mutex g_pauseMutex;
+std::map<CURL*, unsigned> g_pauseHolds;
+double g_tokens = 0;                        // bytes that may arrive now, negative while in debt
+std::chrono::steady_clock::time_point g_refilled;
+uint64_t g_ownBytes = 0;                    // body bytes received by all transfers
+
+// What the idle policy saw at its last check
+std::chrono::steady_clock::time_point g_idleChecked;
+bool g_trafficSeen = false;
+std::chrono::steady_clock::time_point g_lastTraffic;
+bool g_haveCounters = false;
+bool g_countersMissing = false;
+uint64_t g_systemBytes = 0;                 // interface counters then
+uint64_t g_ownBytesChecked = 0;             // g_ownBytes then
+bool g_busy = false;
+
+void LockShare(CURL*, curl_lock_data data, curl_lock_access, void*) {
+    g_shareLocks[data].lock();
+}
+
+void UnlockShare(CURL*, curl_lock_data data, void*) {
+    g_shareLocks[data].unlock();
+}
+
+bool PacingEnabled() {
+    return g_options.maxRecvBytesPerSecond > 0 || g_options.idleOnly || !g_options.pauseWhile.empty();
+}
+
+double BurstBytes() {
+    double burst = static_cast<double>(g_options.maxRecvBytesPerSecond) * kBurstWindow.count() / 1000.0;
+    return burst < kMinBurstBytes ? kMinBurstBytes : burst;
+}
+
+// Function to take bytes out of the token bucket, returns how long the caller
+// has to wait for them. Called with g_qosMutex held.
+std::chrono::microseconds TakeTokens(curl_off_t bytes) {
+    double rate = static_cast<double>(g_options.maxRecvBytesPerSecond);
+    auto now = std::chrono::steady_clock::now();
+    g_tokens += rate * std::chrono::duration<double>(now - g_refilled).count();
+    g_refilled = now;
+    if (g_tokens > BurstBytes()) {
+        g_tokens = BurstBytes();
+    }
+
+    g_tokens -= static_cast<double>(bytes);
+    if (g_tokens >= 0) {
+        return std::chrono::microseconds(0);
+    }
+    return std::chrono::microseconds(static_cast<long long>(-g_tokens / rate * 1e6));
+}
+
+// Function to decide whether downloads should pause for a listed process or
+// other traffic. Looks at most once per kIdleCheckInterval; after traffic it
+// stays busy until the network has been quiet for kIdleQuietPeriod. Called with
+// g_qosMutex held.
+bool NetworkInUse() {
+    auto now = std::chrono::steady_clock::now();
+    if (now - g_idleChecked < kIdleCheckInterval) {
+        return g_busy;
+    }
+    double elapsed = std::chrono::duration<double>(now - g_idleChecked).count();
+    g_idleChecked = now;
+
+    std::string process;
+    bool processRunning = !g_options.pauseWhile.empty() && FindRunningProcess(g_options.pauseWhile, process);
+
+    uint64_t systemBytes = 0;
+    if (g_options.idleOnly && !g_countersMissing) {
+        if (!ReadReceivedBytes(systemBytes)) {
+            LogWarning() << "Can't read the network counters here; --idle-only only pauses for --pause-while processes";
+            g_countersMissing = true;
+        } else {
+            // Whatever arrived that wasn't ours (counters restart when an interface goes down)
+            if (g_haveCounters && systemBytes >= g_systemBytes) {
+                double own = static_cast<double>(g_ownBytes - g_ownBytesChecked) * kWireOverhead;
+                double other = static_cast<double>(systemBytes - g_systemBytes) - own;
+                if (other / elapsed > static_cast<double>(g_options.idleThresholdBytesPerSecond)) {
+                    g_trafficSeen = true;
+                    g_lastTraffic = now;
+                }
+            }
+            g_haveCounters = true;
+            g_systemBytes = systemBytes;
+            g_ownBytesChecked = g_ownBytes;
+        }
+    }
+
+    bool busy = processRunning || (g_trafficSeen && now - g_lastTraffic < kIdleQuietPeriod);
+    if (busy && !g_busy) {
+        LogInfo() << "Pausing downloads: " << (processRunning ? process + " is running" : "other programs are using the network");
+        std::lock_guard<std::mutex> lock(g_poolMutex);
+        ++g_stats.pauses;
+    } else if (!busy && g_busy) {
+        LogInfo() << "Resuming downloads";
+    }
+    g_busy = busy;
+    return busy;
+}
+
+bool IdlePolicyEnabled() {
+    return g_options.idleOnly || !g_options.pauseWhile.empty();
+}
+
+// Progress callback of every transfer while QoS is on: charges what arrived to
+// the shared token bucket and pauses receiving (curl_easy_pause) while the
+// bucket is in debt or the network is in use. It never blocks, so the other
+// transfers of a multi handle keep going. curl keeps calling it while the
+// transfer is paused, from the loop driving the transfer (see
+// TransferPollTimeoutMs), and it resumes the transfer from there once it may
+// go on. curl doesn't read the socket meanwhile, so TCP flow control slows the
+// sender down as well.
+int PaceTransfer(void* clientp, curl_off_t, curl_off_t dlnow, curl_off_t, curl_off_t) {
+    CURL* curl = static_cast<CURL*>(clientp);
+    auto now = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> lock(g_qosMutex);
+
+    auto held = g_held.find(curl);
+    if (held != g_held.end()) {
+        if (now < held->second.tokensDue || (IdlePolicyEnabled() && NetworkInUse())) {
+            lock.unlock();
+            return WaitForShutdown(std::chrono::milliseconds(0)) ? 1 : 0;   // 1 fails it with CURLE_ABORTED_BY_CALLBACK
+        }
+        auto throttled = std::max(held->second.tokensDue, held->second.since) - held->second.since;
+        auto paused = now - held->second.since - throttled;
+        g_held.erase(held);
+        lock.unlock();
+        {
+            std::lock_guard<std::mutex> statsLock(g_poolMutex);
+            g_throttledUs += std::chrono::duration_cast<std::chrono::microseconds>(throttled).count();
+            g_pausedUs += std::chrono::duration_cast<std::chrono::microseconds>(paused).count();
+        }
+        ReleaseTransfer(curl, PauseReason::Qos);
+        return 0;
+    }
+
+    curl_off_t& charged = g_charged[curl];
+    if (dlnow < charged) {
+        charged = 0;    // the handle started another request
+    }
+    curl_off_t bytes = dlnow - charged;
+    charged = dlnow;
+    g_ownBytes += static_cast<uint64_t>(bytes);
+    std::chrono::microseconds wait(0);
+    if (g_options.maxRecvBytesPerSecond > 0 && bytes > 0) {
+        wait = TakeTokens(bytes);
+    }
+    if (wait.count() > 0 || (IdlePolicyEnabled() && NetworkInUse())) {
+        HeldTransfer hold;
+        hold.since = now;
+        hold.tokensDue = now + wait;
+        g_held[curl] = hold;
+        lock.unlock();
+        HoldTransfer(curl, PauseReason::Qos);
+        curl_easy_pause(curl, CURLPAUSE_RECV);
+    }
+    return 0;
+}
+
+// Socket callback while a rate limit is set: a receive buffer sized to the rate
+// keeps the TCP window small, so the sender can't queue a large burst at the
+// bottleneck link ahead of a live stream's packets
+int LimitReceiveBuffer(void*, curl_socket_t socket, curlsocktype purpose) {
+    if (purpose == CURLSOCKTYPE_IPCXN) {
+        int size = static_cast<int>(std::clamp(static_cast<curl_off_t>(BurstBytes()), kMinBurstBytes, kMaxReceiveBufferBytes));
+        setsockopt(socket, SOL_SOCKET, SO_RCVBUF, reinterpret_cast<const char*>(&size), sizeof(size));
+    }
+    return CURL_SOCKOPT_OK;
+}
+
+// Options every request gets; the caller sets the per-request ones on top
+void ApplyContextOptions(CURL* curl) {
+    if (g_share) {
+        curl_easy_setopt(curl, CURLOPT_SHARE, g_share);
+    }
+    if (g_options.keepAlive) {
+        curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+    }
+    if (g_options.multiplex) {
+        curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, (long)CURL_HTTP_VERSION_2TLS);
+        curl_easy_setopt(curl, CURLOPT_PIPEWAIT, 1L);
+    }
+    if (!g_options.caInfo.empty()) {
+        curl_easy_setopt(curl, CURLOPT_CAINFO, g_options.caInfo.c_str());
+    }
+    if (PacingEnabled()) {
+        curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+        curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, PaceTransfer);
+        curl_easy_setopt(curl, CURLOPT_XFERINFODATA, curl);
+    }
+    if (g_options.maxRecvBytesPerSecond > 0) {
+        // curl's own limit smooths each connection; the shared bucket caps them together
+        curl_easy_setopt(curl, CURLOPT_MAX_RECV_SPEED_LARGE, g_options.maxRecvBytesPerSecond);
+        curl_easy_setopt(curl, CURLOPT_SOCKOPTFUNCTION, LimitReceiveBuffer);
+    }
+}
+
+} // namespace
+
+bool InitTransfers(const TransferOptions& options) {
+    CURLcode res = curl_global_init(CURL_GLOBAL_ALL);
+    if (res != CURLE_OK) {
+        LogError() << "curl_global_init() failed: " << curl_easy_strerror(res);
+        return false;
+    }
+
+    g_options = options;
+    g_tokens = BurstBytes();
+    g_refilled = std::chrono::steady_clock::now();
+    g_share = curl_share_init();
+    if (!g_share) {
+        LogWarning() << "Failed to create shared CURL context; connections will not be reused";
+        return true;
+    }
+
+    curl_share_setopt(g_share, CURLSHOPT_LOCKFUNC, LockShare);
+    curl_share_setopt(g_share, CURLSHOPT_UNLOCKFUNC, UnlockShare);
+    curl_share_setopt(g_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(g_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    curl_share_setopt(g_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+    return true;
+}
+
+void CleanupTransfers() {
+    {
+        std::lock_guard<std::mutex> lock(g_poolMutex);
+        for (CURL* curl : g_pool) {
+            curl_easy_cleanup(curl);
+        }
+        g_pool.clear();
+    }
+
+    // All handles using the share must be gone before it can be cleaned up
+    if (g_share) {
+        curl_share_cleanup(g_share);
+        g_share = nullptr;
+    }
+    curl_global_cleanup();
+}
+
+CURL* AcquireEasyHandle() {
+    CURL* curl = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(g_poolMutex);
+        if (!g_pool.empty()) {
+            curl = g_pool.back();
+            g_pool.pop_back();
+            ++g_stats.handlesReused;
+        }
+    }
+
+    if (!curl) {
+        curl = curl_easy_init();
+        if (!curl) {
+            return nullptr;
+        }
+        std::lock_guard<std::mutex> lock(g_poolMutex);
+        ++g_stats.handlesCreated;
+    }
+
+    ApplyContextOptions(curl);
+    return curl;
+}
+
+void ReleaseEasyHandle(CURL* curl) {
+    if (!curl) {
+        return;
+    }
+
+    // Only handles that got a response say anything about connection reuse
+    long responseCode = 0;
+    long connects = 0;
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &responseCode);
+    curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &connects);
+
+    // Reset drops the per-request options but keeps the handle's caches
+    curl_easy_reset(curl);
+    if (PacingEnabled()) {
+        std::lock_guard<std::mutex> lock(g_qosMutex);
+        g_charged.erase(curl);
+        g_held.erase(curl);
+    }
+    {
+        std::lock_guard<std::mutex> lock(g_pauseMutex);
+        g_pauseHolds.erase(curl);
+    }
+
+    std::lock_guard<std::mutex> lock(g_poolMutex);
+    if (responseCode > 0) {
+        g_stats.newConnections += connects;
+        if (connects == 0) {
+            ++g_stats.reusedConnections;
+        }
+    }
+
+    if (g_pool.size() < kMaxPooledHandles) {
+        g_pool.push_back(curl);
+    } else {
+        curl_easy_cleanup(curl);
+    }
+}
+
+void ApplyFailoverThreshold(CURL* curl, int connections) {
+    if (g_options.failoverBytesPerSecond > 0 && !PacingEnabled()) {
+        curl_off_t perConnection = std::max<curl_off_t>(g_options.failoverBytesPerSecond / std::max(connections, 1), 1);
+        curl_easy_setopt(curl, CURLOPT_LOW_SPEED_LIMIT, static_cast<long>(perConnection));
+        curl_easy_setopt(curl, CURLOPT_LOW_SPEED_TIME, static_cast<long>(kFailoverPeriod.count()));
+    }
+}
+
+void HoldTransfer(CURL* curl, PauseReason reason) {
+    std::lock_guard<std::mutex> lock(g_pauseMutex);
+    g_pauseHolds[curl] |= static_cast<unsigned>(reason);
+}
+
+void ReleaseTransfer(CURL* curl, PauseReason reason) {
+    {
+        std::lock_guard<std::mutex> lock(g_pauseMutex);
+        auto holds = g_pauseHolds.find(curl);
+        if (holds == g_pauseHolds.end() || !(holds->second & static_cast<unsigned>(reason))) {
+            return;
+        }
+        holds->second &= ~static_cast<unsigned>(reason);
+        if (holds->second != 0) {
+            return;
+        }
+        g_pauseHolds.erase(holds);
+    }
+    // Not under the lock: resuming delivers held data, and a write callback may hold it again
+    curl_easy_pause(curl, CURLPAUSE_CONT);
+}
+
+int TransferPollTimeoutMs(int timeoutMs) {
+    if (!PacingEnabled()) {
+        return timeoutMs;
+    }
+    std::lock_guard<std::mutex> lock(g_qosMutex);
+    return g_held.empty() ? timeoutMs : std::min(timeoutMs, kHeldPollMs);
+}
+
+void ConfigureMultiHandle(CURLM* multi) {
+    // Without multiplexing, parallel transfers each get their own connection
+    curl_multi_setopt(multi, CURLMOPT_PIPELINING, g_options.multiplex ? CURLPIPE_MULTIPLEX : CURLPIPE_NOTHING);
+}
+
+TransferStats GetTransferStats() {
+    std::lock_guard<std::mutex> lock(g_poolMutex);
+    TransferStats stats = g_stats;
+    stats.throttledMs = g_throttledUs / 1000;
+    stats.pausedMs = g_pausedUs / 1000;
+    return stats;
+}
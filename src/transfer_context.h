@@ -0,0 +1,79 @@
+#pragma once
+
+#include <curl/curl.h>
+#include <string>
+#include <vector>
+
+// Process-wide transfer settings
+struct TransferOptions {
+    bool multiplex = false;     // negotiate HTTP/2 and multiplex concurrent requests to a host over one connection
+    bool keepAlive = true;      // TCP keep-alive probes on idle pooled connections
+    std::string caInfo;         // extra CA bundle, e.g. for a mirror with a private certificate
+
+    // Background QoS, so an update doesn't compete with a live video stream
+    curl_off_t maxRecvBytesPerSecond = 0;       // cap for all downloads together, 0 for none
+    bool idleOnly = false;                      // pause while other programs use the network
+    curl_off_t idleThresholdBytesPerSecond = 128 * 1024; // other traffic above this counts as in use
+    std::vector<std::string> pauseWhile;        // pause while one of these processes runs
+
+    // A download slower than this for a while is given up for the next source
+    // (see asset_mirrors.h), 0 to never give up
+    curl_off_t failoverBytesPerSecond = 0;
+};
+
+// Counters showing how much setup work the shared context saved, and how much
+// the QoS settings held transfers back
+struct TransferStats {
+    long handlesCreated = 0;
+    long handlesReused = 0;
+    long newConnections = 0;
+    long reusedConnections = 0;
+    long long throttledMs = 0;  // waiting for the rate limit, summed over transfers
+    long long pausedMs = 0;     // paused by the idle policy, summed over transfers
+    long pauses = 0;            // times the idle policy paused downloads
+};
+
+// Function to initialize libcurl and the shared transfer context: a CURLSH that
+// shares the DNS cache, TLS sessions and live connections between all requests,
+// plus a pool of easy handles. Call once at startup instead of curl_global_init.
+bool InitTransfers(const TransferOptions& options);
+
+// Function to release the shared context and libcurl (instead of curl_global_cleanup)
+void CleanupTransfers();
+
+// Function to get an easy handle attached to the shared context. Use it in place
+// of curl_easy_init and give it back with ReleaseEasyHandle. Works without
+// InitTransfers too, just without sharing.
+CURL* AcquireEasyHandle();
+
+// Function to return an easy handle to the pool (in place of curl_easy_cleanup)
+void ReleaseEasyHandle(CURL* curl);
+
+// Function to make curl abort an asset download that stays below the failover
+// threshold, so the caller can move on to another source; connections is how
+// many transfers share the threshold. Not applied while the QoS settings hold
+// transfers back on purpose.
+void ApplyFailoverThreshold(CURL* curl, int connections);
+
+// Function to apply the context's connection policy to a multi handle
+void ConfigureMultiHandle(CURLM* multi);
+
+// Why a transfer is paused: the QoS settings hold it back, or a segment is too
+// far ahead of the download's hash. It goes on only once nothing holds it.
+enum class PauseReason { Qos = 1, Hash = 2 };
+
+// Function to record that a transfer is being paused for reason; call it before
+// curl_easy_pause or returning CURL_WRITEFUNC_PAUSE
+void HoldTransfer(CURL* curl, PauseReason reason);
+
+// Function to drop a reason a transfer was paused for, resuming it
+// (CURLPAUSE_CONT) only if no other reason still holds it
+void ReleaseTransfer(CURL* curl, PauseReason reason);
+
+// Function to get how long a transfer loop may wait in curl_multi_poll: at most
+// timeoutMs, and only briefly while the QoS settings hold a transfer paused, as
+// its progress callback, run by curl_multi_perform, is what resumes it
+int TransferPollTimeoutMs(int timeoutMs);
+
+// Function to get the reuse and throttling counters so far
+TransferStats GetTransferStats();
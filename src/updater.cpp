@@ -0,0 +1,1521 @@
+#include "updater.h"
+
+#include <iostream>
+#include <string>
+#include <curl/curl.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+#include <limits>
+#include <thread>
+#include "curl_stream.h"
+#include "archive_stream.h"
+#include "artifact_store.h"
+#include "asset_mirrors.h"
+#include "asset_variant.h"
+#include "companion_tools.h"
+#include "cookie_export.h"
+#include "delta_update.h"
+#include "download.h"
+#include "fan_out.h"
+#include "launch_latency.h"
+#include "logger.h"
+#include "metrics.h"
+#include "mirror_server.h"
+#include "platform.h"
+#include "poll_scheduler.h"
+#include "release_cache.h"
+#include "release_parser.h"
+#include "sha256.h"
+#include "task_graph.h"
+#include "transfer_context.h"
+
+namespace fs = std::filesystem;
+
+// Worker threads installing into additional Tools directories
+const size_t kInstallWorkers = 4;
+
+// Threads a release check's steps run on; at most the release request, the
+// reading of the installed versions, a prompt and the companion tools overlap
+const size_t kCheckWorkers = 4;
+
+// Block manifests for delta updates are published next to the binary under this suffix
+const char* const kBlockManifestSuffix = ".blocks.json";
+
+// An onedir build is extracted here, then its executable and _internal
+// directory are staged next to the installed ones
+const char* const kOneDirStagingName = "yt-dlp-onedir.new";
+
+// --variant auto installs every candidate build under this directory to time
+// its launches, and remembers the fastest in kLaunchChoiceName
+const char* const kLaunchTestName = "yt-dlp-launch-test";
+const char* const kLaunchChoiceName = "yt-dlp-launch.json";
+const int kLaunchWarmRuns = 5;
+
+// --export-cookies writes the browser's cookies to kCookieJarName and remembers
+// which state of the browser's database it exported in kCookieStateName. The
+// browser stays in yt-dlp.conf as a comment behind kCookieSourceMarker.
+const char* const kCookieJarName = "cookies.txt";
+const char* const kCookieStateName = "yt-dlp-cookies-source.txt";
+const char* const kCookieSourceMarker = "# Cookies exported by the updater from: ";
+
+// Installs are prepared under "<name>.new" and swapped in; "<name>.bak" holds the
+// old binary while a two-step swap is in progress
+const char* const kStagedSuffix = ".new";
+const char* const kBackupSuffix = ".bak";
+
+// Callback function to handle CURL response
+size_t WriteCallback(void* contents, size_t size, size_t nmemb, std::string* userp) {
+    userp->append((char*)contents, size * nmemb);
+    return size * nmemb;
+}
+
+// Function to read version from version file
+std::string ReadVersionFile(const std::string& versionFilePath) {
+    if (!fs::exists(versionFilePath)) {
+        return "";
+    }
+    
+    std::ifstream file(versionFilePath);
+    if (!file.is_open()) {
+        LogError() << "Failed to open version file: " << versionFilePath;
+        return "";
+    }
+    
+    std::string version;
+    std::getline(file, version);
+    file.close();
+    
+    return version;
+}
+
+// Function to write version to version file
+bool WriteVersionFile(const std::string& versionFilePath, const std::string& version) {
+    std::ofstream file(versionFilePath);
+    if (!file.is_open()) {
+        LogError() << "Failed to create version file: " << versionFilePath;
+        return false;
+    }
+    
+    file << version;
+    file.close();
+    
+    return true;
+}
+
+// Function to fetch the latest release information from GitHub.
+// The previous answer is kept in cachePath; its ETag/Last-Modified are sent as
+// validators so an unchanged release costs a bodyless 304 instead of a full
+// download and parse (conditional requests also don't count against GitHub's
+// rate limit). A changed release is parsed while it streams in and the transfer
+// is dropped as soon as the needed fields have been seen. rateLimit receives
+// the API rate limit headers of the response.
+bool FetchLatestReleaseInfo(const std::string& apiUrl, const std::string& cachePath, const std::vector<std::string>& assetNames, std::string& downloadUrl, std::string& latestVersion, std::string& checksumsUrl, RateLimit& rateLimit) {
+    ReleaseFields fields;
+    if (!FetchLatestRelease(apiUrl, cachePath, assetNames, fields, rateLimit)) {
+        return false;
+    }
+    downloadUrl = fields.downloadUrl;
+    latestVersion = fields.tagName;
+    checksumsUrl = fields.checksumsUrl;
+    return true;
+}
+
+bool SelectReleaseAsset(const ReleaseFields& fields, const std::vector<std::string>& assetNames, std::string& downloadUrl) {
+    for (const auto& name : assetNames) {
+        auto asset = fields.assetUrls.find(name);
+        if (asset != fields.assetUrls.end() && !asset->second.empty()) {
+            downloadUrl = asset->second;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool FetchLatestRelease(const std::string& apiUrl, const std::string& cachePath, const std::vector<std::string>& assetNames, ReleaseFields& fields, RateLimit& rateLimit) {
+    CURL* curl = AcquireEasyHandle();
+    HttpHeaders responseHeaders;
+
+    if (!curl) {
+        LogError() << "Failed to initialize CURL";
+        return false;
+    }
+
+    // A cache written for other assets (e.g. by an older version) can't answer for these
+    ReleaseCache cache;
+    bool haveCache = ReadReleaseCache(cachePath, cache);
+    for (const auto& name : assetNames) {
+        haveCache = haveCache && cache.assetUrls.count(name) > 0;
+    }
+
+    // Set up CURL options
+    curl_easy_setopt(curl, CURLOPT_URL, apiUrl.c_str());
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, HeaderCallback);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, &responseHeaders);
+    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L); // Follow redirects
+    curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 1L); // Verify SSL certificate
+    
+    // Add User-Agent header (required by GitHub API)
+    struct curl_slist* headers = NULL;
+    headers = curl_slist_append(headers, "User-Agent: yt-dlp-updater");
+    
+    // Make the request conditional on the cached release
+    if (haveCache) {
+        if (!cache.etag.empty()) {
+            headers = curl_slist_append(headers, ("If-None-Match: " + cache.etag).c_str());
+        }
+        if (!cache.lastModified.empty()) {
+            headers = curl_slist_append(headers, ("If-Modified-Since: " + cache.lastModified).c_str());
+        }
+    }
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+
+    bool extracted = false;
+    bool notModified = false;
+    {
+        // Run the request until the status and the first body bytes are in
+        CurlStreamBuf body(curl);
+        if (!body.WaitForBody()) {
+            LogError() << "curl_easy_perform() failed: " << curl_easy_strerror(body.Result());
+        } else {
+            // Get the response code
+            long responseCode = 0;
+            curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &responseCode);
+            
+            if (responseCode == 304 && haveCache) {
+                notModified = true;
+            } else if (responseCode != 200) {
+                LogError() << "HTTP request failed with response code: " << responseCode;
+            } else {
+                // Parse the body as it arrives; leaving this scope drops the rest of it
+                std::istream stream(&body);
+                extracted = ExtractReleaseInfo(stream, assetNames, fields);
+            }
+        }
+    }
+    
+    // Clean up
+    RecordRequestMetrics(curl, "release");
+    curl_slist_free_all(headers);
+    ReleaseEasyHandle(curl);
+    rateLimit = GetRateLimit(responseHeaders);
+    
+    // Not modified: the cached release is still the latest one
+    if (notModified) {
+        fields = ReleaseFields();
+        fields.tagName = cache.tagName;
+        fields.checksumsUrl = cache.checksumsUrl;
+        for (const auto& asset : cache.assetUrls) {
+            if (!asset.second.empty()) {
+                fields.assetUrls.insert(asset);
+            }
+        }
+        if (!SelectReleaseAsset(fields, assetNames, fields.downloadUrl)) {
+            fields.downloadUrl = cache.downloadUrl;
+        }
+        
+        LogInfo() << "Latest version: " << fields.tagName << " (unchanged since last check)";
+        LogDebug() << "Download URL: " << fields.downloadUrl;
+        return true;
+    }
+    
+    if (!extracted) {
+        return false;
+    }
+    
+    LogInfo() << "Latest version: " << fields.tagName;
+    LogDebug() << "Download URL: " << fields.downloadUrl;
+    
+    // Remember the validators for the next check (not fatal if this fails),
+    // including which of the assets the release lacks
+    ReleaseCache updatedCache;
+    updatedCache.etag = GetHeader(responseHeaders, "ETag");
+    updatedCache.lastModified = GetHeader(responseHeaders, "Last-Modified");
+    updatedCache.tagName = fields.tagName;
+    updatedCache.downloadUrl = fields.downloadUrl;
+    updatedCache.checksumsUrl = fields.checksumsUrl;
+    for (const auto& name : assetNames) {
+        auto asset = fields.assetUrls.find(name);
+        updatedCache.assetUrls[name] = asset != fields.assetUrls.end() ? asset->second : "";
+    }
+    if (!WriteReleaseCache(cachePath, updatedCache)) {
+        LogError() << "Failed to update release cache: " << cachePath;
+    }
+    return true;
+}
+
+// Function to fetch the SHA2-256SUMS listing and look up the checksum of assetName
+bool FetchExpectedSha256(const std::string& checksumsUrl, const std::string& assetName, std::string& sha256) {
+    CURL* curl = AcquireEasyHandle();
+    std::string response;
+
+    if (!curl) {
+        LogError() << "Failed to initialize CURL";
+        return false;
+    }
+
+    // Set up CURL options
+    curl_easy_setopt(curl, CURLOPT_URL, checksumsUrl.c_str());
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
+    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L); // Follow redirects
+    curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 1L); // Verify SSL certificate
+    
+    struct curl_slist* headers = NULL;
+    headers = curl_slist_append(headers, "User-Agent: yt-dlp-updater");
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+
+    // Perform the request
+    CURLcode res = curl_easy_perform(curl);
+    
+    long responseCode = 0;
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &responseCode);
+    
+    RecordRequestMetrics(curl, "checksums");
+    curl_slist_free_all(headers);
+    ReleaseEasyHandle(curl);
+    
+    if (res != CURLE_OK) {
+        LogError() << "curl_easy_perform() failed: " << curl_easy_strerror(res);
+        return false;
+    }
+    
+    if (responseCode != 200) {
+        LogError() << "HTTP request failed with response code: " << responseCode;
+        return false;
+    }
+    
+    sha256 = FindChecksum(response, assetName);
+    if (sha256.empty()) {
+        LogError() << assetName << " is not listed in " << checksumsUrl;
+        return false;
+    }
+    
+    LogDebug() << "Expected SHA-256: " << sha256;
+    return true;
+}
+
+// Function to get rid of a staged file left behind by an earlier attempt (it may be read-only)
+void DiscardStaged(const std::string& stagedPath) {
+    std::error_code ec;
+    if (fs::exists(stagedPath, ec)) {
+        RemoveReadOnlyAttribute(stagedPath);
+        fs::remove(stagedPath, ec);
+    }
+}
+
+// Function to remove a staged or backed-up directory tree. Files a running
+// yt-dlp still has open may stay behind; the next install tries again.
+void DiscardTree(const std::string& path) {
+    std::error_code ec;
+    if (fs::exists(path, ec)) {
+        fs::remove_all(path, ec);
+    }
+}
+
+// Function to put a finished staged binary in place of the live one. Normally a
+// single atomic rename; where the OS can't replace the live file that way, the
+// live binary is first moved aside to ".bak" so it can be restored if the
+// second rename fails.
+bool SwapIntoPlace(const std::string& stagedPath, const std::string& ytDlpPath) {
+    if (ReplaceFileAtomically(stagedPath, ytDlpPath)) {
+        return true;
+    }
+    
+    std::string backupPath = ytDlpPath + kBackupSuffix;
+    DiscardStaged(backupPath);
+    
+    std::error_code ec;
+    bool hadLive = fs::exists(ytDlpPath, ec);
+    if (hadLive) {
+        fs::rename(ytDlpPath, backupPath, ec);
+        if (ec) {
+            LogError() << "Failed to move the installed yt-dlp.exe aside: " << ec.message();
+            return false;
+        }
+    }
+    
+    fs::rename(stagedPath, ytDlpPath, ec);
+    if (ec) {
+        LogError() << "Failed to move the new yt-dlp.exe into place: " << ec.message();
+        if (hadLive) {
+            fs::rename(backupPath, ytDlpPath, ec);
+        }
+        return false;
+    }
+    
+    // A backup that is still running can't be deleted on Windows; the next install removes it
+    DiscardStaged(backupPath);
+    return true;
+}
+
+// Function to finish an install that was interrupted between its renames: a
+// missing binary is restored from ".bak", and a staged version file is kept
+// only if its binary made it into place
+void RecoverInterruptedInstall(const std::string& vrchatToolsPath) {
+    std::string ytDlpPath = JoinPath(vrchatToolsPath, "yt-dlp.exe");
+    std::string backupPath = ytDlpPath + kBackupSuffix;
+    std::string versionFilePath = JoinPath(vrchatToolsPath, "yt-dlp-version.txt");
+    std::string stagedVersionPath = versionFilePath + kStagedSuffix;
+    std::string librariesPath = JoinPath(vrchatToolsPath, kOneDirLibraryName);
+    std::string librariesBackupPath = librariesPath + kBackupSuffix;
+    
+    // An onedir build's old libraries go back if its binary never replaced the old one
+    std::error_code ec;
+    if (fs::exists(librariesBackupPath, ec)) {
+        if (fs::exists(ytDlpPath + kStagedSuffix, ec)) {
+            LogInfo() << "Restoring " << kOneDirLibraryName << " from an interrupted install in " << vrchatToolsPath;
+            DiscardTree(librariesPath);
+            fs::rename(librariesBackupPath, librariesPath, ec);
+        } else {
+            DiscardTree(librariesBackupPath);
+        }
+    }
+    DiscardTree(librariesPath + kStagedSuffix);
+    DiscardTree(JoinPath(vrchatToolsPath, kOneDirStagingName));
+    
+    if (fs::exists(backupPath, ec)) {
+        if (!fs::exists(ytDlpPath, ec)) {
+            LogInfo() << "Restoring yt-dlp.exe from an interrupted install in " << vrchatToolsPath;
+            fs::rename(backupPath, ytDlpPath, ec);
+        } else {
+            DiscardStaged(backupPath);
+        }
+    }
+    
+    if (fs::exists(stagedVersionPath, ec)) {
+        if (fs::exists(ytDlpPath + kStagedSuffix, ec)) {
+            fs::remove(stagedVersionPath, ec);
+        } else {
+            fs::rename(stagedVersionPath, versionFilePath, ec);
+        }
+    }
+}
+
+// Function to download an onedir build and stage it next to the installed
+// yt-dlp.exe: the executable as "yt-dlp.exe.new" and its libraries as "_internal.new"
+bool StageOneDir(const std::string& vrchatToolsPath, const std::string& downloadUrl, const AssetVariant& variant, const std::string& expectedSha256) {
+    std::string stagingPath = JoinPath(vrchatToolsPath, kOneDirStagingName);
+    if (!DownloadAndExtractTree(downloadUrl, stagingPath, expectedSha256)) {
+        return false;
+    }
+    
+    // The build may sit in a top-level directory of the archive
+    std::error_code ec;
+    fs::path root = stagingPath;
+    if (!fs::exists(root / variant.executable, ec)) {
+        for (fs::directory_iterator it(stagingPath, ec), end; !ec && it != end; it.increment(ec)) {
+            if (it->is_directory(ec) && fs::exists(it->path() / variant.executable, ec)) {
+                root = it->path();
+                break;
+            }
+        }
+    }
+    if (!fs::is_regular_file(root / variant.executable, ec) || !fs::is_directory(root / kOneDirLibraryName, ec)) {
+        LogError() << "The archive does not contain " << variant.executable << " and " << kOneDirLibraryName;
+        DiscardTree(stagingPath);
+        return false;
+    }
+    
+    std::string stagedPath = JoinPath(vrchatToolsPath, "yt-dlp.exe") + kStagedSuffix;
+    std::string stagedLibrariesPath = JoinPath(vrchatToolsPath, kOneDirLibraryName) + kStagedSuffix;
+    DiscardTree(stagedLibrariesPath);
+    fs::rename(root / variant.executable, stagedPath, ec);
+    if (!ec) {
+        fs::rename(root / kOneDirLibraryName, stagedLibrariesPath, ec);
+    }
+    DiscardTree(stagingPath);
+    if (ec) {
+        LogError() << "Failed to stage the onedir build: " << ec.message();
+        DiscardStaged(stagedPath);
+        return false;
+    }
+    return true;
+}
+
+// Function to stage yt-dlp.exe. The new binary is downloaded (or, with a
+// deltaManifestUrl, rebuilt from the installed one) and verified next to the
+// installed one as "yt-dlp.exe.new", which stays usable until FinishInstall
+// swaps the new one in.
+bool StageYtDlp(const std::string& vrchatToolsPath, const std::string& downloadUrl, const std::string& latestVersion, const std::string& expectedSha256, const std::string& deltaManifestUrl) {
+    std::string ytDlpPath = JoinPath(vrchatToolsPath, "yt-dlp.exe");
+    std::string stagedPath = ytDlpPath + kStagedSuffix;
+    std::string assetName = downloadUrl.substr(downloadUrl.find_last_of('/') + 1);
+    bool archive = ArchiveFormatFor(assetName) != ArchiveFormat::None;
+    const AssetVariant* variant = VariantForAsset(assetName);
+    bool oneDir = variant && variant->layout == AssetLayout::OneDir;
+    
+    LogDebug() << "Using VRChat Tools directory: " << vrchatToolsPath;
+    
+    // Check Tools directory attributes before operations
+    CheckAttributes(vrchatToolsPath, "Tools directory (before)");
+    
+    // Create directory if it doesn't exist
+    if (!fs::exists(vrchatToolsPath)) {
+        LogInfo() << "Creating VRChat Tools directory: " << vrchatToolsPath;
+        fs::create_directories(vrchatToolsPath);
+        
+        // Check Tools directory attributes after creation
+        CheckAttributes(vrchatToolsPath, "Tools directory (after creation)");
+    }
+    DiscardStaged(stagedPath);
+    
+    // Check if yt-dlp.exe exists
+    bool deltaApplied = false;
+    if (fs::exists(ytDlpPath)) {
+        LogDebug() << "Existing yt-dlp.exe found at: " << ytDlpPath;
+        
+        // Check yt-dlp.exe attributes before operations
+        CheckAttributes(ytDlpPath, "yt-dlp.exe (before)");
+        
+        // Build the new version from the blocks it shares with the installed one
+        if (!deltaManifestUrl.empty() && !archive) {
+            LogInfo() << "Trying delta update from existing yt-dlp.exe...";
+            deltaApplied = DeltaDownloadFile(downloadUrl, deltaManifestUrl, ytDlpPath, stagedPath, expectedSha256);
+            if (!deltaApplied) {
+                LogWarning() << "Delta update failed, downloading the full file instead.";
+            }
+        }
+    }
+    
+    // Pick the fastest of the release's URL and the mirrors. Archives stream
+    // into the decoder, so they take the best remote source and stay on it.
+    std::vector<std::string> sources = {downloadUrl};
+    if (!deltaApplied) {
+        sources = RankAssetSources(downloadUrl, latestVersion, expectedSha256, JoinPath(vrchatToolsPath, kMirrorHistoryName));
+    }
+    auto remote = std::find_if(sources.begin(), sources.end(), [](const std::string& source) { return !IsLocalSource(source); });
+    const std::string& archiveUrl = remote != sources.end() ? *remote : downloadUrl;
+    
+    // Download the latest yt-dlp.exe next to the installed one
+    if (oneDir) {
+        LogInfo() << "Downloading and extracting latest " << assetName << " to: " << vrchatToolsPath;
+        if (!StageOneDir(vrchatToolsPath, archiveUrl, *variant, expectedSha256)) {
+            LogError() << "Failed to download yt-dlp.exe; the installed version is unchanged.";
+            return false;
+        }
+    } else if (archive) {
+        LogInfo() << "Downloading and extracting latest yt-dlp.exe to: " << stagedPath;
+        if (!DownloadAndExtract(archiveUrl, variant ? variant->executable : "yt-dlp.exe", stagedPath, expectedSha256)) {
+            LogError() << "Failed to download yt-dlp.exe; the installed version is unchanged.";
+            return false;
+        }
+    } else if (!deltaApplied) {
+        LogInfo() << "Downloading latest yt-dlp.exe to: " << stagedPath;
+        if (!DownloadFile(sources, stagedPath, expectedSha256)) {
+            LogError() << "Failed to download yt-dlp.exe; the installed version is unchanged.";
+            return false;
+        }
+    }
+    
+    LogInfo() << "Successfully downloaded yt-dlp.exe!";
+    return true;
+}
+
+// Function to discard what StageYtDlp left next to the installed yt-dlp.exe
+// when the install doesn't go ahead
+void DiscardStagedInstall(const std::string& vrchatToolsPath) {
+    DiscardStaged(JoinPath(vrchatToolsPath, "yt-dlp.exe") + kStagedSuffix);
+    DiscardTree(JoinPath(vrchatToolsPath, kOneDirLibraryName) + kStagedSuffix);
+}
+
+// Function to stage and install yt-dlp.exe in one go
+bool UpdateYtDlp(const std::string& vrchatToolsPath, const std::string& downloadUrl, const std::string& latestVersion, const std::string& expectedSha256, const std::string& deltaManifestUrl) {
+    return StageYtDlp(vrchatToolsPath, downloadUrl, latestVersion, expectedSha256, deltaManifestUrl) &&
+           FinishInstall(vrchatToolsPath, JoinPath(vrchatToolsPath, "yt-dlp.exe") + kStagedSuffix, latestVersion);
+}
+
+// Function to finish installing a new yt-dlp.exe staged at stagedPath: medium
+// integrity level and read-only attribute are applied to the staged file, then
+// it replaces yt-dlp.exe in one rename and the version file follows
+bool FinishInstall(const std::string& vrchatToolsPath, const std::string& stagedPath, const std::string& latestVersion) {
+    std::string ytDlpPath = JoinPath(vrchatToolsPath, "yt-dlp.exe");
+    std::string versionFilePath = JoinPath(vrchatToolsPath, "yt-dlp-version.txt");
+    std::string stagedVersionPath = versionFilePath + kStagedSuffix;
+    
+    // Set integrity level to medium
+    LogDebug() << "Setting integrity level to medium: " << stagedPath;
+    
+    // Verify stagedPath is a valid location before changing its security descriptor
+    if (!fs::exists(stagedPath) || !fs::is_regular_file(stagedPath)) {
+        LogError() << "Invalid file path for integrity level setting: " << stagedPath;
+        return false;
+    }
+    
+    // Verify the path is within the expected directory to prevent directory traversal attacks
+    std::string expectedDir = vrchatToolsPath;
+    if (stagedPath.find(expectedDir) != 0) {
+        LogError() << "Security check failed: yt-dlp.exe path is outside the expected directory";
+        return false;
+    }
+    
+    if (!TimePhase("integrity_level", stagedPath, [&]() { return SetMediumIntegrityLevel(stagedPath); })) {
+        LogError() << "Failed to set integrity level.";
+        return false;
+    }
+    LogDebug() << "Successfully set integrity level to medium.";
+    
+    // Linux builds run natively under Proton and need the executable bit
+    std::error_code ec;
+    fs::permissions(stagedPath, fs::perms::owner_exec | fs::perms::group_exec | fs::perms::others_exec, fs::perm_options::add, ec);
+    
+    // Make the new contents durable while the file can still be opened for
+    // writing; the swap only renames it
+    if (!TimePhase("flush", stagedPath, [&]() { return FlushFileToDisk(stagedPath); })) {
+        LogError() << "Failed to flush the new yt-dlp.exe to disk.";
+        return false;
+    }
+    
+    // Set read-only attribute on the new file (only on the file, not the directory)
+    if (!TimePhase("set_read_only", stagedPath, [&]() { return SetReadOnlyAttribute(stagedPath); })) {
+        LogError() << "Failed to set read-only attribute on the new file.";
+        return false;
+    }
+    
+    // Stage the version file too; it only replaces the old one once the binary has
+    if (!TimePhase("version_file", stagedVersionPath, [&]() { return WriteVersionFile(stagedVersionPath, latestVersion); })) {
+        LogError() << "Failed to write version file.";
+        return false;
+    }
+    
+    // An onedir build's libraries go in right before its binary; the old ones
+    // are kept aside until the binary has been swapped too
+    std::string librariesPath = JoinPath(vrchatToolsPath, kOneDirLibraryName);
+    std::string stagedLibrariesPath = librariesPath + kStagedSuffix;
+    std::string librariesBackupPath = librariesPath + kBackupSuffix;
+    bool oneDir = fs::is_directory(stagedLibrariesPath, ec);
+    DiscardTree(librariesBackupPath);
+    if (oneDir) {
+        if (fs::exists(librariesPath, ec)) {
+            fs::rename(librariesPath, librariesBackupPath, ec);
+        }
+        if (!ec) {
+            fs::rename(stagedLibrariesPath, librariesPath, ec);
+        }
+        if (ec) {
+            LogError() << "Failed to move the new " << kOneDirLibraryName << " into place: " << ec.message();
+            RecoverInterruptedInstall(vrchatToolsPath);
+            fs::remove(stagedVersionPath, ec);
+            return false;
+        }
+    }
+    
+    // The only moment yt-dlp.exe changes
+    if (!TimePhase("swap", ytDlpPath, [&]() { return SwapIntoPlace(stagedPath, ytDlpPath); })) {
+        LogError() << "Failed to swap in the new yt-dlp.exe; the installed version is unchanged.";
+        RecoverInterruptedInstall(vrchatToolsPath);
+        fs::remove(stagedVersionPath, ec);
+        return false;
+    }
+    
+    // A onefile build doesn't need the libraries an earlier onedir install left
+    if (!oneDir && fs::exists(librariesPath, ec)) {
+        fs::rename(librariesPath, librariesBackupPath, ec);
+    }
+    DiscardTree(librariesBackupPath);
+    
+    fs::rename(stagedVersionPath, versionFilePath, ec);
+    if (ec) {
+        LogError() << "Failed to update version file: " << ec.message();
+        return false;
+    }
+    
+    LogInfo() << "Successfully updated yt-dlp.exe and set read-only attribute!";
+    LogDebug() << "Updated version file with version: " << latestVersion;
+    
+    // Check attributes after all operations
+    CheckAttributes(ytDlpPath, "yt-dlp.exe (after)");
+    CheckAttributes(vrchatToolsPath, "Tools directory (after all operations)");
+    
+    return true;
+}
+
+// Function to install a verified yt-dlp.exe that is already on this machine
+// (another Tools directory's binary or a stored release) without downloading it
+bool InstallFromFile(const std::string& sourcePath, const std::string& vrchatToolsPath, const std::string& latestVersion, PlacementMethod& method) {
+    std::string stagedPath = JoinPath(vrchatToolsPath, "yt-dlp.exe") + kStagedSuffix;
+    
+    // Create directory if it doesn't exist
+    std::error_code ec;
+    fs::create_directories(vrchatToolsPath, ec);
+    if (ec) {
+        LogError() << "Failed to create " << vrchatToolsPath << ": " << ec.message();
+        return false;
+    }
+    DiscardStaged(stagedPath);
+    
+    // A hard link shares the source's permissions, so only link between directories of the same account
+    bool allowHardLink = SameOwner(fs::path(sourcePath).parent_path().string(), vrchatToolsPath);
+    if (!TimePhase("place_file", stagedPath, [&]() { return PlaceFile(sourcePath, stagedPath, allowHardLink, method); })) {
+        return false;
+    }
+    
+    return FinishInstall(vrchatToolsPath, stagedPath, latestVersion);
+}
+
+// Function to install the yt-dlp.exe of another Tools directory (or of a
+// launch test install), together with its _internal directory if it's an onedir build
+bool InstallFromTools(const std::string& sourceToolsPath, const std::string& vrchatToolsPath, const std::string& latestVersion, PlacementMethod& method) {
+    std::string sourceLibrariesPath = JoinPath(sourceToolsPath, kOneDirLibraryName);
+    std::string stagedLibrariesPath = JoinPath(vrchatToolsPath, kOneDirLibraryName) + kStagedSuffix;
+    std::error_code ec;
+    if (fs::is_directory(sourceLibrariesPath, ec)) {
+        // Same rules as for the binary: hard links between directories of one account, copies otherwise
+        DiscardTree(stagedLibrariesPath);
+        bool allowHardLink = SameOwner(sourceToolsPath, vrchatToolsPath);
+        for (fs::recursive_directory_iterator it(sourceLibrariesPath, ec), end; !ec && it != end; it.increment(ec)) {
+            fs::path target = fs::path(stagedLibrariesPath) / fs::relative(it->path(), sourceLibrariesPath);
+            std::error_code entryError;
+            if (it->is_directory(entryError)) {
+                fs::create_directories(target, entryError);
+            } else if (!PlaceFile(it->path().string(), target.string(), allowHardLink, method)) {
+                DiscardTree(stagedLibrariesPath);
+                return false;
+            }
+        }
+        if (ec) {
+            LogError() << "Failed to read " << sourceLibrariesPath << ": " << ec.message();
+            DiscardTree(stagedLibrariesPath);
+            return false;
+        }
+    }
+    
+    return InstallFromFile(JoinPath(sourceToolsPath, "yt-dlp.exe"), vrchatToolsPath, latestVersion, method);
+}
+
+// Function to install the build a launch test installed, by moving it over
+// rather than linking it, so removing the test install can't touch its files
+bool InstallMeasured(const std::string& measuredPath, const std::string& vrchatToolsPath, const std::string& latestVersion) {
+    std::string stagedPath = JoinPath(vrchatToolsPath, "yt-dlp.exe") + kStagedSuffix;
+    std::string measuredLibrariesPath = JoinPath(measuredPath, kOneDirLibraryName);
+    std::string stagedLibrariesPath = JoinPath(vrchatToolsPath, kOneDirLibraryName) + kStagedSuffix;
+    DiscardStaged(stagedPath);
+    DiscardTree(stagedLibrariesPath);
+    
+    std::error_code ec;
+    if (fs::is_directory(measuredLibrariesPath, ec)) {
+        fs::rename(measuredLibrariesPath, stagedLibrariesPath, ec);
+    }
+    if (!ec) {
+        fs::rename(JoinPath(measuredPath, "yt-dlp.exe"), stagedPath, ec);
+    }
+    if (ec) {
+        LogError() << "Failed to move the measured build into " << vrchatToolsPath << ": " << ec.message();
+        DiscardTree(stagedLibrariesPath);
+        return false;
+    }
+    return FinishInstall(vrchatToolsPath, stagedPath, latestVersion);
+}
+
+// Function to record the release now installed in a Tools directory in its
+// store and trim the store to its size cap. sha256 may be "" and then receives
+// the computed hash. heldBackTag is the release to skip until a newer one
+// appears ("" after a normal update).
+bool RecordInstall(const UpdaterOptions& options, const std::string& vrchatToolsPath, const std::string& tag, std::string& sha256, const std::string& heldBackTag) {
+    // The store keeps single binaries; an onedir build's yt-dlp.exe is useless without its libraries
+    std::error_code ec;
+    if (fs::is_directory(JoinPath(vrchatToolsPath, kOneDirLibraryName), ec)) {
+        LogInfo() << "Onedir builds are not kept in the store for rollback.";
+        return true;
+    }
+    
+    ArtifactStore store;
+    if (!OpenArtifactStore(vrchatToolsPath, store)) {
+        return false;
+    }
+    
+    if (!AddToStore(store, JoinPath(vrchatToolsPath, "yt-dlp.exe"), tag, sha256)) {
+        LogError() << "Failed to add " << tag << " to the store in " << vrchatToolsPath;
+        return false;
+    }
+    sha256 = FindStoreEntry(store, tag)->sha256;
+    store.heldBackTag = heldBackTag;
+    
+    CollectGarbage(store, options.storeMaxBytes, sha256);
+    return SaveArtifactStore(store);
+}
+
+// Function to put the installed release into the store before it gets replaced,
+// for installs that predate the store
+void PreserveInstalled(const std::string& vrchatToolsPath) {
+    std::string ytDlpPath = JoinPath(vrchatToolsPath, "yt-dlp.exe");
+    std::string currentVersion = ReadVersionFile(JoinPath(vrchatToolsPath, "yt-dlp-version.txt"));
+    if (currentVersion.empty() || !fs::exists(ytDlpPath) || fs::is_directory(JoinPath(vrchatToolsPath, kOneDirLibraryName))) {
+        return;
+    }
+    
+    ArtifactStore store;
+    if (!OpenArtifactStore(vrchatToolsPath, store) || FindStoreEntry(store, currentVersion)) {
+        return;
+    }
+    if (AddToStore(store, ytDlpPath, currentVersion, "")) {
+        LogInfo() << "Kept " << currentVersion << " in the store for rollback.";
+        SaveArtifactStore(store);
+    }
+}
+
+// Function to switch a Tools directory to a stored release without any network
+// access. Without a tag, the most recently used release other than the
+// installed one is picked. The release rolled back from is held back so the
+// next check doesn't reinstall it.
+bool RollbackYtDlp(const UpdaterOptions& options, const std::string& vrchatToolsPath, const std::string& tag) {
+    auto start = std::chrono::steady_clock::now();
+    RecoverInterruptedInstall(vrchatToolsPath);
+    PreserveInstalled(vrchatToolsPath);
+    
+    ArtifactStore store;
+    if (!OpenArtifactStore(vrchatToolsPath, store)) {
+        return false;
+    }
+    
+    std::string currentVersion = ReadVersionFile(JoinPath(vrchatToolsPath, "yt-dlp-version.txt"));
+    const StoreEntry* target = nullptr;
+    for (const auto& entry : store.entries) {
+        if (tag.empty() ? entry.tag != currentVersion && (!target || entry.lastUsed > target->lastUsed) : entry.tag == tag) {
+            target = &entry;
+        }
+    }
+    if (!target) {
+        LogError() << "No stored release " << (tag.empty() ? "to roll back to" : tag) << " in " << vrchatToolsPath;
+        return false;
+    }
+    if (target->tag == currentVersion) {
+        LogInfo() << vrchatToolsPath << " already has " << currentVersion << " installed.";
+        return true;
+    }
+    
+    std::string targetTag = target->tag;
+    std::string sha256 = target->sha256;
+    PlacementMethod method = PlacementMethod::Copy;
+    if (!InstallFromFile(StoreObjectPath(store, sha256), vrchatToolsPath, targetTag, method) ||
+        !RecordInstall(options, vrchatToolsPath, targetTag, sha256, currentVersion)) {
+        LogError() << "Failed to roll back " << vrchatToolsPath << " to " << targetTag;
+        return false;
+    }
+    
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    LogInfo() << "Rolled back " << vrchatToolsPath << " from " << (currentVersion.empty() ? "Unknown" : currentVersion)
+              << " to " << targetTag << " (" << PlacementMethodName(method) << ") in " << elapsed.count() << " ms";
+    return true;
+}
+
+// Function to print the releases stored for a Tools directory
+void ListStoredVersions(const std::string& vrchatToolsPath) {
+    ArtifactStore store;
+    if (!OpenArtifactStore(vrchatToolsPath, store)) {
+        return;
+    }
+    
+    std::string currentVersion = ReadVersionFile(JoinPath(vrchatToolsPath, "yt-dlp-version.txt"));
+    LogInfo() << "Stored releases in " << vrchatToolsPath << ":";
+    if (store.entries.empty()) {
+        LogInfo() << "  (none)";
+    }
+    for (const auto& entry : store.entries) {
+        char installedAt[32] = "";
+        std::strftime(installedAt, sizeof(installedAt), "%Y-%m-%d %H:%M", std::localtime(&entry.installedAt));
+        LogInfo() << (entry.tag == currentVersion ? "* " : "  ") << entry.tag << "  " << entry.sha256.substr(0, 12)
+                  << "  " << entry.size << " bytes  installed " << installedAt
+                  << (entry.tag == store.heldBackTag ? "  (held back)" : "");
+    }
+}
+
+// Function to create and configure yt-dlp.conf. The cookie browser comes from
+// the browser argument if given, otherwise the user is asked (unless interactive
+// is false) and the answer is stored in browser for the next Tools directory.
+bool ConfigureYtDlp(const std::string& vrchatToolsPath, std::string& browser, bool interactive) {
+    std::string configPath = JoinPath(vrchatToolsPath, "yt-dlp.conf");
+    
+    // Check if config file already exists
+    if (fs::exists(configPath)) {
+        LogInfo() << "yt-dlp.conf already exists.";
+        return true;
+    }
+    
+    // List of available browsers
+    std::vector<std::string> browsers = {
+        "firefox", "brave", "chrome", "chromium", "edge", 
+        "opera", "safari", "vivaldi", "whale"
+    };
+    
+    // Pick the browser before creating the file, so a bad choice leaves nothing behind
+    std::string selectedBrowser;
+    if (!browser.empty()) {
+        if (std::find(browsers.begin(), browsers.end(), browser) == browsers.end()) {
+            LogError() << "Unsupported browser: " << browser;
+            return false;
+        }
+        selectedBrowser = browser;
+    } else if (!interactive) {
+        LogError() << "yt-dlp.conf does not exist; pass --browser <name> to create it without prompting.";
+        return false;
+    } else {
+        // The prompt goes straight to the console, after what is still queued;
+        // what the update check logs meanwhile waits until it is answered
+        FlushLog();
+        HoldConsoleLog(true);
+        std::cout << "\nAvailable browsers:\n";
+        for (size_t i = 0; i < browsers.size(); ++i) {
+            std::cout << i + 1 << ". " << browsers[i] << "\n";
+        }
+        
+        std::cout << "\nNote: Firefox is preferred as Chrome-based browsers may fail to work if they are running while loading videos.\n";
+        
+        int choice;
+        while (true) {
+            std::cout << "\nSelect a browser (1-9): " << std::flush;
+            if (std::cin >> choice && choice >= 1 && choice <= static_cast<int>(browsers.size())) {
+                break;
+            }
+            std::cout << "Invalid choice. Please try again.\n";
+            std::cin.clear();
+            std::cin.ignore((std::numeric_limits<std::streamsize>::max)(), '\n');
+        }
+        selectedBrowser = browsers[choice - 1];
+        
+        // Clear any leftover input
+        std::cin.clear();
+        std::cin.ignore((std::numeric_limits<std::streamsize>::max)(), '\n');
+        browser = selectedBrowser;
+        HoldConsoleLog(false);
+    }
+    
+    // The Tools directory may not exist yet on a fresh profile
+    std::error_code ec;
+    fs::create_directories(vrchatToolsPath, ec);
+    
+    // Create config file with default settings
+    std::ofstream configFile(configPath);
+    if (!configFile.is_open()) {
+        LogError() << "Failed to create yt-dlp.conf";
+        return false;
+    }
+    
+    // Write default settings
+    configFile << "--no-playlist\n";
+    configFile << "--no-warnings\n";
+    configFile << "--quiet\n";
+    configFile << "--no-progress\n";
+    
+    // Append browser selection to config file
+    configFile << "--cookies-from-browser " << selectedBrowser << std::endl;
+    configFile.close();
+    
+    LogInfo() << "Created yt-dlp.conf with selected browser: " << selectedBrowser;
+    
+    return true;
+}
+
+// Function to remove the launch test installs of --variant auto (the binaries are read-only)
+void DiscardLaunchTests(const std::string& vrchatToolsPath) {
+    std::string testPath = JoinPath(vrchatToolsPath, kLaunchTestName);
+    std::error_code ec;
+    if (!fs::exists(testPath, ec)) {
+        return;
+    }
+    for (const auto& variant : AssetVariants()) {
+        DiscardStaged(JoinPath(JoinPath(testPath, variant.name), "yt-dlp.exe"));
+    }
+    DiscardTree(testPath);
+}
+
+// Function to pick the build to install for options.assetVariant. For "auto"
+// the choice remembered in the Tools directory is used. The first time, every
+// build that runs here is installed into a test directory the way an update
+// would install it and launched with --version; the fastest warm start wins.
+// measuredPath then receives the winner's test directory, which holds the
+// latest release ready to install.
+bool ResolveAssetVariant(const UpdaterOptions& options, const std::string& vrchatToolsPath, const AssetVariant*& variant, std::string& measuredPath) {
+    measuredPath.clear();
+    if (options.assetVariant != "auto") {
+        variant = FindAssetVariant(options.assetVariant);
+        return variant != nullptr;
+    }
+    
+    std::string choicePath = JoinPath(vrchatToolsPath, kLaunchChoiceName);
+    LaunchChoice choice;
+    if (ReadLaunchChoice(choicePath, choice)) {
+        variant = FindAssetVariant(choice.variant);
+        return true;
+    }
+    
+    LogInfo() << "Measuring how fast each yt-dlp build starts (only done once)...";
+    std::string testPath = JoinPath(vrchatToolsPath, kLaunchTestName);
+    std::string apiUrl = options.apiBaseUrl + kLatestReleasePath;
+    for (const auto& candidate : AssetVariants()) {
+        if (!VariantRunsHere(candidate)) {
+            continue;
+        }
+        
+        std::string candidatePath = JoinPath(testPath, candidate.name);
+        std::error_code ec;
+        fs::create_directories(candidatePath, ec);
+        std::string downloadUrl;
+        std::string tag;
+        std::string checksumsUrl;
+        std::string sha256;
+        RateLimit rateLimit;
+        if (!FetchLatestReleaseInfo(apiUrl, JoinPath(candidatePath, "yt-dlp-release.json"), candidate.assetNames, downloadUrl, tag, checksumsUrl, rateLimit)) {
+            LogInfo() << "Skipping the " << candidate.name << " build.";
+            continue;
+        }
+        std::string assetName = downloadUrl.substr(downloadUrl.find_last_of('/') + 1);
+        if ((!checksumsUrl.empty() && !FetchExpectedSha256(checksumsUrl, assetName, sha256)) ||
+            !UpdateYtDlp(candidatePath, downloadUrl, tag, sha256, "")) {
+            LogInfo() << "Skipping the " << candidate.name << " build.";
+            continue;
+        }
+        
+        LaunchLatency latency;
+        latency.variant = candidate.name;
+        if (!MeasureLaunchLatency(JoinPath(candidatePath, "yt-dlp.exe"), kLaunchWarmRuns, latency)) {
+            LogInfo() << "The " << candidate.name << " build does not run here.";
+            continue;
+        }
+        LogInfo() << "The " << candidate.name << " build starts in " << latency.coldMs << " ms cold, "
+                  << latency.warmMedianMs << " ms warm.";
+        choice.tag = tag;
+        choice.measurements.push_back(latency);
+    }
+    
+    // Without a single measurement (e.g. offline) use the default and measure next time
+    if (choice.measurements.empty()) {
+        LogWarning() << "No yt-dlp build could be measured; installing the " << AssetVariants().front().name << " build.";
+        DiscardLaunchTests(vrchatToolsPath);
+        variant = &AssetVariants().front();
+        return true;
+    }
+    
+    // Every video load after the first is a warm start
+    const LaunchLatency* fastest = &choice.measurements.front();
+    for (const auto& latency : choice.measurements) {
+        if (latency.warmMedianMs < fastest->warmMedianMs) {
+            fastest = &latency;
+        }
+    }
+    choice.variant = fastest->variant;
+    LogInfo() << "Installing the " << choice.variant << " build, the fastest to start.";
+    WriteLaunchChoice(choicePath, choice);
+    
+    variant = FindAssetVariant(choice.variant);
+    measuredPath = JoinPath(testPath, choice.variant);
+    return true;
+}
+
+// Function to find the browser yt-dlp.conf takes cookies from, either from its
+// --cookies-from-browser option or from the note left when it was switched to
+// an export ("" if neither is there)
+std::string ReadConfiguredBrowser(const std::string& vrchatToolsPath) {
+    std::ifstream configFile(JoinPath(vrchatToolsPath, "yt-dlp.conf"));
+    const std::string option = "--cookies-from-browser ";
+    std::string line;
+    while (std::getline(configFile, line)) {
+        std::string browser;
+        if (line.compare(0, option.size(), option) == 0) {
+            browser = line.substr(option.size());
+        } else if (line.compare(0, std::strlen(kCookieSourceMarker), kCookieSourceMarker) == 0) {
+            browser = line.substr(std::strlen(kCookieSourceMarker));
+        } else {
+            continue;
+        }
+        
+        // Trim the line ending and quotes around a profile with spaces
+        browser.erase(browser.find_last_not_of(" \t\r") + 1);
+        if (browser.size() >= 2 && browser.front() == '"' && browser.back() == '"') {
+            browser = browser.substr(1, browser.size() - 2);
+        }
+        return browser;
+    }
+    return "";
+}
+
+// Function to point yt-dlp.conf at the exported cookies.txt in place of
+// --cookies-from-browser. The browser is kept in a comment so later runs know
+// where to export from.
+bool UseCookieJar(const std::string& vrchatToolsPath, const std::string& browser) {
+    std::string configPath = JoinPath(vrchatToolsPath, "yt-dlp.conf");
+    std::string jarPath = fs::path(JoinPath(vrchatToolsPath, kCookieJarName)).generic_string();
+    
+    std::ifstream configFile(configPath);
+    if (!configFile.is_open()) {
+        LogError() << "Failed to open " << configPath;
+        return false;
+    }
+    std::string current;
+    std::string updated;
+    std::string line;
+    while (std::getline(configFile, line)) {
+        current += line + "\n";
+        if (line.compare(0, 23, "--cookies-from-browser ") != 0 && line.compare(0, 10, "--cookies ") != 0 &&
+            line.compare(0, std::strlen(kCookieSourceMarker), kCookieSourceMarker) != 0) {
+            updated += line + "\n";
+        }
+    }
+    configFile.close();
+    
+    // yt-dlp splits config lines like a shell; forward slashes work on Windows too
+    updated += kCookieSourceMarker + browser + "\n";
+    updated += "--cookies \"" + jarPath + "\"\n";
+    if (updated == current) {
+        return true;
+    }
+    
+    std::string tempPath = configPath + ".tmp";
+    std::ofstream tempFile(tempPath, std::ios::trunc);
+    tempFile << updated;
+    tempFile.close();
+    std::error_code ec;
+    if (!tempFile) {
+        LogError() << "Failed to write " << tempPath;
+        fs::remove(tempPath, ec);
+        return false;
+    }
+    fs::rename(tempPath, configPath, ec);
+    if (ec) {
+        LogError() << "Failed to update " << configPath << ": " << ec.message();
+        fs::remove(tempPath, ec);
+        return false;
+    }
+    
+    LogInfo() << "yt-dlp.conf in " << vrchatToolsPath << " now reads cookies from " << kCookieJarName;
+    return true;
+}
+
+// Function to export the browser's cookies into cookies.txt in every target and
+// point yt-dlp.conf at them. The database is only read when it changed since the
+// last export, and a cookies.txt is only rewritten when its cookies changed.
+bool RefreshCookieJar(const UpdaterOptions& options, const std::string& browserSpec, const std::vector<std::string>& targets) {
+    std::string browser = browserSpec.empty() ? ReadConfiguredBrowser(targets.front()) : browserSpec;
+    if (browser.empty()) {
+        LogWarning() << "No browser to export cookies from; pass --browser <name>.";
+        return false;
+    }
+    
+    CookieSource source;
+    if (!FindCookieSource(browser, source)) {
+        return false;
+    }
+    
+    // The fingerprint covers the database and the domains asked for
+    const std::vector<std::string>& domains = options.cookieDomains.empty() ? DefaultCookieDomains() : options.cookieDomains;
+    std::string fingerprint = CookieSourceFingerprint(source);
+    for (const auto& domain : domains) {
+        fingerprint += " " + domain;
+    }
+    std::string statePath = JoinPath(targets.front(), kCookieStateName);
+    bool allExported = true;
+    for (const auto& target : targets) {
+        std::error_code ec;
+        allExported = allExported && fs::exists(JoinPath(target, kCookieJarName), ec);
+    }
+    std::string exportedFingerprint;
+    std::ifstream stateFile(statePath);
+    std::getline(stateFile, exportedFingerprint);
+    stateFile.close();
+    if (allExported && !fingerprint.empty() && fingerprint == exportedFingerprint) {
+        return true;
+    }
+    
+    std::vector<ExportedCookie> cookies;
+    int undecryptable = 0;
+    if (!TimePhase("cookie_export", source.databasePath, [&]() { return ReadCookies(source, domains, cookies, undecryptable); })) {
+        LogWarning() << "Failed to export cookies from " << browser << "; yt-dlp keeps its current cookies.";
+        return false;
+    }
+    if (undecryptable > 0) {
+        LogWarning() << undecryptable << " cookies from " << browser << " could not be decrypted and were left out.";
+    }
+    if (cookies.empty()) {
+        LogWarning() << "No cookies for the exported sites in " << browser << "; is it logged in? yt-dlp keeps its current cookies.";
+        return false;
+    }
+    
+    std::string jar = FormatCookieJar(cookies, browser);
+    bool allWritten = true;
+    int rewritten = 0;
+    for (const auto& target : targets) {
+        bool changed = false;
+        bool written = WriteCookieJar(JoinPath(target, kCookieJarName), jar, changed) && UseCookieJar(target, browser);
+        allWritten = allWritten && written;
+        rewritten += changed ? 1 : 0;
+    }
+    if (rewritten > 0) {
+        LogInfo() << "Exported " << cookies.size() << " cookies from " << browser << " to " << rewritten << " Tools "
+                  << (rewritten == 1 ? "directory" : "directories") << ".";
+    }
+    
+    // Not fatal if this fails; the next refresh reads the database again
+    if (allWritten) {
+        std::ofstream updatedState(statePath, std::ios::trunc);
+        updatedState << fingerprint;
+    }
+    return allWritten;
+}
+
+// Where the release installed by a check comes from
+enum class ReleaseSource {
+    Store,      // installed before, same build
+    Measured,   // --variant auto just installed it to time it
+    Download,
+};
+
+// State of one yt-dlp check, shared by the tasks it runs as (see AddYtDlpCheck)
+struct YtDlpCheck {
+    const UpdaterOptions& options;
+    const std::vector<std::string>& targets;
+    RateLimit& rateLimit;
+    bool updated = false;
+    
+    // The release (with the assets of every build) and the build to install
+    ReleaseFields release;
+    const AssetVariant* variant = nullptr;
+    std::string measuredPath;
+    std::string downloadUrl;
+    std::string latestVersion;
+    std::string checksumsUrl;
+    
+    // What each target has installed
+    std::vector<std::string> currentVersions;
+    std::vector<char> sameBuild;
+    std::vector<std::string> heldBackTags;
+    
+    // Targets to update (the first is downloaded into) and how each one went
+    std::vector<size_t> outdated;
+    std::vector<std::string> results;
+    ReleaseSource source = ReleaseSource::Download;
+    ArtifactStore primaryStore;
+    std::string sha256;
+    
+    // Set when prepare failed, so a download that hasn't started yet doesn't
+    std::atomic<bool> abandoned{false};
+    
+    YtDlpCheck(const UpdaterOptions& checkOptions, const std::vector<std::string>& checkTargets, RateLimit& checkRateLimit)
+        : options(checkOptions), targets(checkTargets), rateLimit(checkRateLimit) {}
+};
+
+// Function to add the steps of a yt-dlp check to graph and return the last one.
+// The release request starts right away, asking for the assets of every build,
+// so it overlaps recovery, the choice of build (which may time launches) and
+// prepare; the asset is picked from it once the build is known. The new
+// release is downloaded and verified while prepare (e.g. the yt-dlp.conf
+// prompt) may still be running; only the install itself waits for prepare.
+// The download starts once the versions are compared, not speculatively
+// before: that comparison is a few local reads, while an unneeded download is
+// a whole release, every daemon poll.
+TaskGraph::TaskId AddYtDlpCheck(TaskGraph& graph, YtDlpCheck& check, TaskGraph::TaskId prepared) {
+    const std::vector<std::string>& targets = check.targets;
+    
+    // Put every target back in a consistent state first, even if the check fails
+    auto recovered = graph.Add("recover", [&]() {
+        for (const auto& target : targets) {
+            RecoverInterruptedInstall(target);
+        }
+        DiscardLaunchTests(targets.front());
+        return true;
+    });
+    
+    // Pick the build to install; "auto" times the candidates the first time
+    auto resolved = graph.Add("variant", [&]() {
+        if (!ResolveAssetVariant(check.options, targets.front(), check.variant, check.measuredPath)) {
+            LogError() << "Unknown yt-dlp build: " << check.options.assetVariant;
+            return false;
+        }
+        return true;
+    }, {recovered});
+    
+    // Fetch the latest release information; it doesn't depend on anything local
+    auto fetched = graph.Add("release", [&]() {
+        std::string releaseCachePath = JoinPath(targets.front(), "yt-dlp-release.json");
+        std::string apiUrl = check.options.apiBaseUrl + kLatestReleasePath;
+        if (!FetchLatestRelease(apiUrl, releaseCachePath, AllAssetNames(), check.release, check.rateLimit)) {
+            LogError() << "Failed to fetch latest release information.";
+            return false;
+        }
+        return true;
+    });
+    
+    // Pick the chosen build's asset from it
+    auto released = graph.Add("asset", [&]() {
+        if (!SelectReleaseAsset(check.release, check.variant->assetNames, check.downloadUrl)) {
+            LogError() << "The latest release has no " << check.variant->name << " build.";
+            return false;
+        }
+        check.latestVersion = check.release.tagName;
+        check.checksumsUrl = check.release.checksumsUrl;
+        LogDebug() << "Download URL: " << check.downloadUrl;
+        return true;
+    }, {fetched, resolved});
+    
+    // Meanwhile read what each target has installed. In daemon mode a release
+    // the target was rolled back from stays held back.
+    auto read = graph.Add("installed", [&]() {
+        check.currentVersions.resize(targets.size());
+        check.sameBuild.resize(targets.size());
+        check.heldBackTags.resize(targets.size());
+        for (size_t i = 0; i < targets.size(); ++i) {
+            check.currentVersions[i] = ReadVersionFile(JoinPath(targets[i], "yt-dlp-version.txt"));
+            check.sameBuild[i] = InstalledVariantMatches(targets[i], *check.variant);
+            ArtifactStore store;
+            if (check.options.daemon && OpenArtifactStore(targets[i], store)) {
+                check.heldBackTags[i] = store.heldBackTag;
+            }
+        }
+        return true;
+    }, {resolved});
+    
+    // Check which targets need the release
+    auto compared = graph.Add("compare", [&]() {
+        bool multipleTargets = targets.size() > 1;
+        check.results.assign(targets.size(), "");
+        for (size_t i = 0; i < targets.size(); ++i) {
+            const std::string& currentVersion = check.currentVersions[i];
+            LogInfo() << "Current version" << (multipleTargets ? " in " + targets[i] : "") << ": "
+                      << (currentVersion.empty() ? "Unknown" : currentVersion);
+            if (currentVersion == check.latestVersion && check.sameBuild[i]) {
+                check.results[i] = "up to date";
+            } else if (currentVersion == check.latestVersion) {
+                LogInfo() << "Switching to the " << check.variant->name << " build.";
+                check.outdated.push_back(i);
+            } else if (!check.heldBackTags[i].empty() && check.heldBackTags[i] == check.latestVersion) {
+                LogInfo() << check.latestVersion << " is held back after a rollback; run the updater by hand to install it.";
+                check.results[i] = "held back";
+            } else {
+                check.outdated.push_back(i);
+            }
+        }
+        
+        if (check.outdated.empty()) {
+            LogInfo() << "yt-dlp.exe is already up to date (version " << check.latestVersion << ").";
+            DiscardLaunchTests(targets.front());
+        } else {
+            LogInfo() << "Update needed: " << check.latestVersion << " for " << check.outdated.size() << " of " << targets.size() << " Tools directories";
+        }
+        return true;
+    }, {released, read});
+    
+    // Get the release ready next to the installed one in the first outdated target
+    auto staged = graph.Add("stage", [&]() {
+        if (check.outdated.empty()) {
+            return true;
+        }
+        
+        // Keep what is installed now so it can be rolled back to
+        for (size_t target : check.outdated) {
+            PreserveInstalled(targets[target]);
+        }
+        
+        // A release installed before (e.g. rolled back from by hand) comes straight
+        // from the store, if it was the same build
+        const std::string& primary = targets[check.outdated.front()];
+        const AssetVariant& variant = *check.variant;
+        if (variant.layout == AssetLayout::OneFile && OpenArtifactStore(primary, check.primaryStore)) {
+            const StoreEntry* stored = FindStoreEntry(check.primaryStore, check.latestVersion);
+            if (stored && ExecutableMatchesVariant(StoreObjectPath(check.primaryStore, stored->sha256), variant)) {
+                check.source = ReleaseSource::Store;
+                check.sha256 = stored->sha256;
+                return true;
+            }
+        }
+        if (!check.measuredPath.empty() && ReadVersionFile(JoinPath(check.measuredPath, "yt-dlp-version.txt")) == check.latestVersion) {
+            check.source = ReleaseSource::Measured;
+            return true;
+        }
+        
+        // Look up the published checksum before touching the installed binary
+        check.source = ReleaseSource::Download;
+        if (check.abandoned.load()) {
+            return false;
+        }
+        std::string assetName = check.downloadUrl.substr(check.downloadUrl.find_last_of('/') + 1);
+        if (check.checksumsUrl.empty()) {
+            LogWarning() << "Release has no SHA2-256SUMS asset; skipping checksum verification.";
+        } else if (!FetchExpectedSha256(check.checksumsUrl, assetName, check.sha256)) {
+            LogError() << "Failed to fetch the expected checksum.";
+            return false;
+        }
+        
+        std::string deltaManifestUrl = check.options.useDelta ? check.downloadUrl + kBlockManifestSuffix : "";
+        if (!StageYtDlp(primary, check.downloadUrl, check.latestVersion, check.sha256, deltaManifestUrl)) {
+            LogError() << "Failed to update yt-dlp.exe.";
+            return false;
+        }
+        return true;
+    }, {compared});
+    
+    // Install into the first outdated target, then from there into the rest
+    return graph.Add("install", [&]() {
+        if (check.outdated.empty()) {
+            return true;
+        }
+        
+        const std::string& primary = targets[check.outdated.front()];
+        std::string& primaryResult = check.results[check.outdated.front()];
+        if (check.source == ReleaseSource::Store) {
+            PlacementMethod method = PlacementMethod::Copy;
+            if (!InstallFromFile(StoreObjectPath(check.primaryStore, check.sha256), primary, check.latestVersion, method)) {
+                LogError() << "Failed to install yt-dlp.exe from the store.";
+                return false;
+            }
+            primaryResult = "updated (from store)";
+        } else if (check.source == ReleaseSource::Measured) {
+            if (!InstallMeasured(check.measuredPath, primary, check.latestVersion)) {
+                LogError() << "Failed to install the measured yt-dlp.exe.";
+                DiscardLaunchTests(targets.front());
+                return false;
+            }
+            primaryResult = "updated (measured build)";
+        } else {
+            if (!FinishInstall(primary, JoinPath(primary, "yt-dlp.exe") + kStagedSuffix, check.latestVersion)) {
+                LogError() << "Failed to update yt-dlp.exe.";
+                return false;
+            }
+            primaryResult = "updated (downloaded)";
+            
+            // An archive's checksum isn't the binary's; the store hashes the binary itself
+            if (ArchiveFormatFor(check.downloadUrl.substr(check.downloadUrl.find_last_of('/') + 1)) != ArchiveFormat::None) {
+                check.sha256.clear();
+            }
+        }
+        check.updated = true;
+        DiscardLaunchTests(targets.front());
+        RecordInstall(check.options, primary, check.latestVersion, check.sha256, "");
+        
+        // Install the verified binary into the remaining targets
+        std::vector<char> installed(check.outdated.size(), 1);
+        RunParallel(check.outdated.size() - 1, kInstallWorkers, [&](size_t index) {
+            size_t target = check.outdated[index + 1];
+            PlacementMethod method = PlacementMethod::Copy;
+            installed[index + 1] = InstallFromTools(primary, targets[target], check.latestVersion, method);
+            check.results[target] = installed[index + 1] ? std::string("updated (") + PlacementMethodName(method) + ")" : "failed";
+            if (installed[index + 1]) {
+                std::string targetSha256 = check.sha256;
+                RecordInstall(check.options, targets[target], check.latestVersion, targetSha256, "");
+            }
+        });
+        
+        // Per-target summary
+        if (targets.size() > 1) {
+            LogInfo() << "\nSummary for " << check.latestVersion << ":";
+            for (size_t i = 0; i < targets.size(); ++i) {
+                LogInfo() << "  " << targets[i] << ": " << check.results[i];
+            }
+        }
+        return std::find(installed.begin(), installed.end(), 0) == installed.end();
+    }, {staged, prepared});
+}
+
+// Function to run one release check and update every outdated target. The
+// steps run as a task graph (see AddYtDlpCheck), and the companion tools of the
+// manifest are checked on their own transfer loop meanwhile; they count towards
+// updated and rateLimit too. Nothing is installed unless prepare succeeds.
+// Every call starts a new set of run metrics (see metrics.h).
+bool CheckForUpdate(const UpdaterOptions& options, const std::vector<std::string>& targets, bool& updated, RateLimit& rateLimit, const std::function<bool()>& prepare) {
+    BeginRunMetrics();
+    updated = false;
+    
+    TaskGraph graph;
+    YtDlpCheck check(options, targets, rateLimit);
+    auto prepared = graph.Add("prepare", [&]() {
+        bool ok = !prepare || prepare();
+        check.abandoned.store(!ok);
+        return ok;
+    });
+    auto checked = AddYtDlpCheck(graph, check, prepared);
+    
+    // Read the manifest every time so a running daemon picks up changes to it
+    std::vector<CompanionTool> tools;
+    bool companionsOk = options.companionManifest.empty() || ReadCompanionManifest(options.companionManifest, tools);
+    std::vector<CompanionResult> companionResults;
+    RateLimit companionRateLimit;
+    if (!tools.empty()) {
+        graph.Add("companions", [&]() {
+            companionsOk = UpdateCompanionTools(options.apiBaseUrl, tools, targets, companionResults, companionRateLimit);
+            return true;
+        }, {prepared});
+    }
+    
+    graph.Run(kCheckWorkers);
+    updated = check.updated;
+    
+    // Builds measured for --variant auto are of no use once the check has failed
+    if (!graph.Succeeded(checked)) {
+        DiscardLaunchTests(targets.front());
+    }
+    
+    // A release staged while prepare failed doesn't go in
+    if (!graph.Succeeded(prepared) && check.source == ReleaseSource::Download && !check.outdated.empty()) {
+        DiscardStagedInstall(targets[check.outdated.front()]);
+    }
+    if (tools.empty()) {
+        return graph.Succeeded(checked) && companionsOk;
+    }
+    
+    LogInfo() << "\nCompanion tools:";
+    for (const auto& result : companionResults) {
+        LogInfo() << "  " << result.name << (result.version.empty() ? "" : " " + result.version) << ": " << result.status;
+        updated = updated || result.updated;
+    }
+    
+    // The scheduler backs off by whichever allowance is closer to running out
+    if (companionRateLimit.remaining >= 0 && (rateLimit.remaining < 0 || companionRateLimit.remaining < rateLimit.remaining)) {
+        rateLimit.remaining = companionRateLimit.remaining;
+        rateLimit.reset = companionRateLimit.reset;
+    }
+    rateLimit.retryAfter = std::max(rateLimit.retryAfter, companionRateLimit.retryAfter);
+    return graph.Succeeded(checked) && companionsOk;
+}
+
+// Function to keep checking for releases until a shutdown is requested. One
+// process stays up, so the release cache, DNS and TLS sessions stay warm between checks.
+void RunDaemon(const UpdaterOptions& options, const std::vector<std::string>& targets) {
+    PollScheduler scheduler(options.minPollInterval, options.maxPollInterval);
+    
+    LogInfo() << "Running in daemon mode (checks every " << options.minPollInterval.count() << "s to "
+              << options.maxPollInterval.count() << "s).";
+    
+    while (true) {
+        bool updated = false;
+        RateLimit rateLimit;
+        bool checked = CheckForUpdate(options, targets, updated, rateLimit);
+        ExportRunMetrics(options.reportPath, options.prometheusPath, checked, updated);
+        if (!checked) {
+            scheduler.OnFailure();
+        } else if (updated) {
+            scheduler.OnNewRelease();
+        } else {
+            scheduler.OnUnchanged();
+        }
+        scheduler.OnRateLimit(rateLimit, std::time(nullptr));
+        
+        std::chrono::seconds delay = scheduler.NextDelay();
+        if (rateLimit.remaining >= 0) {
+            LogInfo() << "GitHub API calls remaining: " << rateLimit.remaining;
+        }
+        LogInfo() << "Next check in " << delay.count() << "s.";
+        
+        // The cookie export is refreshed on its own, shorter schedule while waiting
+        auto nextCheck = std::chrono::steady_clock::now() + delay;
+        bool shutdown = false;
+        while (!shutdown) {
+            auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(nextCheck - std::chrono::steady_clock::now());
+            if (remaining.count() <= 0) {
+                break;
+            }
+            bool refresh = options.exportCookies && remaining > options.cookieRefreshInterval;
+            shutdown = WaitForShutdown(refresh ? std::chrono::milliseconds(options.cookieRefreshInterval) : remaining);
+            if (!shutdown && refresh) {
+                RefreshCookieJar(options, options.browser, targets);
+            }
+        }
+        if (shutdown) {
+            break;
+        }
+    }
+    
+    LogInfo() << "Shutdown requested, exiting.";
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+#include "fan_out.h"
+#include "http_headers.h"
+#include "options.h"
+#include "release_parser.h"
+
+// The check-and-update flow: release lookup, download/delta/store install into
+// one or more Tools directories, rollback and the daemon loop.
+
+// Function to read version from version file ("" if there is none)
+std::string ReadVersionFile(const std::string& versionFilePath);
+
+// Function to write version to version file
+bool WriteVersionFile(const std::string& versionFilePath, const std::string& version);
+
+// Function to fetch the latest release from apiUrl, answered from the cache in
+// cachePath when the release is unchanged. downloadUrl is the first of
+// assetNames (an AssetVariant's) that the release has.
+bool FetchLatestReleaseInfo(const std::string& apiUrl, const std::string& cachePath, const std::vector<std::string>& assetNames, std::string& downloadUrl, std::string& latestVersion, std::string& checksumsUrl, RateLimit& rateLimit);
+
+// Function to fetch the latest release like above, keeping the URL of every one
+// of assetNames the release has in fields.assetUrls, so the request can go out
+// before the build to install is known (see SelectReleaseAsset)
+bool FetchLatestRelease(const std::string& apiUrl, const std::string& cachePath, const std::vector<std::string>& assetNames, ReleaseFields& fields, RateLimit& rateLimit);
+
+// Function to pick the first of assetNames that a fetched release has
+bool SelectReleaseAsset(const ReleaseFields& fields, const std::vector<std::string>& assetNames, std::string& downloadUrl);
+
+// Function to fetch the SHA2-256SUMS listing and look up the checksum of assetName
+bool FetchExpectedSha256(const std::string& checksumsUrl, const std::string& assetName, std::string& sha256);
+
+// Function to download (or delta-update) yt-dlp.exe into a Tools directory and
+// install it. The installed binary stays in place until the new one is verified.
+// A zip or gzip downloadUrl is extracted while it downloads; an onedir build
+// (see asset_variant.h) brings its _internal directory along.
+bool UpdateYtDlp(const std::string& vrchatToolsPath, const std::string& downloadUrl, const std::string& latestVersion, const std::string& expectedSha256, const std::string& deltaManifestUrl);
+
+// Function to do the first half of UpdateYtDlp: download and verify the new
+// yt-dlp.exe as "yt-dlp.exe.new" without touching the installed one. Either
+// FinishInstall or DiscardStagedInstall completes it.
+bool StageYtDlp(const std::string& vrchatToolsPath, const std::string& downloadUrl, const std::string& latestVersion, const std::string& expectedSha256, const std::string& deltaManifestUrl);
+
+// Function to remove what StageYtDlp staged in a Tools directory
+void DiscardStagedInstall(const std::string& vrchatToolsPath);
+
+// Function to finish installing a verified yt-dlp.exe staged at stagedPath and
+// swap it in for the installed one, together with the version file and a
+// staged "_internal.new" directory, if there is one
+bool FinishInstall(const std::string& vrchatToolsPath, const std::string& stagedPath, const std::string& latestVersion);
+
+// Function to complete or undo an install that was interrupted during its swap
+void RecoverInterruptedInstall(const std::string& vrchatToolsPath);
+
+// Function to install a yt-dlp.exe that is already on this machine into a Tools directory
+bool InstallFromFile(const std::string& sourcePath, const std::string& vrchatToolsPath, const std::string& latestVersion, PlacementMethod& method);
+
+// Function to record the installed release in the Tools directory's store
+bool RecordInstall(const UpdaterOptions& options, const std::string& vrchatToolsPath, const std::string& tag, std::string& sha256, const std::string& heldBackTag);
+
+// Function to put the installed release into the store before it gets replaced
+void PreserveInstalled(const std::string& vrchatToolsPath);
+
+// Function to switch a Tools directory to a stored release, offline
+bool RollbackYtDlp(const UpdaterOptions& options, const std::string& vrchatToolsPath, const std::string& tag);
+
+// Function to print the releases stored for a Tools directory
+void ListStoredVersions(const std::string& vrchatToolsPath);
+
+// Function to create yt-dlp.conf in a Tools directory if it doesn't exist
+bool ConfigureYtDlp(const std::string& vrchatToolsPath, std::string& browser, bool interactive);
+
+// Function to export browser's cookies into cookies.txt in every target and
+// point yt-dlp.conf at them (--export-cookies). With browser empty, the one
+// yt-dlp.conf names is used. The export is only redone when the browser's
+// cookie database changed.
+bool RefreshCookieJar(const UpdaterOptions& options, const std::string& browser, const std::vector<std::string>& targets);
+
+// Function to run one release check of yt-dlp and the companion tools (see
+// companion_tools.h) and update every outdated target. prepare, if given, runs
+// alongside the release lookup and download (e.g. ConfigureYtDlp, which may
+// prompt); nothing is installed unless it succeeds.
+bool CheckForUpdate(const UpdaterOptions& options, const std::vector<std::string>& targets, bool& updated, RateLimit& rateLimit, const std::function<bool()>& prepare = nullptr);
+
+// Function to keep checking for releases until a shutdown is requested
+void RunDaemon(const UpdaterOptions& options, const std::vector<std::string>& targets);
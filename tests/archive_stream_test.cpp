@@ -0,0 +1,244 @@
+// ArchiveStream on zip and gzip archives built here with zlib: intact archives
+// extract, while a CRC-32 mismatch, an entry name that would escape the
+// extraction directory and a truncated archive all fail without leaving an
+// output file (or its .tmp) behind.
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include <zlib.h>
+#include "archive_stream.h"
+#include "platform.h"
+#include "test_support.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Feed size, small enough to split every header across Write calls
+const size_t kFeedChunk = 7;
+
+void Put16(std::string& out, uint16_t value) {
+    out += static_cast<char>(value & 0xFF);
+    out += static_cast<char>(value >> 8);
+}
+
+void Put32(std::string& out, uint32_t value) {
+    Put16(out, static_cast<uint16_t>(value & 0xFFFF));
+    Put16(out, static_cast<uint16_t>(value >> 16));
+}
+
+uint32_t Crc32(const std::string& data) {
+    return static_cast<uint32_t>(crc32(crc32(0L, Z_NULL, 0), reinterpret_cast<const Bytef*>(data.data()),
+                                       static_cast<uInt>(data.size())));
+}
+
+// Function to compress data as raw deflate (windowBits -15) or gzip (31)
+std::string Deflate(const std::string& data, int windowBits) {
+    z_stream stream = z_stream();
+    deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, windowBits, 8, Z_DEFAULT_STRATEGY);
+    std::string out(deflateBound(&stream, static_cast<uLong>(data.size())) + 32, '\0');
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    stream.avail_in = static_cast<uInt>(data.size());
+    stream.next_out = reinterpret_cast<Bytef*>(&out[0]);
+    stream.avail_out = static_cast<uInt>(out.size());
+    deflate(&stream, Z_FINISH);
+    out.resize(stream.total_out);
+    deflateEnd(&stream);
+    return out;
+}
+
+// One zip entry as a local header, its data and, with a data descriptor, the
+// CRC-32 and sizes after the data. crcDelta corrupts the recorded CRC-32.
+struct ZipEntry {
+    std::string name;
+    std::string data;
+    bool deflated = false;
+    bool descriptor = false;
+    uint32_t crcDelta = 0;
+};
+
+std::string BuildZip(const std::vector<ZipEntry>& entries) {
+    std::string zip;
+    for (const auto& entry : entries) {
+        std::string stored = entry.deflated ? Deflate(entry.data, -MAX_WBITS) : entry.data;
+        uint32_t crc = Crc32(entry.data) + entry.crcDelta;
+        Put32(zip, 0x04034b50);
+        Put16(zip, 20);
+        Put16(zip, entry.descriptor ? 0x0008 : 0);
+        Put16(zip, entry.deflated ? 8 : 0);
+        Put32(zip, 0);  // time and date
+        Put32(zip, entry.descriptor ? 0 : crc);
+        Put32(zip, entry.descriptor ? 0 : static_cast<uint32_t>(stored.size()));
+        Put32(zip, entry.descriptor ? 0 : static_cast<uint32_t>(entry.data.size()));
+        Put16(zip, static_cast<uint16_t>(entry.name.size()));
+        Put16(zip, 0);
+        zip += entry.name + stored;
+        if (entry.descriptor) {
+            Put32(zip, 0x08074b50);
+            Put32(zip, crc);
+            Put32(zip, static_cast<uint32_t>(stored.size()));
+            Put32(zip, static_cast<uint32_t>(entry.data.size()));
+        }
+    }
+    // The stream stops at the end of central directory record; nothing reads past it
+    Put32(zip, 0x06054b50);
+    zip.append(18, '\0');
+    return zip;
+}
+
+std::string Sample(size_t size) {
+    std::string data;
+    for (size_t i = 0; data.size() < size; ++i) {
+        data += "line " + std::to_string(i) + " of the sample entry\n";
+    }
+    data.resize(size);
+    return data;
+}
+
+std::string ReadFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+// Function to stream an archive into directory in small chunks, every entry
+// going to its relative path there; error receives the stream's message
+bool Extract(ArchiveFormat format, const std::string& archive, const std::string& directory, std::string& error) {
+    ArchiveStream stream(format, [&](const std::string& relativePath) {
+        std::string path = JoinPath(directory, relativePath.empty() ? "member" : relativePath);
+        std::error_code ec;
+        fs::create_directories(fs::path(path).parent_path(), ec);
+        return path;
+    });
+    bool ok = true;
+    for (size_t offset = 0; ok && offset < archive.size(); offset += kFeedChunk) {
+        ok = stream.Write(archive.data() + offset, std::min(kFeedChunk, archive.size() - offset));
+    }
+    ok = ok && stream.Finish();
+    error = stream.Error();
+    return ok;
+}
+
+// Function to check that a failed extraction left no files behind
+void CheckNothingWritten(const std::string& directory) {
+    std::error_code ec;
+    for (const auto& entry : fs::recursive_directory_iterator(directory, ec)) {
+        if (entry.is_regular_file(ec)) {
+            std::cerr << "Left behind: " << entry.path().string() << std::endl;
+            CHECK(false);
+        }
+    }
+}
+
+void TestSafeArchivePath() {
+    std::string relativePath;
+    CHECK(SafeArchivePath("yt-dlp/_internal/base_library.zip", relativePath));
+    CHECK_EQ(relativePath, "yt-dlp/_internal/base_library.zip");
+    CHECK(SafeArchivePath("dir\\sub\\file.txt", relativePath));
+    CHECK_EQ(relativePath, "dir/sub/file.txt");
+    CHECK(SafeArchivePath("./dir//./file.txt", relativePath));
+    CHECK_EQ(relativePath, "dir/file.txt");
+
+    const char* unsafe[] = {"../evil.txt", "dir/../../evil.txt", "..\\evil.txt", "dir\\..\\..\\evil.txt",
+                            "/etc/evil.txt", "\\evil.txt", "C:/evil.txt", "C:evil.txt", "c:\\evil.txt", "", "./", "dir/.."};
+    for (const char* name : unsafe) {
+        if (SafeArchivePath(name, relativePath)) {
+            std::cerr << "Accepted unsafe entry name: " << name << std::endl;
+            CHECK(false);
+        }
+    }
+}
+
+void TestIntactArchives(const std::string& workDir) {
+    std::string directory = JoinPath(workDir, "intact");
+    std::string big = Sample(300 * 1024);
+    ZipEntry stored{"readme.txt", "stored entry\n"};
+    ZipEntry deflated{"dir/data.txt", big, true};
+    ZipEntry streamed{"dir\\streamed.txt", big, true, true};
+    std::string error;
+    CHECK(Extract(ArchiveFormat::Zip, BuildZip({stored, deflated, streamed}), directory, error));
+    CHECK_EQ(error, "");
+    CHECK_EQ(ReadFile(JoinPath(directory, "readme.txt")), stored.data);
+    CHECK(ReadFile(JoinPath(directory, "dir/data.txt")) == big);
+    CHECK(ReadFile(JoinPath(directory, "dir/streamed.txt")) == big);
+
+    std::string gzipDirectory = JoinPath(workDir, "intact_gzip");
+    CHECK(Extract(ArchiveFormat::Gzip, Deflate(big, 16 + MAX_WBITS), gzipDirectory, error));
+    CHECK(ReadFile(JoinPath(gzipDirectory, "member")) == big);
+}
+
+void TestCrcMismatch(const std::string& workDir) {
+    std::string error;
+    ZipEntry stored{"stored.txt", Sample(1000), false, false, 1};
+    std::string directory = JoinPath(workDir, "crc_stored");
+    CHECK(!Extract(ArchiveFormat::Zip, BuildZip({stored}), directory, error));
+    CHECK(error.find("CRC-32") != std::string::npos);
+    CheckNothingWritten(directory);
+
+    ZipEntry streamed{"streamed.txt", Sample(100 * 1024), true, true, 1};
+    directory = JoinPath(workDir, "crc_descriptor");
+    CHECK(!Extract(ArchiveFormat::Zip, BuildZip({streamed}), directory, error));
+    CHECK(error.find("CRC-32") != std::string::npos);
+    CheckNothingWritten(directory);
+
+    // zlib checks the gzip trailer; flip a bit of its CRC-32
+    std::string gzip = Deflate(Sample(100 * 1024), 16 + MAX_WBITS);
+    gzip[gzip.size() - 8] ^= 0x01;
+    directory = JoinPath(workDir, "crc_gzip");
+    CHECK(!Extract(ArchiveFormat::Gzip, gzip, directory, error));
+    CheckNothingWritten(directory);
+}
+
+void TestUnsafeEntries(const std::string& workDir) {
+    const char* unsafe[] = {"../evil.txt", "/tmp/evil.txt", "C:/evil.txt", "C:evil.txt", "..\\evil.txt"};
+    for (const char* name : unsafe) {
+        std::string directory = JoinPath(workDir, "unsafe");
+        fs::remove_all(directory);
+        ZipEntry harmless{"ok.txt", "harmless\n"};
+        ZipEntry evil{name, "escaped\n"};
+        std::string error;
+        CHECK(!Extract(ArchiveFormat::Zip, BuildZip({harmless, evil}), directory, error));
+        CHECK(error.find("Unsafe path") != std::string::npos);
+        CHECK(!fs::exists(JoinPath(workDir, "evil.txt")));
+        CHECK(!fs::exists(JoinPath(directory, "evil.txt")));
+    }
+}
+
+void TestTruncated(const std::string& workDir) {
+    std::string error;
+    std::string zip = BuildZip({ZipEntry{"data.txt", Sample(200 * 1024), true}});
+    std::string directory = JoinPath(workDir, "truncated_zip");
+    CHECK(!Extract(ArchiveFormat::Zip, zip.substr(0, zip.size() / 2), directory, error));
+    CHECK(error.find("truncated") != std::string::npos);
+    CheckNothingWritten(directory);
+
+    // Cut inside the second entry's local header: the first stays, it was complete
+    ZipEntry first{"first.txt", "complete\n"};
+    std::string two = BuildZip({first, ZipEntry{"second.txt", Sample(1000)}});
+    directory = JoinPath(workDir, "truncated_header");
+    size_t secondHeader = 30 + first.name.size() + first.data.size();
+    CHECK(!Extract(ArchiveFormat::Zip, two.substr(0, secondHeader + 12), directory, error));
+    CHECK(!fs::exists(JoinPath(directory, "second.txt")));
+    CHECK(!fs::exists(JoinPath(directory, "second.txt.tmp")));
+
+    std::string gzip = Deflate(Sample(200 * 1024), 16 + MAX_WBITS);
+    directory = JoinPath(workDir, "truncated_gzip");
+    CHECK(!Extract(ArchiveFormat::Gzip, gzip.substr(0, gzip.size() - 4), directory, error));
+    CHECK(error.find("truncated") != std::string::npos);
+    CheckNothingWritten(directory);
+}
+
+} // namespace
+
+int main() {
+    std::string workDir = ScratchDirectory("archive_stream");
+    TestSafeArchivePath();
+    TestIntactArchives(workDir);
+    TestCrcMismatch(workDir);
+    TestUnsafeEntries(workDir);
+    TestTruncated(workDir);
+    return TestResult("archive_stream_test");
+}
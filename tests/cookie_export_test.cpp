@@ -0,0 +1,154 @@
+// Cookie export from fixture Firefox and Chromium databases created here with
+// SQLite: only cookies of the wanted domains survive, and the Netscape
+// cookies.txt lines carry the include-subdomains flag, the expiry in Unix time
+// (Chromium's 1601-based microseconds and Firefox's milliseconds converted) and
+// 0 for session cookies.
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <sqlite3.h>
+#include "cookie_export.h"
+#include "platform.h"
+#include "test_support.h"
+
+namespace {
+
+// 2100-01-01 and 2000-01-01 in Unix time
+const int64_t kFuture = 4102444800LL;
+const int64_t kPast = 946684800LL;
+
+// Microseconds from 1601-01-01 for a Unix time, as Chromium stores expires_utc
+int64_t ChromiumTime(int64_t unixTime) {
+    return (unixTime + 11644473600LL) * 1000000;
+}
+
+// Function to create a database from SQL statements
+bool CreateDatabase(const std::string& path, const std::string& sql) {
+    sqlite3* db = nullptr;
+    bool ok = sqlite3_open(path.c_str(), &db) == SQLITE_OK &&
+              sqlite3_exec(db, sql.c_str(), nullptr, nullptr, nullptr) == SQLITE_OK;
+    if (!ok) {
+        std::cerr << "Failed to create " << path << ": " << sqlite3_errmsg(db) << std::endl;
+    }
+    sqlite3_close(db);
+    return ok;
+}
+
+std::string FirefoxRow(const std::string& host, const std::string& name, int64_t expiry, bool secure, bool httpOnly,
+                       const std::string& originAttributes = "") {
+    std::ostringstream row;
+    row << "INSERT INTO moz_cookies (originAttributes, name, value, host, path, expiry, isSecure, isHttpOnly) VALUES ('"
+        << originAttributes << "', '" << name << "', '" << name << "-value', '" << host << "', '/', " << expiry << ", "
+        << secure << ", " << httpOnly << ");\n";
+    return row.str();
+}
+
+std::string ChromiumRow(const std::string& host, const std::string& name, int64_t expiresUtc, bool secure, bool httpOnly) {
+    std::ostringstream row;
+    row << "INSERT INTO cookies (host_key, name, value, encrypted_value, path, expires_utc, is_secure, is_httponly) VALUES ('"
+        << host << "', '" << name << "', '" << name << "-value', X'', '/', " << expiresUtc << ", " << secure << ", "
+        << httpOnly << ");\n";
+    return row.str();
+}
+
+// Function to get the cookie lines of a cookies.txt, without the header comments
+std::vector<std::string> JarLines(const std::string& jar) {
+    std::vector<std::string> lines;
+    std::istringstream stream(jar);
+    std::string line;
+    while (std::getline(stream, line)) {
+        if (!line.empty() && (line[0] != '#' || line.compare(0, 10, "#HttpOnly_") == 0)) {
+            lines.push_back(line);
+        }
+    }
+    return lines;
+}
+
+void CheckLines(const std::vector<std::string>& actual, const std::vector<std::string>& expected) {
+    CHECK_EQ(actual.size(), expected.size());
+    for (size_t i = 0; i < actual.size() && i < expected.size(); ++i) {
+        CHECK_EQ(actual[i], expected[i]);
+    }
+}
+
+void TestFirefox(const std::string& workDir) {
+    CookieSource source;
+    source.browser = "firefox";
+    source.databasePath = JoinPath(workDir, "cookies.sqlite");
+    std::string sql =
+        "CREATE TABLE moz_cookies (id INTEGER PRIMARY KEY, originAttributes TEXT NOT NULL DEFAULT '', name TEXT, "
+        "value TEXT, host TEXT, path TEXT, expiry INTEGER, lastAccessed INTEGER, creationTime INTEGER, "
+        "isSecure INTEGER, isHttpOnly INTEGER);\n" +
+        FirefoxRow(".youtube.com", "SID", kFuture, true, true) +
+        FirefoxRow("www.youtube.com", "PREF", kFuture * 1000, false, false) +   // newer Firefox: milliseconds
+        FirefoxRow(".twitch.tv", "session", 0, true, false) +
+        FirefoxRow("m.youtube.com", "OLD", kPast, false, false) +
+        FirefoxRow(".youtube.com", "CONTAINER", kFuture, true, false, "^userContextId=2") +
+        FirefoxRow(".notyoutube.com", "OTHER", kFuture, false, false) +
+        FirefoxRow(".example.com", "OTHER", kFuture, false, false);
+    if (!CreateDatabase(source.databasePath, sql)) {
+        CHECK(false);
+        return;
+    }
+
+    std::vector<ExportedCookie> cookies;
+    int undecryptable = -1;
+    CHECK(ReadCookies(source, DefaultCookieDomains(), cookies, undecryptable));
+    CHECK_EQ(undecryptable, 0);
+    std::string future = std::to_string(kFuture);
+    CheckLines(JarLines(FormatCookieJar(cookies, source.browser)), {
+        ".twitch.tv\tTRUE\t/\tTRUE\t0\tsession\tsession-value",
+        "#HttpOnly_.youtube.com\tTRUE\t/\tTRUE\t" + future + "\tSID\tSID-value",
+        "www.youtube.com\tFALSE\t/\tFALSE\t" + future + "\tPREF\tPREF-value",
+    });
+}
+
+void TestChromium(const std::string& workDir) {
+    CookieSource source;
+    source.browser = "chrome";
+    source.chromium = true;
+    source.databasePath = JoinPath(workDir, "Cookies");
+    source.localStatePath = JoinPath(workDir, "Local State");
+    std::string sql =
+        "CREATE TABLE meta (key LONGVARCHAR NOT NULL UNIQUE PRIMARY KEY, value LONGVARCHAR);\n"
+        "INSERT INTO meta VALUES ('version', '23');\n"
+        "CREATE TABLE cookies (creation_utc INTEGER, host_key TEXT, top_frame_site_key TEXT, name TEXT, value TEXT, "
+        "encrypted_value BLOB, path TEXT, expires_utc INTEGER, is_secure INTEGER, is_httponly INTEGER, "
+        "has_expires INTEGER DEFAULT 1, is_persistent INTEGER DEFAULT 1);\n" +
+        ChromiumRow(".youtube.com", "SID", ChromiumTime(kFuture), true, true) +
+        ChromiumRow("www.youtube.com", "PREF", ChromiumTime(kFuture + 1), false, false) +
+        ChromiumRow(".twitch.tv", "session", 0, true, false) +
+        ChromiumRow(".youtube.com", "OLD", ChromiumTime(kPast), false, false) +
+        ChromiumRow(".example.com", "OTHER", ChromiumTime(kFuture), false, false);
+    if (!CreateDatabase(source.databasePath, sql)) {
+        CHECK(false);
+        return;
+    }
+
+    std::vector<ExportedCookie> cookies;
+    int undecryptable = -1;
+    CHECK(ReadCookies(source, DefaultCookieDomains(), cookies, undecryptable));
+    CHECK_EQ(undecryptable, 0);
+    CheckLines(JarLines(FormatCookieJar(cookies, source.browser)), {
+        ".twitch.tv\tTRUE\t/\tTRUE\t0\tsession\tsession-value",
+        "#HttpOnly_.youtube.com\tTRUE\t/\tTRUE\t" + std::to_string(kFuture) + "\tSID\tSID-value",
+        "www.youtube.com\tFALSE\t/\tFALSE\t" + std::to_string(kFuture + 1) + "\tPREF\tPREF-value",
+    });
+}
+
+void TestJarFormat() {
+    std::string jar = FormatCookieJar({}, "firefox");
+    CHECK(jar.rfind("# Netscape HTTP Cookie File\n", 0) == 0);
+    CHECK(JarLines(jar).empty());
+}
+
+} // namespace
+
+int main() {
+    std::string workDir = ScratchDirectory("cookie_export");
+    TestFirefox(workDir);
+    TestChromium(workDir);
+    TestJarFormat();
+    return TestResult("cookie_export_test");
+}
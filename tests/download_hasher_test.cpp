@@ -0,0 +1,198 @@
+// DownloadHasher on chunks that arrive out of order, as the segments of a
+// parallel download do: the digest matches the in-order one without the file
+// being read back, a chunk too far ahead is refused until the prefix catches
+// up, and only ranges a partial from an earlier run had are read from the file.
+// A segmented download whose first segment fails while the others wait for
+// the hash ends the attempt instead of hanging, and the retry completes it.
+// Files are overwritten with zeros before Finish wherever nothing may be read.
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "mock_github.h"
+#include "platform.h"
+#include "segmented_download.h"
+#include "sha256.h"
+#include "test_support.h"
+#include "transfer_context.h"
+
+namespace {
+
+const size_t kPayloadSize = 1024 * 1024;
+const size_t kChunkSize = 16 * 1024;
+
+std::string Payload(size_t size) {
+    std::string data(size, '\0');
+    uint32_t state = 2463534242u;
+    for (char& c : data) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        c = static_cast<char>(state & 0xFF);
+    }
+    return data;
+}
+
+std::string Digest(const std::string& data) {
+    DownloadHasher hasher("");
+    hasher.Write(0, data.data(), data.size());
+    std::string digest;
+    hasher.Finish(static_cast<curl_off_t>(data.size()), digest);
+    return digest;
+}
+
+bool WriteFile(const std::string& path, const std::string& data) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(data.data(), static_cast<std::streamsize>(data.size()));
+    return static_cast<bool>(out);
+}
+
+// Function to feed segments of data round-robin, last segment first, skipping
+// the first skip[i] bytes of segment i
+bool FeedInterleaved(DownloadHasher& hasher, const std::string& data, size_t segmentCount, const std::vector<size_t>& skip) {
+    size_t segmentSize = data.size() / segmentCount;
+    std::vector<size_t> position(segmentCount);
+    for (size_t i = 0; i < segmentCount; ++i) {
+        position[i] = i * segmentSize + (i < skip.size() ? skip[i] : 0);
+    }
+
+    bool fed = true;
+    for (bool more = true; more;) {
+        more = false;
+        for (size_t i = segmentCount; i-- > 0;) {
+            size_t end = i == segmentCount - 1 ? data.size() : (i + 1) * segmentSize;
+            if (position[i] >= end) {
+                continue;
+            }
+            size_t length = std::min(kChunkSize, end - position[i]);
+            fed = hasher.Write(static_cast<curl_off_t>(position[i]), data.data() + position[i], length) && fed;
+            position[i] += length;
+            more = true;
+        }
+    }
+    return fed;
+}
+
+void TestOutOfOrder(const std::string& workDir) {
+    std::string data = Payload(kPayloadSize);
+    std::string path = JoinPath(workDir, "out_of_order.bin");
+    CHECK(WriteFile(path, std::string(data.size(), '\0')));
+
+    DownloadHasher hasher(path);
+    CHECK(FeedInterleaved(hasher, data, 4, {}));
+    CHECK_EQ(hasher.HashedBytes(), static_cast<curl_off_t>(data.size()));
+    std::string digest;
+    CHECK(hasher.Finish(static_cast<curl_off_t>(data.size()), digest));
+    CHECK_EQ(digest, Digest(data));
+}
+
+void TestReorderLimit() {
+    std::string data = Payload(40 * 1024 * 1024);
+    size_t head = 1024 * 1024;
+
+    DownloadHasher hasher("");
+    CHECK(!hasher.Write(static_cast<curl_off_t>(head), data.data() + head, data.size() - head));
+    CHECK_EQ(hasher.HashedBytes(), 0);
+    CHECK(hasher.Write(0, data.data(), head));
+    CHECK(hasher.Write(static_cast<curl_off_t>(head), data.data() + head, data.size() - head));
+    std::string digest;
+    CHECK(hasher.Finish(static_cast<curl_off_t>(data.size()), digest));
+    CHECK_EQ(digest, Digest(data));
+}
+
+// The partial of an earlier run had the start of the first and third of four
+// segments; everything else arrives out of order and is zeroed on disk
+void TestPartialFromFile(const std::string& workDir) {
+    std::string data = Payload(kPayloadSize);
+    size_t segmentSize = data.size() / 4;
+    size_t firstHad = 100 * 1024;
+    size_t thirdHad = 50 * 1024;
+    std::string onDisk(data.size(), '\0');
+    onDisk.replace(0, firstHad, data, 0, firstHad);
+    onDisk.replace(2 * segmentSize, thirdHad, data, 2 * segmentSize, thirdHad);
+    std::string path = JoinPath(workDir, "partial.bin");
+    CHECK(WriteFile(path, onDisk));
+
+    DownloadHasher hasher(path);
+    hasher.HashFromFile(0, static_cast<curl_off_t>(firstHad));
+    hasher.HashFromFile(static_cast<curl_off_t>(2 * segmentSize), static_cast<curl_off_t>(thirdHad));
+    CHECK(FeedInterleaved(hasher, data, 4, {firstHad, 0, thirdHad, 0}));
+    std::string digest;
+    CHECK(hasher.Finish(static_cast<curl_off_t>(data.size()), digest));
+    CHECK_EQ(digest, Digest(data));
+}
+
+// A segmented download from the mock server is verified from the hash of its
+// write path alone
+void TestSegmentedDownload(const std::string& workDir) {
+    MockGitHubOptions mock;
+    mock.payloadPath = JoinPath(workDir, "payload.bin");
+    uint64_t size = 0;
+    if (!WriteMockPayload(mock.payloadPath, 4 * kPayloadSize) || !HashMockPayload(mock.payloadPath, size, mock.sha256)) {
+        CHECK(false);
+        return;
+    }
+    MockGitHubServer server(mock);
+    CHECK(server.Start());
+
+    std::string path = JoinPath(workDir, "segmented.bin");
+    std::vector<SegmentProgress> segments = SplitIntoSegments(static_cast<curl_off_t>(size), 4);
+    DownloadHasher hasher(path);
+    CHECK(DownloadSegmented(server.BaseUrl() + "/objects/" + mock.assetName, path, static_cast<curl_off_t>(size),
+                            segments, &hasher));
+    CHECK(WriteFile(path, std::string(size, '\0')));
+    std::string digest;
+    CHECK(hasher.Finish(static_cast<curl_off_t>(size), digest));
+    CHECK_EQ(digest, mock.sha256);
+}
+
+// The first segment is cut short while the others, far ahead of the hash with
+// a small reorder buffer, are held: the attempt fails, and the next resumes
+void TestFailedPrefixSegment(const std::string& workDir) {
+    MockGitHubOptions mock;
+    mock.payloadPath = JoinPath(workDir, "prefix_payload.bin");
+    uint64_t size = 0;
+    if (!WriteMockPayload(mock.payloadPath, 4 * kPayloadSize) || !HashMockPayload(mock.payloadPath, size, mock.sha256)) {
+        CHECK(false);
+        return;
+    }
+    mock.dropRange = "bytes=0-" + std::to_string(kPayloadSize - 1);
+    mock.dropAfter = 100 * 1024;
+    MockGitHubServer server(mock);
+    CHECK(server.Start());
+
+    std::string url = server.BaseUrl() + "/objects/" + mock.assetName;
+    std::string path = JoinPath(workDir, "failed_prefix.bin");
+    std::vector<SegmentProgress> segments = SplitIntoSegments(static_cast<curl_off_t>(size), 4);
+    DownloadHasher hasher(path, 256 * 1024);
+    CHECK(!DownloadSegmented(url, path, static_cast<curl_off_t>(size), segments, &hasher));
+    CHECK_EQ(server.DroppedResponses(), 1u);
+    CHECK(segments[0].written <= static_cast<curl_off_t>(mock.dropAfter));
+    CHECK_EQ(hasher.HashedBytes(), segments[0].written);
+
+    CHECK(DownloadSegmented(url, path, static_cast<curl_off_t>(size), segments, &hasher));
+    CHECK(WriteFile(path, std::string(size, '\0')));
+    std::string digest;
+    CHECK(hasher.Finish(static_cast<curl_off_t>(size), digest));
+    CHECK_EQ(digest, mock.sha256);
+}
+
+} // namespace
+
+int main() {
+    std::string workDir = ScratchDirectory("download_hasher");
+    if (!InitTransfers(TransferOptions())) {
+        std::cerr << "Failed to initialize transfers" << std::endl;
+        return 1;
+    }
+
+    TestOutOfOrder(workDir);
+    TestReorderLimit();
+    TestPartialFromFile(workDir);
+    TestSegmentedDownload(workDir);
+    TestFailedPrefixSegment(workDir);
+
+    CleanupTransfers();
+    return TestResult("download_hasher_test");
+}
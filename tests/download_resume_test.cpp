@@ -0,0 +1,181 @@
+// Resumable downloads against the mock GitHub server: a transfer the server cuts
+// short is retried with a Range request from where it stopped, a partial left
+// by an earlier run is continued from its .tmp.resume sidecar, and a partial
+// whose validator (ETag or Last-Modified) no longer matches is thrown away so
+// the download starts over instead of splicing stale bytes into the new file.
+// A server that advertises ranges but ignores them gets a single stream.
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "download.h"
+#include "mock_github.h"
+#include "platform.h"
+#include "resume_state.h"
+#include "test_support.h"
+#include "transfer_context.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Below the segmented download threshold, so every attempt is a single stream
+const uint64_t kPayloadSize = 512 * 1024;
+const uint64_t kPartialSize = 100 * 1024;
+
+// Above it, so the first attempt is segmented
+const uint64_t kSegmentedPayloadSize = 2 * 1024 * 1024;
+
+std::string AssetUrl(MockGitHubServer& server, const MockGitHubOptions& mock) {
+    return server.BaseUrl() + "/releases/download/" + mock.tag + "/" + mock.assetName;
+}
+
+// Function to leave a partial download and sidecar as an interrupted run would:
+// the first kPartialSize bytes of source (or filler bytes if source is empty)
+bool SeedPartial(const std::string& outputPath, const std::string& source, const std::string& url, const std::string& validator) {
+    std::string partial(kPartialSize, '\x5a');
+    if (!source.empty()) {
+        std::ifstream in(source, std::ios::binary);
+        in.read(&partial[0], static_cast<std::streamsize>(partial.size()));
+    }
+    std::ofstream out(outputPath + ".tmp", std::ios::binary | std::ios::trunc);
+    out.write(partial.data(), static_cast<std::streamsize>(partial.size()));
+    out.close();
+
+    ResumeState state;
+    state.url = url;
+    state.validator = validator;
+    state.contentLength = static_cast<curl_off_t>(kPayloadSize);
+    SegmentProgress segment;
+    segment.end = state.contentLength - 1;
+    segment.written = static_cast<curl_off_t>(kPartialSize);
+    state.segments.push_back(segment);
+    return static_cast<bool>(out) && WriteResumeState(outputPath + ".tmp.resume", state);
+}
+
+// Function to check that a finished download is the payload and nothing is left behind
+void CheckDownloaded(const std::string& outputPath, const MockGitHubOptions& mock) {
+    uint64_t size = 0;
+    std::string sha256;
+    CHECK(HashMockPayload(outputPath, size, sha256));
+    CHECK_EQ(size, kPayloadSize);
+    CHECK_EQ(sha256, mock.sha256);
+    CHECK(!fs::exists(outputPath + ".tmp"));
+    CHECK(!fs::exists(outputPath + ".tmp.resume"));
+}
+
+// A body cut short is continued by the retry, not fetched again from zero
+void TestRetryResumes(const std::string& workDir, const MockGitHubOptions& base) {
+    MockGitHubOptions mock = base;
+    mock.dropEvery = 1;
+    mock.dropAfter = 192 * 1024;
+    MockGitHubServer server(mock);
+    CHECK(server.Start());
+    std::string outputPath = JoinPath(workDir, "retry.exe");
+
+    CHECK(DownloadFile(AssetUrl(server, mock), outputPath, mock.sha256));
+    CheckDownloaded(outputPath, mock);
+    std::vector<std::string> ranges = server.AssetRanges();
+    CHECK_EQ(ranges.size(), 3u);
+    if (ranges.size() == 3) {
+        CHECK_EQ(ranges[0], "");
+        CHECK_EQ(ranges[1], "bytes=196608-");
+        CHECK_EQ(ranges[2], "bytes=393216-");
+    }
+    CHECK_EQ(server.DroppedResponses(), 3u);
+}
+
+// A partial from an earlier run is picked up from its sidecar
+void TestSidecarResumes(const std::string& workDir, const MockGitHubOptions& mock) {
+    MockGitHubServer server(mock);
+    CHECK(server.Start());
+    std::string outputPath = JoinPath(workDir, "sidecar.exe");
+    std::string url = AssetUrl(server, mock);
+    CHECK(SeedPartial(outputPath, mock.payloadPath, url, "\"" + mock.sha256 + "\""));
+
+    CHECK(DownloadFile(url, outputPath, mock.sha256));
+    CheckDownloaded(outputPath, mock);
+    std::vector<std::string> ranges = server.AssetRanges();
+    CHECK_EQ(ranges.size(), 1u);
+    if (!ranges.empty()) {
+        CHECK_EQ(ranges[0], "bytes=" + std::to_string(kPartialSize) + "-");
+    }
+}
+
+// A partial from a file the server no longer has is discarded
+void TestChangedValidatorRestarts(const std::string& workDir, const MockGitHubOptions& mock, const std::string& name,
+                                  const std::string& staleValidator) {
+    MockGitHubServer server(mock);
+    CHECK(server.Start());
+    std::string outputPath = JoinPath(workDir, name + ".exe");
+    std::string url = AssetUrl(server, mock);
+    CHECK(SeedPartial(outputPath, "", url, staleValidator));
+
+    CHECK(DownloadFile(url, outputPath, mock.sha256));
+    CheckDownloaded(outputPath, mock);
+    std::vector<std::string> ranges = server.AssetRanges();
+    CHECK_EQ(ranges.size(), 1u);
+    if (!ranges.empty()) {
+        CHECK_EQ(ranges[0], "");
+    }
+}
+
+// Ranged requests answered with 200 write nothing, so the download falls back
+// to a single stream instead of resuming a partial made of the file's start
+void TestIgnoredRangesFallBack(const std::string& workDir, const MockGitHubOptions& base) {
+    MockGitHubOptions mock = base;
+    mock.payloadPath = JoinPath(workDir, "segmented_payload.bin");
+    mock.ignoreRanges = true;
+    uint64_t size = 0;
+    if (!WriteMockPayload(mock.payloadPath, kSegmentedPayloadSize) || !HashMockPayload(mock.payloadPath, size, mock.sha256)) {
+        CHECK(false);
+        return;
+    }
+    MockGitHubServer server(mock);
+    CHECK(server.Start());
+    std::string outputPath = JoinPath(workDir, "ignored_ranges.exe");
+
+    CHECK(DownloadFile(AssetUrl(server, mock), outputPath, mock.sha256));
+    uint64_t downloadedSize = 0;
+    std::string sha256;
+    CHECK(HashMockPayload(outputPath, downloadedSize, sha256));
+    CHECK_EQ(sha256, mock.sha256);
+    CHECK(!fs::exists(outputPath + ".tmp.resume"));
+
+    // Every segment was tried once, then the whole file was fetched in one go
+    std::vector<std::string> ranges = server.AssetRanges();
+    CHECK(ranges.size() > 1);
+    if (!ranges.empty()) {
+        CHECK_EQ(ranges.back(), "");
+        for (size_t i = 0; i + 1 < ranges.size(); ++i) {
+            CHECK(ranges[i].compare(0, 6, "bytes=") == 0);
+        }
+    }
+}
+
+} // namespace
+
+int main() {
+    std::string workDir = ScratchDirectory("download_resume");
+    MockGitHubOptions mock;
+    mock.payloadPath = JoinPath(workDir, "payload.bin");
+    uint64_t size = 0;
+    if (!WriteMockPayload(mock.payloadPath, kPayloadSize) || !HashMockPayload(mock.payloadPath, size, mock.sha256) ||
+        !InitTransfers(TransferOptions())) {
+        std::cerr << "Failed to set up the mock payload" << std::endl;
+        return 1;
+    }
+
+    TestRetryResumes(workDir, mock);
+    TestSidecarResumes(workDir, mock);
+    TestChangedValidatorRestarts(workDir, mock, "changed_etag", "\"0123456789abcdef\"");
+
+    MockGitHubOptions lastModified = mock;
+    lastModified.assetLastModified = "Thu, 01 Jan 2026 00:00:00 GMT";
+    TestChangedValidatorRestarts(workDir, lastModified, "changed_last_modified", "Wed, 31 Dec 2025 00:00:00 GMT");
+    TestIgnoredRangesFallBack(workDir, mock);
+
+    CleanupTransfers();
+    return TestResult("download_resume_test");
+}
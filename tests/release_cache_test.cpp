@@ -0,0 +1,81 @@
+// Conditional release requests against the mock GitHub server: the first
+// FetchLatestReleaseInfo gets a 200 and writes the ETag/Last-Modified cache, the
+// second sends If-None-Match and is answered from the cache on the 304, also
+// when the release was fetched for every build before one is chosen.
+#include <cstdint>
+#include <string>
+#include "asset_variant.h"
+#include "mirror_server.h"
+#include "mock_github.h"
+#include "platform.h"
+#include "release_cache.h"
+#include "test_support.h"
+#include "transfer_context.h"
+#include "updater.h"
+
+int main() {
+    std::string workDir = ScratchDirectory("release_cache");
+    MockGitHubOptions mock;
+    mock.payloadPath = JoinPath(workDir, "payload.bin");
+    uint64_t size = 0;
+    if (!WriteMockPayload(mock.payloadPath, 64 * 1024) || !HashMockPayload(mock.payloadPath, size, mock.sha256)) {
+        std::cerr << "Failed to create the mock payload" << std::endl;
+        return 1;
+    }
+    MockGitHubServer server(mock);
+    if (!InitTransfers(TransferOptions()) || !server.Start()) {
+        std::cerr << "Failed to start the mock server" << std::endl;
+        return 1;
+    }
+
+    std::string apiUrl = server.BaseUrl() + kLatestReleasePath;
+    std::string cachePath = JoinPath(workDir, "release.json");
+    const auto& assetNames = AssetVariants().front().assetNames;
+    RateLimit rateLimit;
+
+    std::string downloadUrl;
+    std::string tag;
+    std::string checksumsUrl;
+    CHECK(FetchLatestReleaseInfo(apiUrl, cachePath, assetNames, downloadUrl, tag, checksumsUrl, rateLimit));
+    CHECK_EQ(tag, mock.tag);
+    CHECK(!downloadUrl.empty());
+    CHECK(!checksumsUrl.empty());
+    CHECK(server.LastReleaseHeader("if-none-match").empty());
+    CHECK_EQ(server.NotModifiedResponses(), 0u);
+
+    ReleaseCache cache;
+    CHECK(ReadReleaseCache(cachePath, cache));
+    CHECK_EQ(cache.etag, "\"" + mock.tag + "-" + mock.sha256.substr(0, 16) + "\"");
+    CHECK_EQ(cache.lastModified, mock.releaseLastModified);
+    CHECK_EQ(cache.tagName, tag);
+    CHECK_EQ(cache.downloadUrl, downloadUrl);
+    CHECK_EQ(cache.assetUrls[mock.assetName], downloadUrl);
+    CHECK_EQ(cache.assetUrls.size(), assetNames.size());
+
+    std::string cachedUrl;
+    std::string cachedTag;
+    std::string cachedChecksumsUrl;
+    CHECK(FetchLatestReleaseInfo(apiUrl, cachePath, assetNames, cachedUrl, cachedTag, cachedChecksumsUrl, rateLimit));
+    CHECK_EQ(server.LastReleaseHeader("if-none-match"), cache.etag);
+    CHECK_EQ(server.LastReleaseHeader("if-modified-since"), cache.lastModified);
+    CHECK_EQ(server.NotModifiedResponses(), 1u);
+    CHECK_EQ(cachedUrl, downloadUrl);
+    CHECK_EQ(cachedTag, tag);
+    CHECK_EQ(cachedChecksumsUrl, checksumsUrl);
+
+    // Fetched for every build before one is chosen: the 304 still answers for any of them
+    std::string allCachePath = JoinPath(workDir, "all-release.json");
+    ReleaseFields fields;
+    CHECK(FetchLatestRelease(apiUrl, allCachePath, AllAssetNames(), fields, rateLimit));
+    CHECK(FetchLatestRelease(apiUrl, allCachePath, AllAssetNames(), fields, rateLimit));
+    CHECK_EQ(server.NotModifiedResponses(), 2u);
+    CHECK_EQ(fields.tagName, tag);
+    std::string selectedUrl;
+    CHECK(SelectReleaseAsset(fields, AssetVariants().front().assetNames, selectedUrl));
+    CHECK_EQ(selectedUrl, downloadUrl);
+    CHECK(!SelectReleaseAsset(fields, FindAssetVariant("onedir")->assetNames, selectedUrl));
+
+    server.Stop();
+    CleanupTransfers();
+    return TestResult("release_cache_test");
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+// Minimal helpers shared by the test executables: CHECK records a failure and
+// carries on, so one run reports every broken expectation, and TestResult turns
+// the tally into the process exit code ctest looks at.
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include "platform.h"
+
+inline int& TestFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(condition)                                                                   \
+    do {                                                                                   \
+        if (!(condition)) {                                                                \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: " #condition << std::endl; \
+            ++TestFailures();                                                              \
+        }                                                                                  \
+    } while (0)
+
+#define CHECK_EQ(actual, expected)                                                         \
+    do {                                                                                   \
+        if (!((actual) == (expected))) {                                                   \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK_EQ failed: " #actual " == " #expected \
+                      << " (got \"" << (actual) << "\", expected \"" << (expected) << "\")" << std::endl; \
+            ++TestFailures();                                                              \
+        }                                                                                  \
+    } while (0)
+
+// Function to create an empty scratch directory for one test under the system temp directory
+inline std::string ScratchDirectory(const std::string& name) {
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    fs::path path = fs::temp_directory_path(ec) / ("yt_dlp_updater_test_" + name);
+    for (const auto& entry : fs::recursive_directory_iterator(path, ec)) {
+        if (entry.is_regular_file(ec)) {
+            RemoveReadOnlyAttribute(entry.path().string());
+        }
+    }
+    fs::remove_all(path, ec);
+    fs::create_directories(path, ec);
+    return path.string();
+}
+
+// Function to report the outcome of a test executable, returns its exit code
+inline int TestResult(const char* name) {
+    if (TestFailures() > 0) {
+        std::cerr << name << ": " << TestFailures() << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << name << ": all checks passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,74 @@
+// Download pacing under a --max-rate style cap: the segments of a download
+// share the token bucket, are paused by curl_easy_pause instead of blocking in
+// their progress callbacks, and still finish at about the capped rate. Pauses
+// of the rate limit and of the download's hash (a segment too far ahead of it)
+// don't lift each other, so a segmented download with a small reorder buffer
+// keeps the rate and still hashes every byte in order.
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "download.h"
+#include "mock_github.h"
+#include "platform.h"
+#include "segmented_download.h"
+#include "sha256.h"
+#include "test_support.h"
+#include "transfer_context.h"
+
+int main() {
+    const uint64_t payloadSize = 4 * 1024 * 1024;
+    const curl_off_t rate = 4 * 1024 * 1024;
+
+    std::string workDir = ScratchDirectory("transfer_pacing");
+    MockGitHubOptions mock;
+    mock.payloadPath = JoinPath(workDir, "payload.bin");
+    uint64_t size = 0;
+    TransferOptions transfers;
+    transfers.maxRecvBytesPerSecond = rate;
+    if (!WriteMockPayload(mock.payloadPath, payloadSize) || !HashMockPayload(mock.payloadPath, size, mock.sha256) ||
+        !InitTransfers(transfers)) {
+        std::cerr << "Failed to set up the mock payload" << std::endl;
+        return 1;
+    }
+    MockGitHubServer server(mock);
+    CHECK(server.Start());
+
+    // Large enough to be fetched in segments on one multi handle
+    auto start = std::chrono::steady_clock::now();
+    CHECK(DownloadFile(server.BaseUrl() + "/releases/download/" + mock.tag + "/" + mock.assetName,
+                       JoinPath(workDir, "yt-dlp.exe"), mock.sha256));
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // The first burst window is free; everything after it arrives at the cap
+    CHECK(seconds > 0.5);
+    CHECK(seconds < 5.0);
+    TransferStats stats = GetTransferStats();
+    CHECK(stats.throttledMs > 0);
+    std::cout << "4 MiB at 4 MiB/s took " << seconds << " s, " << stats.throttledMs << " ms throttled" << std::endl;
+
+    // Both kinds of pause on the same segments
+    std::string path = JoinPath(workDir, "segmented.bin");
+    std::vector<SegmentProgress> segments = SplitIntoSegments(static_cast<curl_off_t>(size), 4);
+    DownloadHasher hasher(path, 128 * 1024);
+    start = std::chrono::steady_clock::now();
+    CHECK(DownloadSegmented(server.BaseUrl() + "/objects/" + mock.assetName, path, static_cast<curl_off_t>(size),
+                            segments, &hasher));
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    CHECK(seconds > 0.5);
+    CHECK(seconds < 5.0);
+    {
+        // Nothing may be read back for the digest
+        std::ofstream zeros(path, std::ios::binary | std::ios::trunc);
+        zeros << std::string(size, '\0');
+    }
+    std::string digest;
+    CHECK(hasher.Finish(static_cast<curl_off_t>(size), digest));
+    CHECK_EQ(digest, mock.sha256);
+    std::cout << "Segmented with a 128 KiB reorder buffer took " << seconds << " s" << std::endl;
+
+    server.Stop();
+    CleanupTransfers();
+    return TestResult("transfer_pacing_test");
+}
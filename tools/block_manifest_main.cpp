@@ -0,0 +1,40 @@
+// Companion tool that writes the block manifest used for delta updates.
+// Serve its output next to the binary as "<binary>.blocks.json".
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include "block_manifest.h"
+
+int main(int argc, char* argv[]) {
+    if (argc < 3 || argc > 4) {
+        std::cerr << "Usage: " << argv[0] << " <input file> <output manifest> [block size]" << std::endl;
+        return 1;
+    }
+
+    size_t blockSize = kDefaultManifestBlockSize;
+    if (argc == 4) {
+        blockSize = static_cast<size_t>(std::strtoul(argv[3], nullptr, 10));
+    }
+
+    BlockManifest manifest;
+    if (!BuildBlockManifest(argv[1], blockSize, manifest)) {
+        return 1;
+    }
+
+    std::ofstream file(argv[2], std::ios::trunc);
+    if (!file.is_open()) {
+        std::cerr << "Failed to create manifest: " << argv[2] << std::endl;
+        return 1;
+    }
+    file << SerializeBlockManifest(manifest);
+    file.close();
+    if (!file) {
+        std::cerr << "Failed to write manifest: " << argv[2] << std::endl;
+        return 1;
+    }
+
+    std::cout << "Wrote " << manifest.blocks.size() << " blocks of " << blockSize << " bytes for "
+              << manifest.fileSize << " bytes (sha256 " << manifest.sha256 << ")" << std::endl;
+    return 0;
+}
@@ -0,0 +1,59 @@
+// Exports cookies as the Netscape cookies.txt that --export-cookies hands to
+// yt-dlp, printed to stdout. Takes a browser the way --cookies-from-browser
+// does, or a cookie database directly (e.g. a copy, or one built for testing).
+//
+//   yt_dlp_cookie_export [--domain <domain>]... <browser[:profile]>
+//   yt_dlp_cookie_export [--domain <domain>]... --firefox <cookies.sqlite>
+//   yt_dlp_cookie_export [--domain <domain>]... --chromium <Cookies> [--local-state <file>]
+//
+// Without --domain the cookies of youtube.com and twitch.tv are exported.
+#include <iostream>
+#include <string>
+#include <vector>
+#include "cookie_export.h"
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> domains;
+    std::string browser;
+    CookieSource source;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--domain" && i + 1 < argc) {
+            domains.push_back(argv[++i]);
+        } else if ((arg == "--firefox" || arg == "--chromium") && i + 1 < argc) {
+            source.chromium = arg == "--chromium";
+            source.databasePath = argv[++i];
+            source.browser = source.chromium ? "chromium" : "firefox";
+        } else if (arg == "--local-state" && i + 1 < argc) {
+            source.localStatePath = argv[++i];
+        } else if (arg.compare(0, 2, "--") != 0 && browser.empty()) {
+            browser = arg;
+        } else {
+            browser.clear();
+            source.databasePath.clear();
+            break;
+        }
+    }
+    if (browser.empty() == source.databasePath.empty()) {
+        std::cerr << "Usage: " << argv[0] << " [--domain <domain>]... <browser[:profile]> | --firefox <cookies.sqlite> | "
+                  << "--chromium <Cookies> [--local-state <file>]" << std::endl;
+        return 1;
+    }
+    if (domains.empty()) {
+        domains = DefaultCookieDomains();
+    }
+    if (!browser.empty() && !FindCookieSource(browser, source)) {
+        return 1;
+    }
+
+    std::vector<ExportedCookie> cookies;
+    int undecryptable = 0;
+    if (!ReadCookies(source, domains, cookies, undecryptable)) {
+        return 1;
+    }
+    if (undecryptable > 0) {
+        std::cerr << undecryptable << " cookies couldn't be decrypted and were left out." << std::endl;
+    }
+    std::cout << FormatCookieJar(cookies, source.browser);
+    return 0;
+}